@@ -5,8 +5,6 @@
 
 #include <bitbots_msgs/msg/foot_pressure.hpp>
 #include <bitbots_ros_control/hardware_interface.hpp>
-#include <diagnostic_msgs/msg/diagnostic_array.hpp>
-#include <diagnostic_msgs/msg/diagnostic_status.hpp>
 #include <rclcpp/rclcpp.hpp>
 #include <string>
 
@@ -23,6 +21,8 @@ class BitFootHardwareInterface : public bitbots_ros_control::HardwareInterface {
 
   void write(const rclcpp::Time &t, const rclcpp::Duration &dt);
 
+  void registerDiagnostics(std::shared_ptr<DiagnosticPublisher> diagnostics);
+
  private:
   rclcpp::Node::SharedPtr nh_;
   std::shared_ptr<DynamixelDriver> driver_;
@@ -36,7 +36,7 @@ class BitFootHardwareInterface : public bitbots_ros_control::HardwareInterface {
   std::string topic_name_;
   std::string name_;
   bitbots_msgs::msg::FootPressure msg_;
-  rclcpp::Publisher<diagnostic_msgs::msg::DiagnosticArray>::SharedPtr diagnostic_pub_;
+  std::shared_ptr<DiagnosticPublisher::Status> diagnostic_status_;
   std::array<uint8_t, 16> data_;
 };
 }  // namespace bitbots_ros_control
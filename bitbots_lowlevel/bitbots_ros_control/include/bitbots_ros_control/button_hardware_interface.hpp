@@ -6,8 +6,6 @@
 #include <bitbots_msgs/msg/buttons.hpp>
 #include <bitbots_ros_control/hardware_interface.hpp>
 #include <bitbots_ros_control/utils.hpp>
-#include <diagnostic_msgs/msg/diagnostic_array.hpp>
-#include <diagnostic_msgs/msg/diagnostic_status.hpp>
 #include <hardware_interface/sensor_interface.hpp>
 #include <rclcpp/rclcpp.hpp>
 #include <string>
@@ -22,17 +20,20 @@ class ButtonHardwareInterface : public bitbots_ros_control::HardwareInterface {
   bool init();
   void read(const rclcpp::Time &t, const rclcpp::Duration &dt);
   void write(const rclcpp::Time &t, const rclcpp::Duration &dt);
+  void registerTasks(std::shared_ptr<CycleScheduler> scheduler);
+  void registerDiagnostics(std::shared_ptr<DiagnosticPublisher> diagnostics);
 
  private:
   rclcpp::Node::SharedPtr nh_;
-  int counter_ = 0;
 
   std::shared_ptr<DynamixelDriver> driver_;
   int id_;
   std::string topic_;
   rclcpp::Publisher<bitbots_msgs::msg::Buttons>::SharedPtr button_pub_;
   int read_rate_;
-  rclcpp::Publisher<diagnostic_msgs::msg::DiagnosticArray>::SharedPtr diagnostic_pub_;
+  std::shared_ptr<CycleScheduler> scheduler_;
+  CycleScheduler::TaskId read_task_;
+  std::shared_ptr<DiagnosticPublisher::Status> diagnostic_status_;
   std::array<uint8_t, 3> data_;
 };
 }  // namespace bitbots_ros_control
@@ -5,8 +5,6 @@
 
 #include <bitbots_ros_control/hardware_interface.hpp>
 #include <bitbots_ros_control/utils.hpp>
-#include <diagnostic_msgs/msg/diagnostic_array.hpp>
-#include <diagnostic_msgs/msg/diagnostic_status.hpp>
 #include <rclcpp/rclcpp.hpp>
 #include <std_msgs/msg/bool.hpp>
 #include <std_msgs/msg/float64.hpp>
@@ -29,6 +27,8 @@ class CoreHardwareInterface : public bitbots_ros_control::HardwareInterface {
 
   void write(const rclcpp::Time &t, const rclcpp::Duration &dt);
   void restoreAfterPowerCycle();
+  void registerTasks(std::shared_ptr<CycleScheduler> scheduler);
+  void registerDiagnostics(std::shared_ptr<DiagnosticPublisher> diagnostics);
 
  private:
   rclcpp::Node::SharedPtr nh_;
@@ -39,7 +39,8 @@ class CoreHardwareInterface : public bitbots_ros_control::HardwareInterface {
 
   int id_;
   int read_rate_;
-  int read_counter_;
+  std::shared_ptr<CycleScheduler> scheduler_;
+  CycleScheduler::TaskId read_task_;
   std::array<uint8_t, 27> data_;
 
   bool requested_power_status_;
@@ -53,7 +54,7 @@ class CoreHardwareInterface : public bitbots_ros_control::HardwareInterface {
   std_msgs::msg::Float64 VDXL_;
   std_msgs::msg::Float64 current_;
 
-  rclcpp::Publisher<diagnostic_msgs::msg::DiagnosticArray>::SharedPtr diagnostic_pub_;
+  std::shared_ptr<DiagnosticPublisher::Status> diagnostic_status_;
   rclcpp::Publisher<std_msgs::msg::Bool>::SharedPtr power_pub_;
   rclcpp::Publisher<std_msgs::msg::Float64>::SharedPtr vcc_pub_;
   rclcpp::Publisher<std_msgs::msg::Float64>::SharedPtr vbat_pub_;
@@ -0,0 +1,85 @@
+#ifndef BITBOTS_ROS_CONTROL_INCLUDE_BITBOTS_ROS_CONTROL_CYCLE_SCHEDULER_H_
+#define BITBOTS_ROS_CONTROL_INCLUDE_BITBOTS_ROS_CONTROL_CYCLE_SCHEDULER_H_
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+namespace bitbots_ros_control {
+
+/**
+ * Schedules the bus transactions of one port that are not done in every control cycle.
+ * Each task declares its period in cycles and its estimated bus time. The scheduler assigns each task a phase, so that
+ * the low rate tasks are spread over the cycles and the worst case cycle time stays as low as possible.
+ */
+class CycleScheduler {
+ public:
+  using TaskId = size_t;
+
+  /**
+   * @param baudrate Baudrate of the port, used to estimate the bus time of transactions
+   */
+  explicit CycleScheduler(int baudrate);
+
+  /**
+   * Adds a task, build() has to be called afterwards
+   * @param name Name of the task, used for logging
+   * @param period Number of cycles between two executions of the task
+   * @param cost Estimated bus time of one execution in microseconds
+   */
+  TaskId addTask(const std::string &name, int period, double cost);
+
+  /**
+   * Assigns the phases of all tasks
+   */
+  void build();
+
+  /**
+   * Advances to the next control cycle
+   */
+  void advance();
+
+  /**
+   * Returns true if the task is executed in the current cycle
+   */
+  bool isDue(TaskId task) const;
+
+  /**
+   * Estimated bus time in microseconds of a transaction with the given number of data bytes
+   */
+  double transactionTime(size_t data_bytes) const;
+
+  /**
+   * Highest bus time of the tasks in a single cycle, with the assigned phases and if all tasks started in the same
+   * cycle
+   */
+  double worstCycleCost() const;
+  double unscheduledWorstCycleCost() const;
+
+  /**
+   * Description of the assigned phases, used for logging
+   */
+  std::string describe() const;
+
+ private:
+  struct Task {
+    std::string name;
+    int period;
+    double cost;
+    int phase;
+  };
+
+  // the hyperperiod is capped, so long or coprime periods do not produce huge load tables
+  static constexpr uint64_t MAX_HYPERPERIOD = 10000;
+
+  std::vector<double> cycleCosts(bool scheduled) const;
+
+  int baudrate_;
+  std::vector<Task> tasks_;
+  uint64_t hyperperiod_ = 1;
+  uint64_t cycle_ = 0;
+};
+}  // namespace bitbots_ros_control
+
+#endif  // BITBOTS_ROS_CONTROL_INCLUDE_BITBOTS_ROS_CONTROL_CYCLE_SCHEDULER_H_
@@ -0,0 +1,109 @@
+#ifndef BITBOTS_ROS_CONTROL_INCLUDE_BITBOTS_ROS_CONTROL_DIAGNOSTIC_PUBLISHER_H_
+#define BITBOTS_ROS_CONTROL_INCLUDE_BITBOTS_ROS_CONTROL_DIAGNOSTIC_PUBLISHER_H_
+
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <diagnostic_msgs/msg/diagnostic_array.hpp>
+#include <memory>
+#include <mutex>
+#include <rclcpp/rclcpp.hpp>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace bitbots_ros_control {
+
+/**
+ * Publishes the diagnostics of the hardware interfaces without allocating in the control loop.
+ * Each device registers its statuses with a fixed set of keys during initialization. In the control loop, only
+ * numbers and pointers to constant strings are set and handed to a separate thread through a single-producer queue.
+ * This thread formats the values and publishes all updated statuses on /diagnostics.
+ */
+class DiagnosticPublisher {
+ public:
+  /**
+   * Diagnostic status of one device. The setters and publish() may only be called by one thread at a time.
+   */
+  class Status {
+   public:
+    Status(const std::string &name, const std::string &hardware_id, const std::vector<std::string> &keys);
+
+    /**
+     * @param message Has to stay valid, e.g. a string literal or a string that is created during initialization
+     */
+    void setLevel(uint8_t level, const char *message);
+    void setNumber(size_t key, double value);
+    void setInteger(size_t key, int64_t value);
+    void setText(size_t key, const char *text);
+
+    /**
+     * Hands the current level and values to the publishing thread. Never blocks, the update is dropped if the
+     * thread falls behind.
+     */
+    void publish();
+
+   private:
+    friend class DiagnosticPublisher;
+
+    struct Value {
+      enum class Type { NUMBER, INTEGER, TEXT } type = Type::TEXT;
+      double number = 0;
+      int64_t integer = 0;
+      const char *text = "";
+    };
+    struct Record {
+      uint8_t level = diagnostic_msgs::msg::DiagnosticStatus::STALE;
+      const char *message = "";
+      std::vector<Value> values;
+    };
+    static constexpr size_t QUEUE_SIZE = 4;
+
+    /**
+     * Formats the newest published record into the message, returns false if nothing was published since the last
+     * call. Only called by the publishing thread.
+     */
+    bool takeLatest(diagnostic_msgs::msg::DiagnosticStatus &msg);
+
+    Record current_;
+    // records in [tail_, head_) are published but not yet taken by the publishing thread
+    std::array<Record, QUEUE_SIZE> queue_;
+    std::atomic<size_t> head_{0};
+    std::atomic<size_t> tail_{0};
+    // only used by the publishing thread
+    diagnostic_msgs::msg::DiagnosticStatus msg_;
+  };
+
+  /**
+   * @param period Interval in which the updated statuses are published
+   */
+  DiagnosticPublisher(rclcpp::Node::SharedPtr nh, std::chrono::milliseconds period);
+  ~DiagnosticPublisher();
+
+  DiagnosticPublisher(const DiagnosticPublisher &) = delete;
+  DiagnosticPublisher &operator=(const DiagnosticPublisher &) = delete;
+
+  /**
+   * Registers a status, must not be called in the control loop
+   * @param name Name of the status, prefixed to sort it in the diagnostic analyzer
+   * @param keys Keys of the values, the values are later set by their index in this list
+   */
+  std::shared_ptr<Status> addStatus(const std::string &name, const std::string &hardware_id,
+                                    const std::vector<std::string> &keys = {});
+
+ private:
+  void loop();
+
+  rclcpp::Node::SharedPtr nh_;
+  rclcpp::Publisher<diagnostic_msgs::msg::DiagnosticArray>::SharedPtr diagnostic_pub_;
+  std::chrono::milliseconds period_;
+  // protects the list of statuses, which is not accessed by the control loop
+  std::mutex mutex_;
+  std::vector<std::shared_ptr<Status>> statuses_;
+  diagnostic_msgs::msg::DiagnosticArray array_msg_;
+  std::atomic<bool> stop_{false};
+  std::thread thread_;
+};
+}  // namespace bitbots_ros_control
+
+#endif  // BITBOTS_ROS_CONTROL_INCLUDE_BITBOTS_ROS_CONTROL_DIAGNOSTIC_PUBLISHER_H_
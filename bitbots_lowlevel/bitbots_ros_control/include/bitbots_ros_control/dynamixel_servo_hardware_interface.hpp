@@ -4,6 +4,7 @@
 #include <dynamixel_driver.h>
 
 #include <bitbots_msgs/msg/joint_command.hpp>
+#include <bitbots_msgs/msg/joint_layout.hpp>
 #include <bitbots_msgs/msg/joint_torque.hpp>
 #include <bitbots_ros_control/hardware_interface.hpp>
 #include <bitbots_ros_control/servo_bus_interface.hpp>
@@ -16,6 +17,7 @@
 #include <std_msgs/msg/bool.hpp>
 #include <std_msgs/msg/int32_multi_array.hpp>
 #include <string>
+#include <unordered_map>
 
 namespace bitbots_ros_control {
 template <typename T>
@@ -63,6 +65,11 @@ class DynamixelServoHardwareInterface : public bitbots_ros_control::HardwareInte
   void individualTorqueCb(bitbots_msgs::msg::JointTorque msg);
   void commandCb(const bitbots_msgs::msg::JointCommand &command_msg);
 
+  /**
+   * Returns the joint index of each name, -1 for unknown joints. The result is cached for each distinct name vector.
+   */
+  const std::vector<int> &resolveJointNames(const std::vector<std::string> &names);
+
   std::vector<int32_t> goal_torque_individual_;
 
   ControlMode control_mode_;
@@ -88,6 +95,17 @@ class DynamixelServoHardwareInterface : public bitbots_ros_control::HardwareInte
 
   std::map<std::string, int> joint_map_;
 
+  // Id of the canonical joint layout (the order of joint_names_) and the identity mapping of it
+  uint32_t layout_id_;
+  std::vector<int> layout_indices_;
+
+  // Joint indices for each distinct name vector of the received commands, stored by the hash of the names
+  struct NameLayout {
+    std::vector<std::string> names;
+    std::vector<int> indices;
+  };
+  std::unordered_map<uint32_t, NameLayout> name_layout_cache_;
+
   bool torqueless_mode_;
 
   // subscriber / publisher
@@ -96,6 +114,7 @@ class DynamixelServoHardwareInterface : public bitbots_ros_control::HardwareInte
   rclcpp::Subscription<bitbots_msgs::msg::JointCommand>::SharedPtr sub_command_;
   rclcpp::Publisher<sensor_msgs::msg::JointState>::SharedPtr pwm_pub_;
   rclcpp::Publisher<sensor_msgs::msg::JointState>::SharedPtr joint_pub_;
+  rclcpp::Publisher<bitbots_msgs::msg::JointLayout>::SharedPtr joint_layout_pub_;
 
   sensor_msgs::msg::JointState joint_state_msg_;
   sensor_msgs::msg::JointState pwm_msg_;
@@ -4,6 +4,9 @@
 
 #ifndef BITBOTS_ROS_CONTROL_INCLUDE_BITBOTS_ROS_CONTROL_HARDWARE_INTERFACE_H_
 #define BITBOTS_ROS_CONTROL_INCLUDE_BITBOTS_ROS_CONTROL_HARDWARE_INTERFACE_H_
+#include <bitbots_ros_control/cycle_scheduler.hpp>
+#include <bitbots_ros_control/diagnostic_publisher.hpp>
+#include <memory>
 #include <rclcpp/rclcpp.hpp>
 
 namespace bitbots_ros_control {
@@ -18,6 +21,18 @@ class HardwareInterface {
 
   virtual void restoreAfterPowerCycle(){};
 
+  /**
+   * Registers the bus transactions that are not done in every cycle at the scheduler of the port.
+   * Is called after init().
+   */
+  virtual void registerTasks(std::shared_ptr<CycleScheduler> scheduler){};
+
+  /**
+   * Registers the diagnostic statuses of this interface, so that they can be updated in the control loop without
+   * allocating. Is called after init().
+   */
+  virtual void registerDiagnostics(std::shared_ptr<DiagnosticPublisher> diagnostics){};
+
   virtual ~HardwareInterface(){};
 };
 }  // namespace bitbots_ros_control
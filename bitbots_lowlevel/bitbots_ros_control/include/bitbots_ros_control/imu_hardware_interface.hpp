@@ -26,6 +26,8 @@ class ImuHardwareInterface : public bitbots_ros_control::HardwareInterface {
   void read(const rclcpp::Time &t, const rclcpp::Duration &dt);
   void write(const rclcpp::Time &t, const rclcpp::Duration &dt);
   void restoreAfterPowerCycle();
+  void registerTasks(std::shared_ptr<CycleScheduler> scheduler);
+  void registerDiagnostics(std::shared_ptr<DiagnosticPublisher> diagnostics);
 
  private:
   rclcpp::Node::SharedPtr nh_;
@@ -45,8 +47,6 @@ class ImuHardwareInterface : public bitbots_ros_control::HardwareInterface {
   std::array<double, 3> linear_acceleration_{};
   std::array<double, 9> linear_acceleration_covariance_{};
 
-  diagnostic_msgs::msg::DiagnosticStatus status_imu_;
-
   bool write_ranges_ = false;
   uint8_t gyro_range_, accel_range_;
 
@@ -79,10 +79,11 @@ class ImuHardwareInterface : public bitbots_ros_control::HardwareInterface {
       set_accel_calib_threshold_service_;
 
   rclcpp::Publisher<sensor_msgs::msg::Imu>::SharedPtr imu_pub_;
-  rclcpp::Publisher<diagnostic_msgs::msg::DiagnosticArray>::SharedPtr diagnostic_pub_;
+  std::shared_ptr<DiagnosticPublisher::Status> diagnostic_status_;
   sensor_msgs::msg::Imu imu_msg_;
 
-  int diag_counter_;
+  std::shared_ptr<CycleScheduler> scheduler_;
+  CycleScheduler::TaskId diag_task_;
 
   void setIMURanges(const std::shared_ptr<bitbots_msgs::srv::IMURanges::Request> req,
                     std::shared_ptr<bitbots_msgs::srv::IMURanges::Response> resp);
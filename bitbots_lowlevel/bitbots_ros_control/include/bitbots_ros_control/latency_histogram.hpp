@@ -0,0 +1,70 @@
+#ifndef BITBOTS_ROS_CONTROL_INCLUDE_BITBOTS_ROS_CONTROL_LATENCY_HISTOGRAM_H_
+#define BITBOTS_ROS_CONTROL_INCLUDE_BITBOTS_ROS_CONTROL_LATENCY_HISTOGRAM_H_
+
+#include <array>
+#include <atomic>
+#include <bitbots_ros_control/diagnostic_publisher.hpp>
+#include <chrono>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+namespace bitbots_ros_control {
+
+/**
+ * Histogram of durations in microseconds with logarithmic buckets, similar to an HDR histogram.
+ * Each power of two is divided into 16 buckets, so the relative error of the reported values is below 7%.
+ * Recording is lock-free and does not allocate, it may be done by one thread while another one takes the summaries.
+ */
+class LatencyHistogram {
+ public:
+  /**
+   * Statistics of the values recorded since the last summary, in microseconds
+   */
+  struct Summary {
+    uint64_t count;
+    uint64_t p50;
+    uint64_t p99;
+    uint64_t max;
+  };
+
+  void record(uint64_t microseconds);
+  void record(std::chrono::nanoseconds duration);
+
+  /**
+   * Returns the statistics of the values recorded since the last call. Must only be called by one thread.
+   */
+  Summary takeSummary();
+
+ private:
+  static constexpr int SUB_BUCKET_BITS = 4;
+  static constexpr uint64_t SUB_BUCKETS = 1 << SUB_BUCKET_BITS;
+  // values above 2^(MAX_SHIFT + SUB_BUCKET_BITS + 1) us are counted in the last bucket
+  static constexpr int MAX_SHIFT = 26;
+  static constexpr size_t BUCKET_COUNT = (MAX_SHIFT + 2) * SUB_BUCKETS;
+
+  static size_t bucketIndex(uint64_t value);
+  // highest value that is counted in the bucket
+  static uint64_t bucketValue(size_t index);
+
+  std::array<std::atomic<uint64_t>, BUCKET_COUNT> counts_{};
+  std::atomic<uint64_t> max_{0};
+  // counts at the last summary, only used by the reading thread
+  std::array<uint64_t, BUCKET_COUNT> summarized_counts_{};
+  std::array<uint64_t, BUCKET_COUNT> window_counts_{};
+};
+
+/**
+ * Adds the keys of the values that setTimingValues() sets for the histogram with the given name
+ */
+void appendTimingKeys(std::vector<std::string> &keys, const std::string &name);
+
+/**
+ * Sets the percentiles and the maximum of the summary, starting at the given key
+ * @return The index of the key after the timing values
+ */
+size_t setTimingValues(DiagnosticPublisher::Status &status, size_t first_key,
+                       const LatencyHistogram::Summary &summary);
+}  // namespace bitbots_ros_control
+
+#endif  // BITBOTS_ROS_CONTROL_INCLUDE_BITBOTS_ROS_CONTROL_LATENCY_HISTOGRAM_H_
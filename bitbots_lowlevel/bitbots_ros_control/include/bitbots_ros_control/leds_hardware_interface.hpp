@@ -13,17 +13,21 @@ namespace bitbots_ros_control {
 class LedsHardwareInterface : public bitbots_ros_control::HardwareInterface {
  public:
   LedsHardwareInterface(rclcpp::Node::SharedPtr nh, std::shared_ptr<DynamixelDriver> &driver, uint8_t id,
-                        uint8_t num_leds, uint8_t start_number);
+                        uint8_t num_leds, uint8_t start_number, int write_rate);
 
   bool init();
   void read(const rclcpp::Time &t, const rclcpp::Duration &dt);
   void write(const rclcpp::Time &t, const rclcpp::Duration &dt);
+  void registerTasks(std::shared_ptr<CycleScheduler> scheduler);
 
  private:
   rclcpp::Node::SharedPtr nh_;
   std::shared_ptr<DynamixelDriver> driver_;
   uint8_t id_;
   uint8_t start_number_;
+  int write_rate_;
+  std::shared_ptr<CycleScheduler> scheduler_;
+  CycleScheduler::TaskId write_task_;
 
   bool write_leds_ = false;
   std::vector<std_msgs::msg::ColorRGBA> leds_;
@@ -0,0 +1,115 @@
+#ifndef BITBOTS_ROS_CONTROL_INCLUDE_BITBOTS_ROS_CONTROL_PORT_WORKER_H_
+#define BITBOTS_ROS_CONTROL_INCLUDE_BITBOTS_ROS_CONTROL_PORT_WORKER_H_
+
+#include <bitbots_ros_control/hardware_interface.hpp>
+#include <bitbots_ros_control/latency_histogram.hpp>
+#include <chrono>
+#include <condition_variable>
+#include <memory>
+#include <mutex>
+#include <rclcpp/rclcpp.hpp>
+#include <thread>
+#include <vector>
+
+namespace bitbots_ros_control {
+
+/**
+ * Long-lived worker thread that reads and writes all hardware interfaces on one bus port.
+ * The thread sleeps until it gets a new task, so no threads need to be created in the control loop.
+ */
+class PortWorker {
+ public:
+  /**
+   * @param nh node handle, used for logging
+   * @param interfaces hardware interfaces on this port, in the order in which they are read and written
+   * @param interface_names names of the interfaces, used for the timing diagnostics
+   * @param name name of the port, used for logging
+   * @param cpu_core core to which the thread is pinned, -1 to let the scheduler decide
+   * @param realtime_priority SCHED_FIFO priority of the thread, 0 to keep the default scheduling
+   */
+  PortWorker(rclcpp::Node::SharedPtr nh, std::vector<std::shared_ptr<HardwareInterface>> interfaces,
+             std::vector<std::string> interface_names, const std::string &name, int cpu_core, int realtime_priority);
+
+  ~PortWorker();
+
+  PortWorker(const PortWorker &) = delete;
+  PortWorker &operator=(const PortWorker &) = delete;
+
+  /**
+   * Wakes the worker to read all interfaces on the port. Returns immediately, use wait() to wait for the result.
+   */
+  void startRead(const rclcpp::Time &t, const rclcpp::Duration &dt);
+
+  /**
+   * Wakes the worker to write all interfaces on the port. Returns immediately, use wait() to wait for the result.
+   */
+  void startWrite(const rclcpp::Time &t, const rclcpp::Duration &dt);
+
+  /**
+   * Wakes the worker to write all interfaces and to read them again for the next cycle at read_time.
+   * This lets the write of one cycle and the read of the next cycle overlap with the rest of the control loop.
+   * Reading shortly before the next cycle keeps the values fresh, instead of holding them for a whole period.
+   */
+  void startWriteRead(const rclcpp::Time &t, const rclcpp::Duration &dt,
+                      std::chrono::steady_clock::time_point read_time);
+
+  /**
+   * Blocks until the last started task is finished.
+   */
+  void wait();
+
+  /**
+   * Duration of the last read and write on this port. Only valid after wait().
+   */
+  std::chrono::nanoseconds lastReadDuration() const;
+  std::chrono::nanoseconds lastWriteDuration() const;
+
+  const std::string &name() const;
+
+  /**
+   * Keys of the timing diagnostics of the port and of each interface
+   */
+  std::vector<std::string> timingKeys() const;
+
+  /**
+   * Sets the read and write timing statistics since the last call, in the order of timingKeys()
+   */
+  void setTimingValues(DiagnosticPublisher::Status &status);
+
+ private:
+  enum class Task { NONE, READ, WRITE, WRITE_READ };
+
+  void start(Task task, const rclcpp::Time &t, const rclcpp::Duration &dt,
+             std::chrono::steady_clock::time_point read_time = {});
+  void loop();
+  void runInterfaces(bool write, const rclcpp::Time &t, const rclcpp::Duration &dt);
+  void configureThread();
+
+  rclcpp::Node::SharedPtr nh_;
+  std::vector<std::shared_ptr<HardwareInterface>> interfaces_;
+  std::vector<std::string> interface_names_;
+  std::string name_;
+  int cpu_core_;
+  int realtime_priority_;
+
+  std::mutex mutex_;
+  std::condition_variable task_condition_;
+  std::condition_variable done_condition_;
+  Task task_{Task::NONE};
+  bool stop_{false};
+  rclcpp::Time t_;
+  rclcpp::Duration dt_{0, 0};
+  std::chrono::steady_clock::time_point read_time_;
+  std::chrono::nanoseconds last_read_duration_{0};
+  std::chrono::nanoseconds last_write_duration_{0};
+  // recorded by the worker thread, summarized by the control loop
+  LatencyHistogram read_histogram_;
+  LatencyHistogram write_histogram_;
+  std::vector<std::unique_ptr<LatencyHistogram>> interface_read_histograms_;
+  std::vector<std::unique_ptr<LatencyHistogram>> interface_write_histograms_;
+
+  std::thread thread_;
+};
+}  // namespace bitbots_ros_control
+
+#endif  // BITBOTS_ROS_CONTROL_INCLUDE_BITBOTS_ROS_CONTROL_PORT_WORKER_H_
@@ -0,0 +1,79 @@
+#ifndef BITBOTS_ROS_CONTROL_INCLUDE_BITBOTS_ROS_CONTROL_REGISTER_READ_PLAN_H_
+#define BITBOTS_ROS_CONTROL_INCLUDE_BITBOTS_ROS_CONTROL_REGISTER_READ_PLAN_H_
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+namespace bitbots_ros_control {
+
+/**
+ * Registers of the servos (Dynamixel X series, protocol 2.0) which are read cyclically
+ */
+enum ServoRegister {
+  HARDWARE_ERROR_STATUS,
+  PRESENT_PWM,
+  PRESENT_CURRENT,
+  PRESENT_VELOCITY,
+  PRESENT_POSITION,
+  PRESENT_INPUT_VOLTAGE,
+  PRESENT_TEMPERATURE,
+  SERVO_REGISTER_COUNT
+};
+
+/**
+ * Plans the sync reads of a set of registers and decodes the results.
+ *
+ * Registers which are close to each other in the control table are read in one transaction, reading the bytes in
+ * between is cheaper than another round trip on the bus. The raw register values of all servos are stored per
+ * register, so they can be converted in tight loops.
+ */
+class RegisterReadPlan {
+ public:
+  /**
+   * A contiguous range of the control table that is read with one sync read
+   */
+  struct Block {
+    uint16_t address;
+    uint16_t length;
+    // Registers in this block and their byte offset in the block
+    std::vector<ServoRegister> registers;
+    std::vector<uint16_t> offsets;
+  };
+
+  RegisterReadPlan() = default;
+
+  /**
+   * @param registers Registers which are read
+   * @param max_gap Maximum number of unused bytes between two registers that are read in the same transaction
+   * @param servo_count Number of servos on the bus
+   */
+  RegisterReadPlan(const std::vector<ServoRegister> &registers, uint16_t max_gap, size_t servo_count);
+
+  const std::vector<Block> &blocks() const;
+
+  /**
+   * Decodes the data of a sync read of the given block into the raw register values
+   * @param block Index of the block
+   * @param data Data of the sync read, the servos are concatenated
+   * @return False if the data is too short for all servos, the values are not changed in that case
+   */
+  bool decode(size_t block, const std::vector<uint8_t> &data);
+
+  /**
+   * Returns the raw values of a register for all servos. Values of two bytes are sign extended.
+   */
+  const std::vector<int32_t> &values(ServoRegister reg) const;
+
+  bool contains(ServoRegister reg) const;
+
+ private:
+  std::vector<Block> blocks_;
+  size_t servo_count_ = 0;
+  std::array<bool, SERVO_REGISTER_COUNT> contained_{};
+  std::array<std::vector<int32_t>, SERVO_REGISTER_COUNT> values_;
+};
+}  // namespace bitbots_ros_control
+
+#endif  // BITBOTS_ROS_CONTROL_INCLUDE_BITBOTS_ROS_CONTROL_REGISTER_READ_PLAN_H_
@@ -6,10 +6,9 @@
 #include <bitbots_msgs/msg/audio.hpp>
 #include <bitbots_msgs/msg/joint_torque.hpp>
 #include <bitbots_ros_control/hardware_interface.hpp>
+#include <bitbots_ros_control/register_read_plan.hpp>
 #include <bitbots_ros_control/utils.hpp>
 #include <bitset>
-#include <diagnostic_msgs/msg/diagnostic_array.hpp>
-#include <diagnostic_msgs/msg/diagnostic_status.hpp>
 #include <rcl_interfaces/msg/list_parameters_result.hpp>
 #include <rclcpp/rclcpp.hpp>
 #include <sensor_msgs/msg/joint_state.hpp>
@@ -27,6 +26,8 @@ class ServoBusInterface : public bitbots_ros_control::HardwareInterface {
   void read(const rclcpp::Time &t, const rclcpp::Duration &dt);
   void write(const rclcpp::Time &t, const rclcpp::Duration &dt);
   void restoreAfterPowerCycle();
+  void registerTasks(std::shared_ptr<CycleScheduler> scheduler);
+  void registerDiagnostics(std::shared_ptr<DiagnosticPublisher> diagnostics);
 
   bool loadDynamixels();
   bool writeROMRAM(bool first_time);
@@ -34,8 +35,6 @@ class ServoBusInterface : public bitbots_ros_control::HardwareInterface {
   void syncWritePWM();
 
   void switchDynamixelControlMode();
-  diagnostic_msgs::msg::DiagnosticStatus createServoDiagMsg(int id, char level, std::string message,
-                                                            std::map<std::string, std::string> map, std::string name);
   void processVte(bool success);
 
   bool goal_torque_;
@@ -43,13 +42,12 @@ class ServoBusInterface : public bitbots_ros_control::HardwareInterface {
   void writeTorque(bool enabled);
   void writeTorqueForServos(std::vector<int32_t> torque);
 
-  bool syncReadPositions();
-  bool syncReadVelocities();
-  bool syncReadEfforts();
-  bool syncReadPWMs();
-  bool syncReadAll();
-  bool syncReadVoltageAndTemp();
-  bool syncReadError();
+  /**
+   * Executes the sync reads of the given plan
+   * @param plan The plan, which also stores the read values
+   * @param register_read Is set to true for each register that was read successfully
+   */
+  void syncReadPlan(RegisterReadPlan &plan, std::array<bool, SERVO_REGISTER_COUNT> &register_read);
 
   void syncWritePosition();
   void syncWriteVelocity();
@@ -58,18 +56,18 @@ class ServoBusInterface : public bitbots_ros_control::HardwareInterface {
   void syncWriteProfileAcceleration();
 
   rclcpp::Node::SharedPtr nh_;
-  std::vector<int32_t> data_sync_read_positions_;
-  std::vector<int32_t> data_sync_read_velocities_;
-  std::vector<int32_t> data_sync_read_efforts_;
-  std::vector<int32_t> data_sync_read_pwms_;
-  std::vector<int32_t> data_sync_read_error_;
   std::vector<int32_t> sync_write_goal_position_;
   std::vector<int32_t> sync_write_goal_velocity_;
   std::vector<int32_t> sync_write_profile_velocity_;
   std::vector<int32_t> sync_write_profile_acceleration_;
   std::vector<int32_t> sync_write_goal_current_;
   std::vector<int32_t> sync_write_goal_pwm_;
-  std::vector<uint8_t> sync_read_all_data_;
+  std::vector<uint8_t> sync_read_data_;
+
+  // Sync reads of the registers that are read in every cycle, and of these together with voltage, temperature and
+  // error, which are only read every vt_update_rate_ cycles
+  RegisterReadPlan read_plan_;
+  RegisterReadPlan vte_read_plan_;
 
   bool first_cycle_;
   bool lost_servo_connection_;
@@ -113,15 +111,18 @@ class ServoBusInterface : public bitbots_ros_control::HardwareInterface {
   std::vector<double> current_temperature_;
   std::vector<uint8_t> current_error_;
 
-  int read_vt_counter_;
   int vt_update_rate_;
+  std::shared_ptr<CycleScheduler> scheduler_;
+  CycleScheduler::TaskId vte_task_;
   double warn_temp_;
   double warn_volt_;
   bool torqueless_mode_;
 
   int reading_errors_;
   int reading_successes_;
-  rclcpp::Publisher<diagnostic_msgs::msg::DiagnosticArray>::SharedPtr diagnostic_pub_;
+  // one diagnostic status per servo and the diagnostic message for each value of the error byte
+  std::vector<std::shared_ptr<DiagnosticPublisher::Status>> diagnostic_statuses_;
+  std::array<std::string, 256> error_messages_;
   rclcpp::Publisher<bitbots_msgs::msg::Audio>::SharedPtr speak_pub_;
 };
 }  // namespace bitbots_ros_control
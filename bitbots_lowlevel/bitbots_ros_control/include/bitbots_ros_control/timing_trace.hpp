@@ -0,0 +1,66 @@
+#ifndef BITBOTS_ROS_CONTROL_INCLUDE_BITBOTS_ROS_CONTROL_TIMING_TRACE_H_
+#define BITBOTS_ROS_CONTROL_INCLUDE_BITBOTS_ROS_CONTROL_TIMING_TRACE_H_
+
+#include <atomic>
+#include <cstdint>
+#include <fstream>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace bitbots_ros_control {
+
+/**
+ * Binary trace of the stage durations of each control cycle.
+ * The control loop only copies the durations into a preallocated ring buffer, a separate thread writes them to the
+ * file. If the thread falls behind, records are dropped instead of blocking the control loop.
+ *
+ * File format (little endian):
+ *   header: "BBTT", uint32 version, uint32 field count, for each field a uint32 name length and the name
+ *   records: int64 steady clock time stamp in ns, followed by one uint32 duration in us per field
+ */
+class TimingTrace {
+ public:
+  /**
+   * @param path File to which the trace is written, it is overwritten
+   * @param fields Names of the durations in each record
+   * @param capacity Number of records that can be buffered
+   */
+  TimingTrace(const std::string &path, const std::vector<std::string> &fields, size_t capacity);
+  ~TimingTrace();
+
+  TimingTrace(const TimingTrace &) = delete;
+  TimingTrace &operator=(const TimingTrace &) = delete;
+
+  bool isOpen() const;
+
+  /**
+   * Adds a record with one duration per field. Never blocks, may be called by a single thread.
+   */
+  void push(int64_t stamp, const std::vector<uint32_t> &durations);
+
+  /**
+   * Number of records that were dropped because the buffer was full
+   */
+  uint64_t dropped() const;
+
+ private:
+  static constexpr uint32_t VERSION = 1;
+
+  void writerLoop();
+
+  std::ofstream file_;
+  size_t field_count_;
+  size_t capacity_;
+  std::vector<int64_t> stamps_;
+  std::vector<uint32_t> durations_;
+  // records in [tail_, head_) are buffered, head_ is only written by push() and tail_ only by the writer thread
+  std::atomic<size_t> head_{0};
+  std::atomic<size_t> tail_{0};
+  std::atomic<uint64_t> dropped_{0};
+  std::atomic<bool> stop_{false};
+  std::thread writer_;
+};
+}  // namespace bitbots_ros_control
+
+#endif  // BITBOTS_ROS_CONTROL_INCLUDE_BITBOTS_ROS_CONTROL_TIMING_TRACE_H_
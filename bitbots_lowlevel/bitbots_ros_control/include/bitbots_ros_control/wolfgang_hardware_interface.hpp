@@ -4,12 +4,16 @@
 #include <bitbots_ros_control/bitfoot_hardware_interface.hpp>
 #include <bitbots_ros_control/button_hardware_interface.hpp>
 #include <bitbots_ros_control/core_hardware_interface.hpp>
+#include <bitbots_ros_control/cycle_scheduler.hpp>
+#include <bitbots_ros_control/diagnostic_publisher.hpp>
 #include <bitbots_ros_control/dynamixel_servo_hardware_interface.hpp>
 #include <bitbots_ros_control/hardware_interface.hpp>
 #include <bitbots_ros_control/imu_hardware_interface.hpp>
 #include <bitbots_ros_control/leds_hardware_interface.hpp>
+#include <bitbots_ros_control/port_worker.hpp>
 #include <bitbots_ros_control/utils.hpp>
 #include <rcl_interfaces/msg/list_parameters_result.hpp>
+#include <chrono>
 #include <rclcpp/rclcpp.hpp>
 #include <thread>
 
@@ -25,12 +29,39 @@ class WolfgangHardwareInterface {
 
   void write(const rclcpp::Time &t, const rclcpp::Duration &dt);
 
+  /**
+   * The I/O workers of the ports, which also provide the timing of the last read and write on each port
+   */
+  const std::vector<std::unique_ptr<PortWorker>> &getPortWorkers() const;
+
+  /**
+   * Publisher that is shared by all hardware interfaces to publish diagnostics without allocating in the control loop
+   */
+  std::shared_ptr<DiagnosticPublisher> getDiagnosticPublisher() const;
+
  private:
   bool create_interfaces(std::vector<std::pair<std::string, int>> dxl_devices);
+  void advanceSchedulers();
   rclcpp::Node::SharedPtr nh_;
 
   // two dimensional list of all hardware interfaces, sorted by port
   std::vector<std::vector<std::shared_ptr<bitbots_ros_control::HardwareInterface>>> interfaces_;
+  // names of the hardware interfaces in the same layout, used for the timing diagnostics
+  std::vector<std::vector<std::string>> interface_names_;
+  // names and baudrates of the ports in the same order as the interfaces
+  std::vector<std::string> port_names_;
+  std::vector<int> port_baudrates_;
+  // one scheduler per port that spreads the low rate transactions over the cycles
+  std::vector<std::shared_ptr<CycleScheduler>> schedulers_;
+  std::shared_ptr<DiagnosticPublisher> diagnostics_;
+  // one long-lived I/O thread per port
+  std::vector<std::unique_ptr<PortWorker>> port_workers_;
+  // if true, each port reads the next cycle after its write without waiting for the control loop
+  bool pipelined_cycle_{false};
+  bool pipelined_read_pending_{false};
+  // nominal period of the control loop and start of the current cycle, used to time the pipelined reads
+  std::chrono::nanoseconds cycle_period_{0};
+  std::chrono::steady_clock::time_point cycle_start_;
   DynamixelServoHardwareInterface servo_interface_;
   rclcpp::Publisher<bitbots_msgs::msg::Audio>::SharedPtr speak_pub_;
   std::optional<rclcpp::Time> bus_start_time_;
@@ -12,16 +12,24 @@ ButtonHardwareInterface::ButtonHardwareInterface(rclcpp::Node::SharedPtr nh, std
 
 bool ButtonHardwareInterface::init() {
   button_pub_ = nh_->create_publisher<bitbots_msgs::msg::Buttons>(topic_, 1);
-  diagnostic_pub_ = nh_->create_publisher<diagnostic_msgs::msg::DiagnosticArray>("/diagnostics", 10);
   return true;
 }
 
+void ButtonHardwareInterface::registerTasks(std::shared_ptr<CycleScheduler> scheduler) {
+  scheduler_ = scheduler;
+  read_task_ = scheduler_->addTask("buttons", read_rate_, scheduler_->transactionTime(data_.size()));
+}
+
+void ButtonHardwareInterface::registerDiagnostics(std::shared_ptr<DiagnosticPublisher> diagnostics) {
+  // add prefix BUTTON to sort in diagnostic analyser
+  diagnostic_status_ = diagnostics->addStatus("BUTTONButton", std::to_string(id_));
+}
+
 void ButtonHardwareInterface::read(const rclcpp::Time &t, const rclcpp::Duration &dt) {
   /**
    * Reads the buttons
    */
-  counter_ = (counter_ + 1) % read_rate_;
-  if (counter_ != 0) return;
+  if (!scheduler_->isDue(read_task_)) return;
   bool read_successful = true;
   if (driver_->readMultipleRegisters(id_, 76, 3, data_.data())) {
     bitbots_msgs::msg::Buttons msg;
@@ -35,24 +43,12 @@ void ButtonHardwareInterface::read(const rclcpp::Time &t, const rclcpp::Duration
   }
 
   // diagnostics. check if values are changing, otherwise there is a connection error on the board
-  diagnostic_msgs::msg::DiagnosticArray array_msg = diagnostic_msgs::msg::DiagnosticArray();
-  std::vector<diagnostic_msgs::msg::DiagnosticStatus> array = std::vector<diagnostic_msgs::msg::DiagnosticStatus>();
-  array_msg.header.stamp = nh_->get_clock()->now();
-  diagnostic_msgs::msg::DiagnosticStatus status = diagnostic_msgs::msg::DiagnosticStatus();
-  // add prefix CORE to sort in diagnostic analyser
-  status.name = "BUTTONButton";
-  status.hardware_id = std::to_string(id_);
-
   if (read_successful) {
-    status.level = diagnostic_msgs::msg::DiagnosticStatus::OK;
-    status.message = "OK";
+    diagnostic_status_->setLevel(diagnostic_msgs::msg::DiagnosticStatus::OK, "OK");
   } else {
-    status.level = diagnostic_msgs::msg::DiagnosticStatus::STALE;
-    status.message = "No response";
+    diagnostic_status_->setLevel(diagnostic_msgs::msg::DiagnosticStatus::STALE, "No response");
   }
-  array.push_back(status);
-  array_msg.status = array;
-  diagnostic_pub_->publish(array_msg);
+  diagnostic_status_->publish();
 }
 
 // we don't write anything to the buttons
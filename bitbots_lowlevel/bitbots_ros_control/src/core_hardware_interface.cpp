@@ -8,7 +8,6 @@ CoreHardwareInterface::CoreHardwareInterface(rclcpp::Node::SharedPtr nh, std::sh
   driver_ = driver;
   id_ = id;
   read_rate_ = read_rate;
-  read_counter_ = 0;
   requested_power_status_ = true;
   power_switch_status_.data = false;
   power_control_status_.data = false;
@@ -33,8 +32,6 @@ bool CoreHardwareInterface::init() {
   vdxl_pub_ = nh_->create_publisher<std_msgs::msg::Float64>("/core/vdxl", 1);
   current_pub_ = nh_->create_publisher<std_msgs::msg::Float64>("/core/current", 1);
 
-  diagnostic_pub_ = nh_->create_publisher<diagnostic_msgs::msg::DiagnosticArray>("/diagnostics", 10);
-
   // service to switch power
   power_switch_service_ = nh_->create_service<std_srvs::srv::SetBool>(
       "/core/switch_power",
@@ -42,6 +39,18 @@ bool CoreHardwareInterface::init() {
   return true;
 }
 
+void CoreHardwareInterface::registerTasks(std::shared_ptr<CycleScheduler> scheduler) {
+  scheduler_ = scheduler;
+  read_task_ = scheduler_->addTask("core", read_rate_, scheduler_->transactionTime(data_.size()));
+}
+
+void CoreHardwareInterface::registerDiagnostics(std::shared_ptr<DiagnosticPublisher> diagnostics) {
+  // add prefix CORE to sort in diagnostic analyser
+  diagnostic_status_ = diagnostics->addStatus(
+      "CORECORE", std::to_string(id_),
+      {"power_switch_status", "power_control_status", "VCC", "VBAT", "VEXT", "VDXL", "Current"});
+}
+
 bool CoreHardwareInterface::get_power_status() {
   // this is only true when the physical switch and the soft status are true
   return power_control_status_.data && power_switch_status_.data;
@@ -52,8 +61,7 @@ void CoreHardwareInterface::read(const rclcpp::Time &t, const rclcpp::Duration &
    * Reads the CORE board
    */
 
-  if (read_counter_ % read_rate_ == 0) {
-    read_counter_ = 0;
+  if (scheduler_->isDue(read_task_)) {
     // read core
     last_read_successful_ = true;
     if (driver_->readMultipleRegisters(id_, 23, 27, data_.data())) {
@@ -94,52 +102,21 @@ void CoreHardwareInterface::read(const rclcpp::Time &t, const rclcpp::Duration &
     }
 
     // diagnostics. check if values are changing, otherwise there is a connection error on the board
-    diagnostic_msgs::msg::DiagnosticArray array_msg = diagnostic_msgs::msg::DiagnosticArray();
-    std::vector<diagnostic_msgs::msg::DiagnosticStatus> array = std::vector<diagnostic_msgs::msg::DiagnosticStatus>();
-    array_msg.header.stamp = nh_->get_clock()->now();
-    diagnostic_msgs::msg::DiagnosticStatus status = diagnostic_msgs::msg::DiagnosticStatus();
-    // add prefix CORE to sort in diagnostic analyser
-    status.name = "CORECORE";
-    status.hardware_id = std::to_string(id_);
-    std::map<std::string, std::string> map;
-
-    if (power_switch_status_.data) {
-      map.insert(std::make_pair("power_switch_status", "ON"));
-    } else {
-      map.insert(std::make_pair("power_switch_status", "OFF"));
-    }
-    if (power_control_status_.data) {
-      map.insert(std::make_pair("power_control_status", "ON"));
-    } else {
-      map.insert(std::make_pair("power_control_status", "OFF"));
-    }
-    map.insert(std::make_pair("VCC", std::to_string(VCC_.data)));
-    map.insert(std::make_pair("VBAT", std::to_string(VBAT_.data)));
-    map.insert(std::make_pair("VEXT", std::to_string(VEXT_.data)));
-    map.insert(std::make_pair("VDXL", std::to_string(VDXL_.data)));
-    map.insert(std::make_pair("Current", std::to_string(current_.data)));
+    diagnostic_status_->setText(0, power_switch_status_.data ? "ON" : "OFF");
+    diagnostic_status_->setText(1, power_control_status_.data ? "ON" : "OFF");
+    diagnostic_status_->setNumber(2, VCC_.data);
+    diagnostic_status_->setNumber(3, VBAT_.data);
+    diagnostic_status_->setNumber(4, VEXT_.data);
+    diagnostic_status_->setNumber(5, VDXL_.data);
+    diagnostic_status_->setNumber(6, current_.data);
 
     if (last_read_successful_) {
-      status.level = diagnostic_msgs::msg::DiagnosticStatus::OK;
-      status.message = "OK";
+      diagnostic_status_->setLevel(diagnostic_msgs::msg::DiagnosticStatus::OK, "OK");
     } else {
-      status.level = diagnostic_msgs::msg::DiagnosticStatus::STALE;
-      status.message = "No response";
-    }
-    std::vector<diagnostic_msgs::msg::KeyValue> keyValues = std::vector<diagnostic_msgs::msg::KeyValue>();
-    // iterate through map and save it into values
-    for (auto const &ent1 : map) {
-      diagnostic_msgs::msg::KeyValue key_value = diagnostic_msgs::msg::KeyValue();
-      key_value.key = ent1.first;
-      key_value.value = ent1.second;
-      keyValues.push_back(key_value);
+      diagnostic_status_->setLevel(diagnostic_msgs::msg::DiagnosticStatus::STALE, "No response");
     }
-    status.values = keyValues;
-    array.push_back(status);
-    array_msg.status = array;
-    diagnostic_pub_->publish(array_msg);
+    diagnostic_status_->publish();
   }
-  read_counter_++;
 }
 
 void CoreHardwareInterface::write(const rclcpp::Time &t, const rclcpp::Duration &dt) {
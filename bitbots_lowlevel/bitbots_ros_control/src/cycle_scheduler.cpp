@@ -0,0 +1,93 @@
+#include <algorithm>
+#include <bitbots_ros_control/cycle_scheduler.hpp>
+#include <numeric>
+
+namespace bitbots_ros_control {
+
+namespace {
+// bytes of the instruction and status packet of a protocol 2 transaction without the data
+constexpr size_t PACKET_OVERHEAD_BYTES = 25;
+// time between the end of the instruction and the start of the status packet in microseconds
+constexpr double TURNAROUND_TIME = 50;
+// a byte on the bus consists of a start bit, 8 data bits and a stop bit
+constexpr double BITS_PER_BYTE = 10;
+}  // namespace
+
+CycleScheduler::CycleScheduler(int baudrate) : baudrate_(baudrate) {}
+
+CycleScheduler::TaskId CycleScheduler::addTask(const std::string &name, int period, double cost) {
+  tasks_.push_back({name, std::max(period, 1), cost, 0});
+  return tasks_.size() - 1;
+}
+
+void CycleScheduler::build() {
+  hyperperiod_ = 1;
+  for (const Task &task : tasks_) {
+    hyperperiod_ = std::min<uint64_t>(std::lcm<uint64_t>(hyperperiod_, task.period), MAX_HYPERPERIOD);
+  }
+
+  // place the most expensive tasks first, each one in the phase with the lowest peak load so far
+  std::vector<size_t> order(tasks_.size());
+  std::iota(order.begin(), order.end(), 0);
+  std::stable_sort(order.begin(), order.end(), [this](size_t a, size_t b) { return tasks_[a].cost > tasks_[b].cost; });
+  std::vector<double> load(hyperperiod_, 0);
+  for (size_t index : order) {
+    Task &task = tasks_[index];
+    double best_peak = -1;
+    for (int phase = 0; phase < task.period && static_cast<uint64_t>(phase) < hyperperiod_; phase++) {
+      double peak = 0;
+      for (uint64_t cycle = phase; cycle < hyperperiod_; cycle += task.period) {
+        peak = std::max(peak, load[cycle]);
+      }
+      if (best_peak < 0 || peak < best_peak) {
+        best_peak = peak;
+        task.phase = phase;
+      }
+    }
+    for (uint64_t cycle = task.phase; cycle < hyperperiod_; cycle += task.period) {
+      load[cycle] += task.cost;
+    }
+  }
+}
+
+void CycleScheduler::advance() { cycle_++; }
+
+bool CycleScheduler::isDue(TaskId task) const {
+  return cycle_ % tasks_[task].period == static_cast<uint64_t>(tasks_[task].phase);
+}
+
+double CycleScheduler::transactionTime(size_t data_bytes) const {
+  return (data_bytes + PACKET_OVERHEAD_BYTES) * BITS_PER_BYTE * 1e6 / baudrate_ + TURNAROUND_TIME;
+}
+
+std::vector<double> CycleScheduler::cycleCosts(bool scheduled) const {
+  std::vector<double> load(hyperperiod_, 0);
+  for (const Task &task : tasks_) {
+    for (uint64_t cycle = scheduled ? task.phase : 0; cycle < hyperperiod_; cycle += task.period) {
+      load[cycle] += task.cost;
+    }
+  }
+  return load;
+}
+
+double CycleScheduler::worstCycleCost() const {
+  std::vector<double> load = cycleCosts(true);
+  return load.empty() ? 0 : *std::max_element(load.begin(), load.end());
+}
+
+double CycleScheduler::unscheduledWorstCycleCost() const {
+  std::vector<double> load = cycleCosts(false);
+  return load.empty() ? 0 : *std::max_element(load.begin(), load.end());
+}
+
+std::string CycleScheduler::describe() const {
+  std::string description;
+  for (const Task &task : tasks_) {
+    if (!description.empty()) {
+      description += ", ";
+    }
+    description += task.name + " " + std::to_string(task.phase) + "/" + std::to_string(task.period);
+  }
+  return description;
+}
+}  // namespace bitbots_ros_control
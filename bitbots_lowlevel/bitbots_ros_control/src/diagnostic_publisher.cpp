@@ -0,0 +1,121 @@
+#include <algorithm>
+#include <bitbots_ros_control/diagnostic_publisher.hpp>
+
+namespace bitbots_ros_control {
+
+DiagnosticPublisher::Status::Status(const std::string &name, const std::string &hardware_id,
+                                    const std::vector<std::string> &keys) {
+  current_.values.resize(keys.size());
+  for (Record &record : queue_) {
+    record.values.resize(keys.size());
+  }
+  msg_.name = name;
+  msg_.hardware_id = hardware_id;
+  msg_.values.resize(keys.size());
+  for (size_t i = 0; i < keys.size(); i++) {
+    msg_.values[i].key = keys[i];
+  }
+}
+
+void DiagnosticPublisher::Status::setLevel(uint8_t level, const char *message) {
+  current_.level = level;
+  current_.message = message;
+}
+
+void DiagnosticPublisher::Status::setNumber(size_t key, double value) {
+  current_.values[key].type = Value::Type::NUMBER;
+  current_.values[key].number = value;
+}
+
+void DiagnosticPublisher::Status::setInteger(size_t key, int64_t value) {
+  current_.values[key].type = Value::Type::INTEGER;
+  current_.values[key].integer = value;
+}
+
+void DiagnosticPublisher::Status::setText(size_t key, const char *text) {
+  current_.values[key].type = Value::Type::TEXT;
+  current_.values[key].text = text;
+}
+
+void DiagnosticPublisher::Status::publish() {
+  size_t head = head_.load(std::memory_order_relaxed);
+  if (head - tail_.load(std::memory_order_acquire) >= QUEUE_SIZE) {
+    return;
+  }
+  // the vectors have the same size, so this only copies the values
+  queue_[head % QUEUE_SIZE].level = current_.level;
+  queue_[head % QUEUE_SIZE].message = current_.message;
+  std::copy(current_.values.begin(), current_.values.end(), queue_[head % QUEUE_SIZE].values.begin());
+  head_.store(head + 1, std::memory_order_release);
+}
+
+bool DiagnosticPublisher::Status::takeLatest(diagnostic_msgs::msg::DiagnosticStatus &msg) {
+  size_t tail = tail_.load(std::memory_order_relaxed);
+  size_t head = head_.load(std::memory_order_acquire);
+  if (tail == head) {
+    return false;
+  }
+  // older records are skipped, the producer does not write the newest one until tail_ is advanced past it
+  const Record &record = queue_[(head - 1) % QUEUE_SIZE];
+  msg_.level = record.level;
+  msg_.message = record.message;
+  for (size_t i = 0; i < record.values.size(); i++) {
+    const Value &value = record.values[i];
+    switch (value.type) {
+      case Value::Type::NUMBER:
+        msg_.values[i].value = std::to_string(value.number);
+        break;
+      case Value::Type::INTEGER:
+        msg_.values[i].value = std::to_string(value.integer);
+        break;
+      case Value::Type::TEXT:
+        msg_.values[i].value = value.text;
+        break;
+    }
+  }
+  tail_.store(head, std::memory_order_release);
+  msg = msg_;
+  return true;
+}
+
+DiagnosticPublisher::DiagnosticPublisher(rclcpp::Node::SharedPtr nh, std::chrono::milliseconds period)
+    : nh_(nh), period_(period) {
+  diagnostic_pub_ = nh_->create_publisher<diagnostic_msgs::msg::DiagnosticArray>("/diagnostics", 10);
+  thread_ = std::thread(&DiagnosticPublisher::loop, this);
+}
+
+DiagnosticPublisher::~DiagnosticPublisher() {
+  stop_ = true;
+  thread_.join();
+}
+
+std::shared_ptr<DiagnosticPublisher::Status> DiagnosticPublisher::addStatus(const std::string &name,
+                                                                            const std::string &hardware_id,
+                                                                            const std::vector<std::string> &keys) {
+  auto status = std::make_shared<Status>(name, hardware_id, keys);
+  std::lock_guard<std::mutex> lock(mutex_);
+  statuses_.push_back(status);
+  return status;
+}
+
+void DiagnosticPublisher::loop() {
+  while (!stop_) {
+    std::this_thread::sleep_for(period_);
+    {
+      std::lock_guard<std::mutex> lock(mutex_);
+      array_msg_.status.resize(statuses_.size());
+      size_t updated = 0;
+      for (std::shared_ptr<Status> &status : statuses_) {
+        if (status->takeLatest(array_msg_.status[updated])) {
+          updated++;
+        }
+      }
+      array_msg_.status.resize(updated);
+    }
+    if (!array_msg_.status.empty()) {
+      array_msg_.header.stamp = nh_->get_clock()->now();
+      diagnostic_pub_->publish(array_msg_);
+    }
+  }
+}
+}  // namespace bitbots_ros_control
@@ -3,11 +3,30 @@
 
 #include <bitbots_ros_control/dynamixel_servo_hardware_interface.hpp>
 #include <bitbots_ros_control/utils.hpp>
+#include <numeric>
 #include <utility>
 
 namespace bitbots_ros_control {
 using std::placeholders::_1;
 
+// Maximum number of distinct joint name vectors that are cached
+static constexpr size_t MAX_CACHED_NAME_LAYOUTS = 64;
+
+/**
+ * FNV-1a hash of the joint names, which is used as id of a joint layout
+ */
+static uint32_t hashJointNames(const std::vector<std::string> &names) {
+  uint32_t hash = 2166136261u;
+  for (const std::string &name : names) {
+    for (char c : name) {
+      hash = (hash ^ static_cast<uint8_t>(c)) * 16777619u;
+    }
+    // Separate the names, so different splits of the same characters differ
+    hash = hash * 16777619u;
+  }
+  return hash;
+}
+
 DynamixelServoHardwareInterface::DynamixelServoHardwareInterface(rclcpp::Node::SharedPtr nh) { nh_ = nh; }
 
 void DynamixelServoHardwareInterface::addBusInterface(std::shared_ptr<ServoBusInterface> bus) {
@@ -66,6 +85,17 @@ bool DynamixelServoHardwareInterface::init() {
     joint_map_[joint_names_[i]] = i;
   }
 
+  // Publish the canonical joint order once, commands in this layout skip the name resolution
+  layout_id_ = std::max<uint32_t>(1, hashJointNames(joint_names_));
+  layout_indices_.resize(joint_count_);
+  std::iota(layout_indices_.begin(), layout_indices_.end(), 0);
+  joint_layout_pub_ = nh_->create_publisher<bitbots_msgs::msg::JointLayout>(
+      "/DynamixelController/joint_layout", rclcpp::QoS(rclcpp::KeepLast(1)).transient_local());
+  bitbots_msgs::msg::JointLayout layout_msg;
+  layout_msg.layout_id = layout_id_;
+  layout_msg.joint_names = joint_names_;
+  joint_layout_pub_->publish(layout_msg);
+
   // read lower and upper limits
   robot_model_loader::RobotModelLoader rml(nh_, "robot_description", false);
   moveit::core::RobotModelPtr model = rml.getModel();
@@ -74,8 +104,8 @@ bool DynamixelServoHardwareInterface::init() {
   for (const std::string &joint_name : joint_names_) {
     moveit::core::JointModel *jm = model->getJointModel(joint_name);
     // we use getVariableBounds()[0] because there is only a single variable for all of our joints
-    lower_joint_limits_[joint_map_[joint_name]] = jm->getVariableBounds()[0].min_position_;
-    upper_joint_limits_[joint_map_[joint_name]] = jm->getVariableBounds()[0].max_position_;
+    lower_joint_limits_[joint_map_.at(joint_name)] = jm->getVariableBounds()[0].min_position_;
+    upper_joint_limits_[joint_map_.at(joint_name)] = jm->getVariableBounds()[0].max_position_;
   }
 
   std::string control_mode;
@@ -95,19 +125,55 @@ bool DynamixelServoHardwareInterface::init() {
   return true;
 }
 
+const std::vector<int> &DynamixelServoHardwareInterface::resolveJointNames(const std::vector<std::string> &names) {
+  uint32_t hash = hashJointNames(names);
+  auto cached = name_layout_cache_.find(hash);
+  if (cached != name_layout_cache_.end() && cached->second.names == names) {
+    return cached->second.indices;
+  }
+
+  // Build the mapping for this name vector, the cache is bounded in case of arbitrary senders
+  if (name_layout_cache_.size() >= MAX_CACHED_NAME_LAYOUTS) {
+    name_layout_cache_.clear();
+  }
+  NameLayout &layout = name_layout_cache_[hash];
+  layout.names = names;
+  layout.indices.resize(names.size());
+  for (size_t i = 0; i < names.size(); i++) {
+    auto joint = joint_map_.find(names[i]);
+    if (joint == joint_map_.end()) {
+      RCLCPP_WARN(nh_->get_logger(), "Dynamixel Controller got command for unknown joint %s", names[i].c_str());
+      layout.indices[i] = -1;
+    } else {
+      layout.indices[i] = joint->second;
+    }
+  }
+  return layout.indices;
+}
+
 void DynamixelServoHardwareInterface::commandCb(const bitbots_msgs::msg::JointCommand &command_msg) {
-  if (!(command_msg.joint_names.size() == command_msg.positions.size() &&
-        command_msg.joint_names.size() == command_msg.velocities.size() &&
-        command_msg.joint_names.size() == command_msg.accelerations.size() &&
-        command_msg.joint_names.size() == command_msg.max_currents.size())) {
+  bool own_layout = command_msg.layout_id != 0 && command_msg.layout_id == layout_id_;
+  if (!own_layout && command_msg.layout_id != 0 && command_msg.joint_names.empty()) {
+    RCLCPP_ERROR(nh_->get_logger(), "Dynamixel Controller got command with unknown joint layout %u.",
+                 command_msg.layout_id);
+    return;
+  }
+  // Use the canonical joint order if the command is in our layout, otherwise resolve the joint names
+  const std::vector<int> &joint_ids = own_layout ? layout_indices_ : resolveJointNames(command_msg.joint_names);
+  size_t count = joint_ids.size();
+  if (!(command_msg.positions.size() == count && command_msg.velocities.size() == count &&
+        command_msg.accelerations.size() == count && command_msg.max_currents.size() == count)) {
     RCLCPP_ERROR(nh_->get_logger(), "Dynamixel Controller got command with inconsistent array lengths.");
     return;
   }
-  for (unsigned int i = 0; i < command_msg.joint_names.size(); i++) {
-    int joint_id = joint_map_[command_msg.joint_names[i]];
+  for (size_t i = 0; i < count; i++) {
+    int joint_id = joint_ids[i];
+    if (joint_id < 0) {
+      continue;
+    }
     if (command_msg.positions[i] > upper_joint_limits_[joint_id] ||
         command_msg.positions[i] < lower_joint_limits_[joint_id]) {
-      RCLCPP_WARN_STREAM(nh_->get_logger(), "Invalid position for " << command_msg.joint_names[i] << ": "
+      RCLCPP_WARN_STREAM(nh_->get_logger(), "Invalid position for " << joint_names_[joint_id] << ": "
                                                                     << command_msg.positions[i] << " not in ("
                                                                     << lower_joint_limits_[joint_id] << ", "
                                                                     << upper_joint_limits_[joint_id] << ")");
@@ -15,15 +15,11 @@ ImuHardwareInterface::ImuHardwareInterface(rclcpp::Node::SharedPtr nh, std::shar
   topic_ = topic;
   frame_ = frame;
   name_ = name;
-  diag_counter_ = 0;
   imu_msg_ = sensor_msgs::msg::Imu();
   imu_msg_.header.frame_id = frame_;
 }
 
 bool ImuHardwareInterface::init() {
-  status_imu_.name = name_;
-  status_imu_.hardware_id = std::to_string(id_);
-
   // make services
   imu_ranges_service_ = nh_->create_service<bitbots_msgs::srv::IMURanges>(
       "/imu/set_imu_ranges", std::bind(&ImuHardwareInterface::setIMURanges, this, _1, _2));
@@ -45,7 +41,6 @@ bool ImuHardwareInterface::init() {
       std::bind(&ImuHardwareInterface::setAccelCalibrationThreshold, this, _1, _2));
 
   imu_pub_ = nh_->create_publisher<sensor_msgs::msg::Imu>(topic_, 10);
-  diagnostic_pub_ = nh_->create_publisher<diagnostic_msgs::msg::DiagnosticArray>("/diagnostics", 10);
 
   // read the current values in the IMU module so that they can later be displayed in diagnostic message
   const std::shared_ptr<bitbots_msgs::srv::AccelerometerCalibration::Request> req =
@@ -78,6 +73,21 @@ bool ImuHardwareInterface::init() {
   return true;
 }
 
+void ImuHardwareInterface::registerTasks(std::shared_ptr<CycleScheduler> scheduler) {
+  scheduler_ = scheduler;
+  // the diagnostics do not use the bus, but are spread over the cycles to keep the cycle time flat
+  diag_task_ = scheduler_->addTask("imu_diagnostics", 100, 0);
+}
+
+void ImuHardwareInterface::registerDiagnostics(std::shared_ptr<DiagnosticPublisher> diagnostics) {
+  // add prefix IMU to sort in diagnostic analyser
+  diagnostic_status_ = diagnostics->addStatus(
+      "IMU" + name_, std::to_string(id_),
+      {"Gyro Range", "Accel Range", "Accel Gain", "Bias Alpha", "Adaptive Gain", "Bias Estimation",
+       "Accel Calib Thresh", "Accel Calib Bias 0", "Accel Calib Bias 1", "Accel Calib Bias 2", "Accel Calib Scale 0",
+       "Accel Calib Scale 1", "Accel Calib Scale 2"});
+}
+
 void ImuHardwareInterface::read(const rclcpp::Time &t, const rclcpp::Duration &dt) {
   /**
    * Reads the IMU
@@ -120,53 +130,27 @@ void ImuHardwareInterface::read(const rclcpp::Time &t, const rclcpp::Duration &d
   imu_pub_->publish(imu_msg_);
 
   // publish diagnostic messages each 100 frames
-  if (diag_counter_ % 100 == 0) {
+  if (scheduler_->isDue(diag_task_)) {
     // diagnostics. check if values are changing, otherwise there is a connection error on the board
-    diagnostic_msgs::msg::DiagnosticArray array_msg = diagnostic_msgs::msg::DiagnosticArray();
-    std::vector<diagnostic_msgs::msg::DiagnosticStatus> array = std::vector<diagnostic_msgs::msg::DiagnosticStatus>();
-    array_msg.header.stamp = nh_->get_clock()->now();
-    diagnostic_msgs::msg::DiagnosticStatus status = diagnostic_msgs::msg::DiagnosticStatus();
-    // add prefix CORE to sort in diagnostic analyser
-    status.name = "IMU" + name_;
-    status.hardware_id = std::to_string(id_);
-    std::map<std::string, std::string> map;
-
-    map.insert(std::make_pair("Gyro Range", std::to_string(gyro_range_)));
-    map.insert(std::make_pair("Accel Range", std::to_string(accel_range_)));
-    map.insert(std::make_pair("Accel Gain", std::to_string(accel_gain_)));
-    map.insert(std::make_pair("Bias Alpha", std::to_string(bias_alpha_)));
-    map.insert(std::make_pair("Adaptive Gain", std::to_string(do_adaptive_gain_)));
-    map.insert(std::make_pair("Bias Estimation", std::to_string(do_bias_estimation_)));
-    map.insert(std::make_pair("Adaptive Gain", std::to_string(do_adaptive_gain_)));
-    map.insert(std::make_pair("Accel Calib Thresh", std::to_string(accel_calib_threshold_read_)));
-    map.insert(std::make_pair("Accel Calib Bias 0", std::to_string(accel_calib_bias_[0])));
-    map.insert(std::make_pair("Accel Calib Bias 1", std::to_string(accel_calib_bias_[1])));
-    map.insert(std::make_pair("Accel Calib Bias 2", std::to_string(accel_calib_bias_[2])));
-    map.insert(std::make_pair("Accel Calib Scale 0", std::to_string(accel_calib_scale_[0])));
-    map.insert(std::make_pair("Accel Calib Scale 1", std::to_string(accel_calib_scale_[1])));
-    map.insert(std::make_pair("Accel Calib Scale 2", std::to_string(accel_calib_scale_[2])));
+    diagnostic_status_->setInteger(0, gyro_range_);
+    diagnostic_status_->setInteger(1, accel_range_);
+    diagnostic_status_->setNumber(2, accel_gain_);
+    diagnostic_status_->setNumber(3, bias_alpha_);
+    diagnostic_status_->setInteger(4, do_adaptive_gain_);
+    diagnostic_status_->setInteger(5, do_bias_estimation_);
+    diagnostic_status_->setNumber(6, accel_calib_threshold_read_);
+    for (int i = 0; i < 3; i++) {
+      diagnostic_status_->setNumber(7 + i, accel_calib_bias_[i]);
+      diagnostic_status_->setNumber(10 + i, accel_calib_scale_[i]);
+    }
 
     if (read_successful) {
-      status.level = diagnostic_msgs::msg::DiagnosticStatus::OK;
-      status.message = "OK";
+      diagnostic_status_->setLevel(diagnostic_msgs::msg::DiagnosticStatus::OK, "OK");
     } else {
-      status.level = diagnostic_msgs::msg::DiagnosticStatus::STALE;
-      status.message = "No response";
-    }
-    std::vector<diagnostic_msgs::msg::KeyValue> keyValues = std::vector<diagnostic_msgs::msg::KeyValue>();
-    // itarate through map and save it into values
-    for (auto const &ent1 : map) {
-      diagnostic_msgs::msg::KeyValue key_value = diagnostic_msgs::msg::KeyValue();
-      key_value.key = ent1.first;
-      key_value.value = ent1.second;
-      keyValues.push_back(key_value);
+      diagnostic_status_->setLevel(diagnostic_msgs::msg::DiagnosticStatus::STALE, "No response");
     }
-    status.values = keyValues;
-    array.push_back(status);
-    array_msg.status = array;
-    diagnostic_pub_->publish(array_msg);
+    diagnostic_status_->publish();
   }
-  diag_counter_++;
 }
 
 void ImuHardwareInterface::setIMURanges(const std::shared_ptr<bitbots_msgs::srv::IMURanges::Request> req,
@@ -0,0 +1,82 @@
+#include <algorithm>
+#include <bitbots_ros_control/latency_histogram.hpp>
+
+namespace bitbots_ros_control {
+
+void LatencyHistogram::record(uint64_t microseconds) {
+  counts_[bucketIndex(microseconds)].fetch_add(1, std::memory_order_relaxed);
+  uint64_t max = max_.load(std::memory_order_relaxed);
+  while (microseconds > max && !max_.compare_exchange_weak(max, microseconds, std::memory_order_relaxed)) {
+  }
+}
+
+void LatencyHistogram::record(std::chrono::nanoseconds duration) {
+  record(static_cast<uint64_t>(std::max<int64_t>(0, duration.count() / 1000)));
+}
+
+LatencyHistogram::Summary LatencyHistogram::takeSummary() {
+  Summary summary{0, 0, 0, max_.exchange(0, std::memory_order_relaxed)};
+  for (size_t i = 0; i < BUCKET_COUNT; i++) {
+    uint64_t count = counts_[i].load(std::memory_order_relaxed);
+    window_counts_[i] = count - summarized_counts_[i];
+    summarized_counts_[i] = count;
+    summary.count += window_counts_[i];
+  }
+  if (summary.count == 0) {
+    return summary;
+  }
+
+  // smallest bucket values below which at least the given share of the values lies
+  uint64_t p50_rank = (summary.count * 50 + 99) / 100;
+  uint64_t p99_rank = (summary.count * 99 + 99) / 100;
+  uint64_t cumulative = 0;
+  bool p50_found = false;
+  for (size_t i = 0; i < BUCKET_COUNT; i++) {
+    cumulative += window_counts_[i];
+    if (!p50_found && cumulative >= p50_rank) {
+      summary.p50 = std::min(bucketValue(i), summary.max);
+      p50_found = true;
+    }
+    if (cumulative >= p99_rank) {
+      summary.p99 = std::min(bucketValue(i), summary.max);
+      break;
+    }
+  }
+  return summary;
+}
+
+size_t LatencyHistogram::bucketIndex(uint64_t value) {
+  if (value < 2 * SUB_BUCKETS) {
+    return value;
+  }
+  // position of the highest set bit, values are shifted so that SUB_BUCKET_BITS + 1 bits remain
+  int shift = 63 - __builtin_clzll(value) - SUB_BUCKET_BITS;
+  if (shift > MAX_SHIFT) {
+    return BUCKET_COUNT - 1;
+  }
+  return (shift + 1) * SUB_BUCKETS + ((value >> shift) - SUB_BUCKETS);
+}
+
+uint64_t LatencyHistogram::bucketValue(size_t index) {
+  if (index < 2 * SUB_BUCKETS) {
+    return index;
+  }
+  int shift = index / SUB_BUCKETS - 1;
+  uint64_t mantissa = SUB_BUCKETS + index % SUB_BUCKETS;
+  return ((mantissa + 1) << shift) - 1;
+}
+
+void appendTimingKeys(std::vector<std::string> &keys, const std::string &name) {
+  keys.push_back(name + " p50 [us]");
+  keys.push_back(name + " p99 [us]");
+  keys.push_back(name + " max [us]");
+}
+
+size_t setTimingValues(DiagnosticPublisher::Status &status, size_t first_key,
+                       const LatencyHistogram::Summary &summary) {
+  status.setInteger(first_key, summary.p50);
+  status.setInteger(first_key + 1, summary.p99);
+  status.setInteger(first_key + 2, summary.max);
+  return first_key + 3;
+}
+}  // namespace bitbots_ros_control
@@ -7,12 +7,13 @@ using std::placeholders::_2;
 using std::placeholders::_3;
 
 LedsHardwareInterface::LedsHardwareInterface(rclcpp::Node::SharedPtr nh, std::shared_ptr<DynamixelDriver> &driver,
-                                             uint8_t id, uint8_t num_leds, uint8_t start_number) {
+                                             uint8_t id, uint8_t num_leds, uint8_t start_number, int write_rate) {
   nh_ = nh;
   driver_ = driver;
   id_ = id;
   leds_.resize(num_leds);
   start_number_ = start_number;
+  write_rate_ = write_rate;
   // we want to write the LEDs in the beginning to show that ros control started successfully. set LED 1 white
   write_leds_ = true;
   leds_[0] = std_msgs::msg::ColorRGBA();
@@ -36,6 +37,12 @@ bool LedsHardwareInterface::init() {
   return true;
 }
 
+void LedsHardwareInterface::registerTasks(std::shared_ptr<CycleScheduler> scheduler) {
+  scheduler_ = scheduler;
+  // one register write per LED, changes are only written in the scheduled cycles
+  write_task_ = scheduler_->addTask("leds", write_rate_, leds_.size() * scheduler_->transactionTime(sizeof(uint32_t)));
+}
+
 // todo this could be done more clever and for a general number of leds
 void LedsHardwareInterface::ledCb0(std_msgs::msg::ColorRGBA msg) {
   // only write to bus if there is actually a change
@@ -93,7 +100,7 @@ uint32_t rgba_to_int32(std_msgs::msg::ColorRGBA rgba) {
 }
 
 void LedsHardwareInterface::write(const rclcpp::Time &t, const rclcpp::Duration &dt) {
-  if (write_leds_) {
+  if (write_leds_ && scheduler_->isDue(write_task_)) {
     // resort LEDs to go from left to right
     driver_->writeRegister(id_, "LED_2", rgba_to_int32(leds_[0]));
     driver_->writeRegister(id_, "LED_1", rgba_to_int32(leds_[1]));
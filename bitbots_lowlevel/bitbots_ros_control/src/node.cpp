@@ -1,7 +1,11 @@
 #include <signal.h>
 
+#include <bitbots_ros_control/latency_histogram.hpp>
+#include <bitbots_ros_control/timing_trace.hpp>
 #include <bitbots_ros_control/wolfgang_hardware_interface.hpp>
+#include <chrono>
 #include <controller_manager/controller_manager.hpp>
+#include <optional>
 #include <rclcpp/experimental/executors/events_executor/events_executor.hpp>
 #include <rclcpp/rclcpp.hpp>
 #include <thread>
@@ -30,15 +34,22 @@ int main(int argc, char *argv[]) {
     return 1;
   }
 
-  // diagnostics
+  // diagnostics, the statuses are created here so that the control loop does not need to allocate
   int diag_counter = 0;
-  rclcpp::Publisher<diagnostic_msgs::msg::DiagnosticArray>::SharedPtr diagnostic_pub =
-      nh->create_publisher<diagnostic_msgs::msg::DiagnosticArray>("/diagnostics", 10);
-  diagnostic_msgs::msg::DiagnosticArray array_msg = diagnostic_msgs::msg::DiagnosticArray();
-  diagnostic_msgs::msg::DiagnosticStatus status = diagnostic_msgs::msg::DiagnosticStatus();
-  // add prefix PS for pressure sensor to sort in diagnostic analyser
-  status.name = "BUSBus";
-  status.hardware_id = "Bus";
+  std::vector<std::string> timing_keys;
+  for (const char *stage : {"cycle", "read", "write", "spin", "sleep"}) {
+    bitbots_ros_control::appendTimingKeys(timing_keys, stage);
+  }
+  timing_keys.push_back("overruns");
+  timing_keys.push_back("dropped trace records");
+  // add prefix BUS to sort in diagnostic analyser
+  std::shared_ptr<bitbots_ros_control::DiagnosticPublisher::Status> status =
+      hw.getDiagnosticPublisher()->addStatus("BUSBus", "Bus", timing_keys);
+  std::vector<std::shared_ptr<bitbots_ros_control::DiagnosticPublisher::Status>> port_statuses;
+  for (const std::unique_ptr<bitbots_ros_control::PortWorker> &worker : hw.getPortWorkers()) {
+    port_statuses.push_back(
+        hw.getDiagnosticPublisher()->addStatus("BUS" + worker->name(), worker->name(), worker->timingKeys()));
+  }
 
   // Start control loop
   rclcpp::Time current_time = nh->get_clock()->now();
@@ -52,11 +63,49 @@ int main(int argc, char *argv[]) {
   rclcpp::experimental::executors::EventsExecutor exec;
   exec.add_node(nh);
 
+  // timing of the control loop stages, summarized on /diagnostics
+  bitbots_ros_control::LatencyHistogram read_histogram, write_histogram, spin_histogram, sleep_histogram,
+      cycle_histogram;
+  // cycles in which reading, writing and spinning took longer than the period of the control loop
+  int overruns = 0;
+  auto nominal_period = std::chrono::nanoseconds(int64_t(1e9 / control_loop_hz));
+  std::optional<std::chrono::steady_clock::time_point> last_cycle_end;
+
+  // optional binary trace of the stage durations of each cycle
+  std::string timing_trace_file;
+  nh->get_parameter_or("timing_trace_file", timing_trace_file, std::string(""));
+  std::unique_ptr<bitbots_ros_control::TimingTrace> trace;
+  std::vector<uint32_t> trace_record;
+  if (!timing_trace_file.empty()) {
+    std::vector<std::string> fields = {"read", "write", "spin", "sleep"};
+    for (const std::unique_ptr<bitbots_ros_control::PortWorker> &worker : hw.getPortWorkers()) {
+      fields.push_back(worker->name() + " read");
+      fields.push_back(worker->name() + " write");
+    }
+    // buffer 10 seconds of cycles
+    trace = std::make_unique<bitbots_ros_control::TimingTrace>(timing_trace_file, fields, 10 * control_loop_hz);
+    if (!trace->isOpen()) {
+      RCLCPP_ERROR(nh->get_logger(), "Could not open timing trace file %s", timing_trace_file.c_str());
+      trace.reset();
+    }
+    trace_record.resize(fields.size());
+  }
+
   while (!request_shutdown || nh->get_clock()->now().seconds() - stop_time.seconds() < 5) {
     //
     // read
     //
+    auto read_start = std::chrono::steady_clock::now();
     hw.read(current_time, period);
+    auto read_end = std::chrono::steady_clock::now();
+    if (trace) {
+      // in the pipelined cycle, the workers are only idle directly after the read
+      size_t field = 4;
+      for (const std::unique_ptr<bitbots_ros_control::PortWorker> &worker : hw.getPortWorkers()) {
+        trace_record[field++] = worker->lastReadDuration().count() / 1000;
+        trace_record[field++] = worker->lastWriteDuration().count() / 1000;
+      }
+    }
     period = nh->get_clock()->now() - current_time;
     current_time = nh->get_clock()->now();
 
@@ -68,31 +117,74 @@ int main(int argc, char *argv[]) {
       // todo replaced controller part, if necessary
     }
 
+    //
+    // Callbacks
+    //
+    // the I/O workers are idle between read and write, so the callbacks can change the state of the hardware
+    // interfaces without synchronization. Their commands are also written in the same cycle.
+    auto spin_start = std::chrono::steady_clock::now();
+    exec.spin_some();
+    auto spin_end = std::chrono::steady_clock::now();
+
     //
     // Write
     //
     hw.write(current_time, period);
-    exec.spin_some();
+    auto write_end = std::chrono::steady_clock::now();
     rate.sleep();
+    auto sleep_end = std::chrono::steady_clock::now();
+
+    //
+    // Timing
+    //
+    read_histogram.record(read_end - read_start);
+    write_histogram.record(write_end - spin_end);
+    spin_histogram.record(spin_end - spin_start);
+    sleep_histogram.record(sleep_end - write_end);
+    if (last_cycle_end) {
+      cycle_histogram.record(sleep_end - last_cycle_end.value());
+    }
+    last_cycle_end = sleep_end;
+    if (write_end - read_start > nominal_period) {
+      overruns++;
+    }
+    if (trace) {
+      auto to_us = [](std::chrono::nanoseconds duration) { return uint32_t(duration.count() / 1000); };
+      trace_record[0] = to_us(read_end - read_start);
+      trace_record[1] = to_us(write_end - spin_end);
+      trace_record[2] = to_us(spin_end - spin_start);
+      trace_record[3] = to_us(sleep_end - write_end);
+      trace->push(read_start.time_since_epoch().count(), trace_record);
+    }
 
     //
     // Diagnostics
     //
     // publish diagnostic messages each 100 frames
     if (diag_counter % 100 == 0) {
+      bitbots_ros_control::LatencyHistogram::Summary cycle = cycle_histogram.takeSummary();
       // check if we are staying the correct cycle time. warning if we only get half
-      array_msg.header.stamp = nh->get_clock()->now();
-      if (rate.period() < std::chrono::nanoseconds(int(1e9 * (1 / control_loop_hz) * 2))) {
-        status.level = diagnostic_msgs::msg::DiagnosticStatus::OK;
-        status.message = "";
+      if (cycle.p50 * 1000 < uint64_t(2 * nominal_period.count())) {
+        status->setLevel(diagnostic_msgs::msg::DiagnosticStatus::OK, "");
       } else {
-        status.level = diagnostic_msgs::msg::DiagnosticStatus::WARN;
-        status.message = "Bus runs not at specified frequency";
+        status->setLevel(diagnostic_msgs::msg::DiagnosticStatus::WARN, "Bus runs not at specified frequency");
+      }
+      // time the control loop spent in each stage since the last message
+      size_t key = bitbots_ros_control::setTimingValues(*status, 0, cycle);
+      key = bitbots_ros_control::setTimingValues(*status, key, read_histogram.takeSummary());
+      key = bitbots_ros_control::setTimingValues(*status, key, write_histogram.takeSummary());
+      key = bitbots_ros_control::setTimingValues(*status, key, spin_histogram.takeSummary());
+      key = bitbots_ros_control::setTimingValues(*status, key, sleep_histogram.takeSummary());
+      status->setInteger(key, overruns);
+      status->setInteger(key + 1, trace ? trace->dropped() : 0);
+      status->publish();
+      overruns = 0;
+      // bus time of each port and each device on it
+      for (size_t port = 0; port < port_statuses.size(); port++) {
+        port_statuses[port]->setLevel(diagnostic_msgs::msg::DiagnosticStatus::OK, "");
+        hw.getPortWorkers()[port]->setTimingValues(*port_statuses[port]);
+        port_statuses[port]->publish();
       }
-      std::vector array = std::vector<diagnostic_msgs::msg::DiagnosticStatus>();
-      array.push_back(status);
-      array_msg.status = array;
-      diagnostic_pub->publish(array_msg);
     }
     diag_counter++;
 
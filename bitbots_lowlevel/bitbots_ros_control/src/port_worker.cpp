@@ -0,0 +1,173 @@
+#include <pthread.h>
+#include <sched.h>
+
+#include <bitbots_ros_control/port_worker.hpp>
+#include <cstring>
+
+namespace bitbots_ros_control {
+
+PortWorker::PortWorker(rclcpp::Node::SharedPtr nh, std::vector<std::shared_ptr<HardwareInterface>> interfaces,
+                       std::vector<std::string> interface_names, const std::string &name, int cpu_core,
+                       int realtime_priority)
+    : nh_(nh),
+      interfaces_(std::move(interfaces)),
+      interface_names_(std::move(interface_names)),
+      name_(name),
+      cpu_core_(cpu_core),
+      realtime_priority_(realtime_priority) {
+  interface_names_.resize(interfaces_.size());
+  for (size_t i = 0; i < interfaces_.size(); i++) {
+    interface_read_histograms_.push_back(std::make_unique<LatencyHistogram>());
+    interface_write_histograms_.push_back(std::make_unique<LatencyHistogram>());
+  }
+  thread_ = std::thread(&PortWorker::loop, this);
+}
+
+PortWorker::~PortWorker() {
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    stop_ = true;
+  }
+  task_condition_.notify_one();
+  thread_.join();
+}
+
+void PortWorker::startRead(const rclcpp::Time &t, const rclcpp::Duration &dt) { start(Task::READ, t, dt); }
+
+void PortWorker::startWrite(const rclcpp::Time &t, const rclcpp::Duration &dt) { start(Task::WRITE, t, dt); }
+
+void PortWorker::startWriteRead(const rclcpp::Time &t, const rclcpp::Duration &dt,
+                                std::chrono::steady_clock::time_point read_time) {
+  start(Task::WRITE_READ, t, dt, read_time);
+}
+
+void PortWorker::start(Task task, const rclcpp::Time &t, const rclcpp::Duration &dt,
+                       std::chrono::steady_clock::time_point read_time) {
+  {
+    std::unique_lock<std::mutex> lock(mutex_);
+    // a port can only do one thing at a time, so finish the previous task first
+    done_condition_.wait(lock, [this] { return task_ == Task::NONE; });
+    task_ = task;
+    t_ = t;
+    dt_ = dt;
+    read_time_ = read_time;
+  }
+  task_condition_.notify_one();
+}
+
+void PortWorker::wait() {
+  std::unique_lock<std::mutex> lock(mutex_);
+  done_condition_.wait(lock, [this] { return task_ == Task::NONE; });
+}
+
+void PortWorker::loop() {
+  configureThread();
+  while (true) {
+    Task task;
+    rclcpp::Time t;
+    rclcpp::Duration dt(0, 0);
+    std::chrono::steady_clock::time_point read_time;
+    {
+      std::unique_lock<std::mutex> lock(mutex_);
+      task_condition_.wait(lock, [this] { return task_ != Task::NONE || stop_; });
+      if (stop_) {
+        return;
+      }
+      task = task_;
+      t = t_;
+      dt = dt_;
+      read_time = read_time_;
+    }
+
+    if (task == Task::WRITE || task == Task::WRITE_READ) {
+      runInterfaces(true, t, dt);
+    }
+    if (task == Task::WRITE_READ) {
+      // the bus is idle until the values are read for the next cycle
+      std::this_thread::sleep_until(read_time);
+    }
+    if (task == Task::READ || task == Task::WRITE_READ) {
+      runInterfaces(false, t, dt);
+    }
+
+    {
+      std::lock_guard<std::mutex> lock(mutex_);
+      task_ = Task::NONE;
+    }
+    done_condition_.notify_all();
+  }
+}
+
+void PortWorker::runInterfaces(bool write, const rclcpp::Time &t, const rclcpp::Duration &dt) {
+  auto start_time = std::chrono::steady_clock::now();
+  auto interface_start_time = start_time;
+  for (size_t i = 0; i < interfaces_.size(); i++) {
+    if (write) {
+      interfaces_[i]->write(t, dt);
+    } else {
+      interfaces_[i]->read(t, dt);
+    }
+    auto interface_end_time = std::chrono::steady_clock::now();
+    LatencyHistogram &histogram = write ? *interface_write_histograms_[i] : *interface_read_histograms_[i];
+    histogram.record(interface_end_time - interface_start_time);
+    interface_start_time = interface_end_time;
+  }
+  // only accessed by other threads after wait(), which synchronizes through the mutex
+  auto duration = interface_start_time - start_time;
+  if (write) {
+    last_write_duration_ = duration;
+    write_histogram_.record(duration);
+  } else {
+    last_read_duration_ = duration;
+    read_histogram_.record(duration);
+  }
+}
+
+std::chrono::nanoseconds PortWorker::lastReadDuration() const { return last_read_duration_; }
+
+std::chrono::nanoseconds PortWorker::lastWriteDuration() const { return last_write_duration_; }
+
+const std::string &PortWorker::name() const { return name_; }
+
+std::vector<std::string> PortWorker::timingKeys() const {
+  std::vector<std::string> keys;
+  appendTimingKeys(keys, "read");
+  appendTimingKeys(keys, "write");
+  for (const std::string &interface_name : interface_names_) {
+    appendTimingKeys(keys, interface_name + " read");
+    appendTimingKeys(keys, interface_name + " write");
+  }
+  return keys;
+}
+
+void PortWorker::setTimingValues(DiagnosticPublisher::Status &status) {
+  size_t key = bitbots_ros_control::setTimingValues(status, 0, read_histogram_.takeSummary());
+  key = bitbots_ros_control::setTimingValues(status, key, write_histogram_.takeSummary());
+  for (size_t i = 0; i < interfaces_.size(); i++) {
+    key = bitbots_ros_control::setTimingValues(status, key, interface_read_histograms_[i]->takeSummary());
+    key = bitbots_ros_control::setTimingValues(status, key, interface_write_histograms_[i]->takeSummary());
+  }
+}
+
+void PortWorker::configureThread() {
+  if (cpu_core_ >= 0) {
+    cpu_set_t cpu_set;
+    CPU_ZERO(&cpu_set);
+    CPU_SET(cpu_core_, &cpu_set);
+    int error = pthread_setaffinity_np(pthread_self(), sizeof(cpu_set), &cpu_set);
+    if (error != 0) {
+      RCLCPP_WARN(nh_->get_logger(), "Could not pin I/O thread of %s to core %d: %s", name_.c_str(),
+                  cpu_core_, strerror(error));
+    }
+  }
+  if (realtime_priority_ > 0) {
+    sched_param param{};
+    param.sched_priority = realtime_priority_;
+    int error = pthread_setschedparam(pthread_self(), SCHED_FIFO, &param);
+    if (error != 0) {
+      RCLCPP_WARN(nh_->get_logger(), "Could not set SCHED_FIFO priority %d for I/O thread of %s: %s",
+                  realtime_priority_, name_.c_str(), strerror(error));
+    }
+  }
+}
+}  // namespace bitbots_ros_control
@@ -0,0 +1,78 @@
+#include <algorithm>
+#include <bitbots_ros_control/register_read_plan.hpp>
+
+namespace bitbots_ros_control {
+
+namespace {
+struct RegisterInfo {
+  uint16_t address;
+  uint8_t size;
+};
+
+// Address and size of each register in the control table
+constexpr std::array<RegisterInfo, SERVO_REGISTER_COUNT> REGISTER_TABLE = {{
+    {70, 1},   // HARDWARE_ERROR_STATUS
+    {124, 2},  // PRESENT_PWM
+    {126, 2},  // PRESENT_CURRENT
+    {128, 4},  // PRESENT_VELOCITY
+    {132, 4},  // PRESENT_POSITION
+    {144, 2},  // PRESENT_INPUT_VOLTAGE
+    {146, 1},  // PRESENT_TEMPERATURE
+}};
+}  // namespace
+
+RegisterReadPlan::RegisterReadPlan(const std::vector<ServoRegister> &registers, uint16_t max_gap, size_t servo_count)
+    : servo_count_(servo_count) {
+  std::vector<ServoRegister> sorted = registers;
+  std::sort(sorted.begin(), sorted.end(), [](ServoRegister a, ServoRegister b) {
+    return REGISTER_TABLE[a].address < REGISTER_TABLE[b].address;
+  });
+  sorted.erase(std::unique(sorted.begin(), sorted.end()), sorted.end());
+
+  // Extend the current block as long as the gap to the next register is small enough
+  for (ServoRegister reg : sorted) {
+    const RegisterInfo &info = REGISTER_TABLE[reg];
+    if (blocks_.empty() || info.address > blocks_.back().address + blocks_.back().length + max_gap) {
+      blocks_.push_back({info.address, 0, {}, {}});
+    }
+    Block &block = blocks_.back();
+    block.registers.push_back(reg);
+    block.offsets.push_back(info.address - block.address);
+    block.length = std::max<uint16_t>(block.length, info.address + info.size - block.address);
+    contained_[reg] = true;
+    values_[reg].resize(servo_count, 0);
+  }
+}
+
+const std::vector<RegisterReadPlan::Block> &RegisterReadPlan::blocks() const { return blocks_; }
+
+bool RegisterReadPlan::decode(size_t block_index, const std::vector<uint8_t> &data) {
+  const Block &block = blocks_[block_index];
+  if (data.size() < servo_count_ * block.length) {
+    return false;
+  }
+  for (size_t r = 0; r < block.registers.size(); r++) {
+    ServoRegister reg = block.registers[r];
+    uint8_t size = REGISTER_TABLE[reg].size;
+    std::vector<int32_t> &values = values_[reg];
+    // The registers are little endian
+    const uint8_t *servo_data = data.data() + block.offsets[r];
+    for (size_t i = 0; i < servo_count_; i++, servo_data += block.length) {
+      if (size == 1) {
+        values[i] = servo_data[0];
+      } else if (size == 2) {
+        values[i] = static_cast<int16_t>(servo_data[0] | servo_data[1] << 8);
+      } else {
+        values[i] = static_cast<int32_t>(static_cast<uint32_t>(servo_data[0]) | servo_data[1] << 8 |
+                                         servo_data[2] << 16 | static_cast<uint32_t>(servo_data[3]) << 24);
+      }
+    }
+  }
+  return true;
+}
+
+const std::vector<int32_t> &RegisterReadPlan::values(ServoRegister reg) const { return values_[reg]; }
+
+bool RegisterReadPlan::contains(ServoRegister reg) const { return contained_[reg]; }
+
+}  // namespace bitbots_ros_control
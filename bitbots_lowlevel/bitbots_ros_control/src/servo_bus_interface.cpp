@@ -3,6 +3,19 @@
 
 namespace bitbots_ros_control {
 
+namespace {
+// Control table items of the registers which have a sync read handler in the driver
+constexpr std::array<const char *, SERVO_REGISTER_COUNT> SYNC_READ_ITEMS = {{
+    "Hardware_Error_Status",  // HARDWARE_ERROR_STATUS
+    "Present_PWM",            // PRESENT_PWM
+    "Present_Current",        // PRESENT_CURRENT
+    "Present_Velocity",       // PRESENT_VELOCITY
+    "Present_Position",       // PRESENT_POSITION
+    nullptr,                  // PRESENT_INPUT_VOLTAGE
+    nullptr,                  // PRESENT_TEMPERATURE
+}};
+}  // namespace
+
 ServoBusInterface::ServoBusInterface(rclcpp::Node::SharedPtr nh, std::shared_ptr<DynamixelDriver> &driver,
                                      std::vector<std::tuple<int, std::string, float, float, std::string>> servos)
     : first_cycle_(true), read_position_(true), read_velocity_(false), read_effort_(true) {
@@ -12,11 +25,9 @@ ServoBusInterface::ServoBusInterface(rclcpp::Node::SharedPtr nh, std::shared_ptr
 }
 
 bool ServoBusInterface::init() {
-  diagnostic_pub_ = nh_->create_publisher<diagnostic_msgs::msg::DiagnosticArray>("/diagnostics", 10);
   speak_pub_ = nh_->create_publisher<bitbots_msgs::msg::Audio>("/speak", 1);
 
   lost_servo_connection_ = false;
-  read_vt_counter_ = 0;
   switch_individual_torque_ = false;
   current_torque_ = false;
   reading_successes_ = 0;
@@ -45,6 +56,7 @@ bool ServoBusInterface::init() {
   driver_->addSyncWrite("Goal_Current");
   driver_->addSyncWrite("Goal_PWM");
   driver_->addSyncWrite("Operating_Mode");
+  // the registers are read with the read plans, the handlers are only reinitialized to recover from failed reads
   driver_->addSyncRead("Present_Current");
   driver_->addSyncRead("Present_Velocity");
   driver_->addSyncRead("Present_Position");
@@ -70,11 +82,6 @@ bool ServoBusInterface::init() {
   goal_torque_individual_.resize(joint_count_, 1);
 
   // reserve memory only once for later reads and writes to improve performance
-  data_sync_read_positions_.resize(joint_count_);
-  data_sync_read_velocities_.resize(joint_count_);
-  data_sync_read_efforts_.resize(joint_count_);
-  data_sync_read_pwms_.resize(joint_count_);
-  data_sync_read_error_.resize(joint_count_);
   sync_write_goal_position_.resize(joint_count_);
   sync_write_goal_velocity_.resize(joint_count_);
   sync_write_profile_velocity_.resize(joint_count_);
@@ -82,6 +89,27 @@ bool ServoBusInterface::init() {
   sync_write_goal_current_.resize(joint_count_);
   sync_write_goal_pwm_.resize(joint_count_);
 
+  // Plan the sync reads for the registers requested in the config, close registers are read in one transaction
+  std::vector<ServoRegister> registers;
+  if (read_position_) {
+    registers.push_back(PRESENT_POSITION);
+  }
+  if (read_velocity_) {
+    registers.push_back(PRESENT_VELOCITY);
+  }
+  if (read_effort_) {
+    registers.push_back(PRESENT_CURRENT);
+  }
+  if (read_pwm_) {
+    registers.push_back(PRESENT_PWM);
+  }
+  uint16_t read_max_gap = nh_->get_parameter("servos.read_max_gap").as_int();
+  read_plan_ = RegisterReadPlan(registers, read_max_gap, joint_count_);
+  registers.insert(registers.end(), {PRESENT_INPUT_VOLTAGE, PRESENT_TEMPERATURE, HARDWARE_ERROR_STATUS});
+  vte_read_plan_ = RegisterReadPlan(registers, read_max_gap, joint_count_);
+  RCLCPP_INFO(nh_->get_logger(), "Reading servos with %zu sync reads per cycle (%zu with voltage and temperature)",
+              read_plan_.blocks().size(), vte_read_plan_.blocks().size());
+
   // write ROM and RAM values if wanted
   if (nh_->get_parameter("servos.set_ROM_RAM").as_bool()) {
     if (!writeROMRAM(true)) {
@@ -99,11 +127,6 @@ bool ServoBusInterface::loadDynamixels() {
    */
   bool success = true;
 
-  // prepare diagnostic msg
-  diagnostic_msgs::msg::DiagnosticArray array_msg = diagnostic_msgs::msg::DiagnosticArray();
-  std::vector<diagnostic_msgs::msg::DiagnosticStatus> array = std::vector<diagnostic_msgs::msg::DiagnosticStatus>();
-  array_msg.header.stamp = nh_->get_clock()->now();
-
   // get control mode
   std::string control_mode;
   control_mode = nh_->get_parameter("servos.control_mode").as_string();
@@ -133,10 +156,6 @@ bool ServoBusInterface::loadDynamixels() {
     joint_groups_.push_back(group);
   }
 
-  // generate a diagnostic message
-  array_msg.status = array;
-  diagnostic_pub_->publish(array_msg);
-
   return success;
 }
 
@@ -224,69 +243,78 @@ void ServoBusInterface::read(const rclcpp::Time &t, const rclcpp::Duration &dt)
   /**
    * This is part of the main loop and handles reading of all connected devices
    */
+  // voltage, temperature and error are only read every vt_update_rate_ cycles, together with the other registers
+  bool read_vte = read_volt_temp_ && scheduler_->isDue(vte_task_);
+  RegisterReadPlan &plan = read_vte ? vte_read_plan_ : read_plan_;
+  std::array<bool, SERVO_REGISTER_COUNT> register_read{};
+  syncReadPlan(plan, register_read);
+
   bool read_successful = true;
-  // either read all values or a single one, depending on config
-  if (read_position_ && read_velocity_ && read_effort_) {
-    if (syncReadAll()) {
-      for (size_t num = 0; num < joint_names_.size(); num++) {
-        current_position_[num] += joint_mounting_offsets_[num] + joint_offsets_[num];
-      }
-    } else {
-      RCLCPP_ERROR_THROTTLE(nh_->get_logger(), *nh_->get_clock(), 1000, "Couldn't read all current joint values!");
+  for (ServoRegister reg : {PRESENT_POSITION, PRESENT_VELOCITY, PRESENT_CURRENT, PRESENT_PWM}) {
+    if (plan.contains(reg) && !register_read[reg]) {
       read_successful = false;
     }
-  } else {
-    if (read_position_) {
-      if (syncReadPositions()) {
-        for (size_t num = 0; num < joint_names_.size(); num++) {
-          current_position_[num] += joint_mounting_offsets_[num] + joint_offsets_[num];
-        }
-      } else {
-        RCLCPP_ERROR_THROTTLE(nh_->get_logger(), *nh_->get_clock(), 1000, "Couldn't read current joint position!");
-        driver_->reinitSyncReadHandler("Present_Position");
-        read_successful = false;
+  }
+  if (!read_successful) {
+    RCLCPP_ERROR_THROTTLE(nh_->get_logger(), *nh_->get_clock(), 1000, "Couldn't read all current joint values!");
+  }
+
+  if (register_read[PRESENT_POSITION]) {
+    const std::vector<int32_t> &positions = plan.values(PRESENT_POSITION);
+    for (int i = 0; i < joint_count_; i++) {
+      if (positions[i] == 0) {
+        // a value of 0 is often a reading error, therefore we discard it
+        // this should not cause issues when a motor is actually close to 0
+        // since 1 bit only corresponds to + or - 0.1 deg
+        continue;
       }
-    }
-    if (read_velocity_) {
-      if (!syncReadVelocities()) {
-        RCLCPP_ERROR_THROTTLE(nh_->get_logger(), *nh_->get_clock(), 1000, "Couldn't read current joint velocity!");
-        driver_->reinitSyncReadHandler("Present_Velocity");
-        read_successful = false;
+      double current_pos = driver_->convertValue2Radian(joint_ids_[i], positions[i]);
+      if (current_pos < 3.15 && current_pos > -3.15) {
+        // only write values which are possible
+        current_position_[i] = current_pos + joint_mounting_offsets_[i] + joint_offsets_[i];
       }
     }
-    if (read_effort_) {
-      if (!syncReadEfforts()) {
-        RCLCPP_ERROR_THROTTLE(nh_->get_logger(), *nh_->get_clock(), 1000, "Couldn't read current joint effort!");
-        driver_->reinitSyncReadHandler("Present_Current");
-        read_successful = false;
-      }
+  }
+  if (register_read[PRESENT_VELOCITY]) {
+    const std::vector<int32_t> &velocities = plan.values(PRESENT_VELOCITY);
+    for (int i = 0; i < joint_count_; i++) {
+      current_velocity_[i] = driver_->convertValue2Velocity(joint_ids_[i], velocities[i]);
     }
   }
-
-  if (read_pwm_) {
-    if (!syncReadPWMs()) {
-      driver_->reinitSyncReadHandler("Present_PWM");
-      RCLCPP_ERROR_THROTTLE(nh_->get_logger(), *nh_->get_clock(), 1000, "Couldn't read current PWM!");
-      read_successful = false;
+  if (register_read[PRESENT_CURRENT]) {
+    const std::vector<int32_t> &currents = plan.values(PRESENT_CURRENT);
+    for (int i = 0; i < joint_count_; i++) {
+      current_effort_[i] = driver_->convertValue2Torque(joint_ids_[i], currents[i]);
     }
   }
-
-  if (read_volt_temp_) {
-    if (read_vt_counter_ + 1 == vt_update_rate_) {
-      bool success = true;
-      if (!syncReadVoltageAndTemp()) {
-        RCLCPP_ERROR_THROTTLE(nh_->get_logger(), *nh_->get_clock(), 1000,
-                              "Couldn't read current input volatage and temperature!");
-        success = false;
-      }
-      if (!syncReadError()) {
-        RCLCPP_ERROR_THROTTLE(nh_->get_logger(), *nh_->get_clock(), 1000, "Couldn't read current error bytes!");
-        success = false;
-        driver_->reinitSyncReadHandler("Hardware_Error_Status");
+  if (register_read[PRESENT_PWM]) {
+    const std::vector<int32_t> &pwms = plan.values(PRESENT_PWM);
+    for (int i = 0; i < joint_count_; i++) {
+      // 100% is a value of 885
+      // convert to range -1 to 1
+      current_pwm_[i] = pwms[i] / 885.0;
+    }
+  }
+
+  if (read_vte) {
+    bool success = register_read[PRESENT_INPUT_VOLTAGE] && register_read[PRESENT_TEMPERATURE] &&
+                   register_read[HARDWARE_ERROR_STATUS];
+    if (success) {
+      const std::vector<int32_t> &voltages = plan.values(PRESENT_INPUT_VOLTAGE);
+      const std::vector<int32_t> &temperatures = plan.values(PRESENT_TEMPERATURE);
+      const std::vector<int32_t> &errors = plan.values(HARDWARE_ERROR_STATUS);
+      for (int i = 0; i < joint_count_; i++) {
+        // convert value to voltage
+        current_input_voltage_[i] = voltages[i] * 0.1;
+        // is already in °C
+        current_temperature_[i] = temperatures[i];
+        current_error_[i] = errors[i];
       }
-      processVte(success);
+    } else {
+      RCLCPP_ERROR_THROTTLE(nh_->get_logger(), *nh_->get_clock(), 1000,
+                            "Couldn't read current input voltage, temperature and error bytes!");
     }
-    read_vt_counter_ = (read_vt_counter_ + 1) % vt_update_rate_;
+    processVte(success);
   }
 
   if (first_cycle_) {
@@ -423,28 +451,24 @@ void ServoBusInterface::switchDynamixelControlMode() {
   writeTorque(torque_before_switch);
 }
 
-diagnostic_msgs::msg::DiagnosticStatus ServoBusInterface::createServoDiagMsg(int id, char level, std::string message,
-                                                                             std::map<std::string, std::string> map,
-                                                                             std::string name) {
-  /**
-   * Create a single Diagnostic message for one servo. This is used to build the array message which is then published.
-   */
-  diagnostic_msgs::msg::DiagnosticStatus servo_status = diagnostic_msgs::msg::DiagnosticStatus();
-  servo_status.level = level;
-  // add prefix DS for dynamixel servo to sort in diagnostic analyser
-  servo_status.name = "DS" + name;
-  servo_status.message = message;
-  servo_status.hardware_id = std::to_string(id);
-  std::vector<diagnostic_msgs::msg::KeyValue> keyValues = std::vector<diagnostic_msgs::msg::KeyValue>();
-  // iterate through map and save it into values
-  for (auto const &ent1 : map) {
-    diagnostic_msgs::msg::KeyValue key_value = diagnostic_msgs::msg::KeyValue();
-    key_value.key = ent1.first;
-    key_value.value = ent1.second;
-    keyValues.push_back(key_value);
-  }
-  servo_status.values = keyValues;
-  return servo_status;
+void ServoBusInterface::registerDiagnostics(std::shared_ptr<DiagnosticPublisher> diagnostics) {
+  for (int i = 0; i < joint_count_; i++) {
+    // add prefix DS for dynamixel servo to sort in diagnostic analyser
+    diagnostic_statuses_.push_back(diagnostics->addStatus("DS" + joint_names_[i], std::to_string(joint_ids_[i]),
+                                                          {"Input Voltage", "Temperature", "Error Byte"}));
+  }
+  // the messages are created here, so that no strings have to be built in the control loop
+  // values taken from dynamixel documentation
+  const std::vector<std::pair<uint8_t, std::string>> errors = {
+      {0x1, "Voltage "}, {0x4, "Overheat "}, {0x8, "Encoder "}, {0x10, "Shock "}, {0x20, "Overload"}};
+  for (size_t error_byte = 0; error_byte < error_messages_.size(); error_byte++) {
+    error_messages_[error_byte] = "Error(s): ";
+    for (const std::pair<uint8_t, std::string> &error : errors) {
+      if ((error_byte & error.first) != 0) {
+        error_messages_[error_byte] += error.second;
+      }
+    }
+  }
 }
 
 void ServoBusInterface::processVte(bool success) {
@@ -452,57 +476,29 @@ void ServoBusInterface::processVte(bool success) {
    *  This processes the data for voltage, temperature and error of the servos. It is mainly used as diagnostic message.
    */
 
-  // prepare diagnostic msg
-  diagnostic_msgs::msg::DiagnosticArray array_msg = diagnostic_msgs::msg::DiagnosticArray();
-  std::vector<diagnostic_msgs::msg::DiagnosticStatus> array = std::vector<diagnostic_msgs::msg::DiagnosticStatus>();
-  array_msg.header.stamp = nh_->get_clock()->now();
-
-  for (size_t i = 0; i < joint_names_.size(); i++) {
-    char level = diagnostic_msgs::msg::DiagnosticStatus::OK;
-    std::string message = "OK";
-    std::map<std::string, std::string> map;
+  for (int i = 0; i < joint_count_; i++) {
+    DiagnosticPublisher::Status &status = *diagnostic_statuses_[i];
     if (!success) {
       // the read of VT or error failed, we will publish this and not the values
-      message = "No response";
-      level = diagnostic_msgs::msg::DiagnosticStatus::STALE;
-      array.push_back(createServoDiagMsg(joint_ids_[i], level, message, map, joint_names_[i]));
+      status.setLevel(diagnostic_msgs::msg::DiagnosticStatus::STALE, "No response");
+      status.publish();
       continue;
     }
-    map.insert(std::make_pair("Input Voltage", std::to_string(current_input_voltage_[i])));
+    status.setLevel(diagnostic_msgs::msg::DiagnosticStatus::OK, "OK");
+    status.setNumber(0, current_input_voltage_[i]);
     if (current_input_voltage_[i] < warn_volt_) {
-      message = "Power getting low";
-      level = diagnostic_msgs::msg::DiagnosticStatus::WARN;
+      status.setLevel(diagnostic_msgs::msg::DiagnosticStatus::WARN, "Power getting low");
     }
-    map.insert(std::make_pair("Temperature", std::to_string(current_temperature_[i])));
+    status.setNumber(1, current_temperature_[i]);
     if (current_temperature_[i] > warn_temp_) {
-      message = "Getting hot";
-      level = diagnostic_msgs::msg::DiagnosticStatus::WARN;
+      status.setLevel(diagnostic_msgs::msg::DiagnosticStatus::WARN, "Getting hot");
     }
-    map.insert(std::make_pair("Error Byte", std::to_string(current_error_[i])));
+    status.setInteger(2, current_error_[i]);
     if (current_error_[i] != 0) {
       // some error is detected
-      level = diagnostic_msgs::msg::DiagnosticStatus::ERROR;
-      message = "Error(s): ";
-      // check which one. Values taken from dynamixel documentation
-      char voltage_error = 0x1;
-      char overheat_error = 0x4;
-      char encoder_error = 0x8;
-      char shock_error = 0x10;
+      status.setLevel(diagnostic_msgs::msg::DiagnosticStatus::ERROR, error_messages_[current_error_[i]].c_str());
       char overload_error = 0x20;
-      if ((current_error_[i] & voltage_error) != 0) {
-        message = message + "Voltage ";
-      }
-      if ((current_error_[i] & overheat_error) != 0) {
-        message = message + "Overheat ";
-      }
-      if ((current_error_[i] & encoder_error) != 0) {
-        message = message + "Encoder ";
-      }
-      if ((current_error_[i] & shock_error) != 0) {
-        message = message + "Shock ";
-      }
       if ((current_error_[i] & overload_error) != 0) {
-        message = message + "Overload";
         // turn off torque on all motors
         // todo should also turn off power, but is not possible yet
         goal_torque_ = false;
@@ -511,11 +507,8 @@ void ServoBusInterface::processVte(bool success) {
         speakError(speak_pub_, "Overload Error!");
       }
     }
-
-    array.push_back(createServoDiagMsg(joint_ids_[i], level, message, map, joint_names_[i]));
+    status.publish();
   }
-  array_msg.status = array;
-  diagnostic_pub_->publish(array_msg);
 }
 
 void ServoBusInterface::writeTorque(bool enabled) {
@@ -546,127 +539,39 @@ void ServoBusInterface::writeTorqueForServos(std::vector<int32_t> torque) {
   }
 }
 
-bool ServoBusInterface::syncReadPositions() {
-  /**
-   * Reads all position information with a single sync read
-   */
-  bool success = driver_->syncRead("Present_Position", data_sync_read_positions_.data());
-  if (success) {
-    for (int i = 0; i < joint_count_; i++) {
-      // TODO test if this is required
-      if (data_sync_read_positions_[i] == 0) {
-        // a value of 0 is often a reading error, therefore we discard it
-        // this should not cause issues when a motor is actually close to 0
-        // since 1 bit only corresponds to + or - 0.1 deg
-        continue;
-      }
-      double current_pos = driver_->convertValue2Radian(joint_ids_[i], data_sync_read_positions_[i]);
-      if (current_pos < 3.15 && current_pos > -3.15) {
-        // only write values which are possible
-        current_position_[i] = current_pos;
+void ServoBusInterface::registerTasks(std::shared_ptr<CycleScheduler> scheduler) {
+  scheduler_ = scheduler;
+  if (read_volt_temp_) {
+    // only the additional bus time of the larger sync reads is scheduled, the normal reads happen in every cycle
+    auto plan_time = [this](const RegisterReadPlan &plan) {
+      double time = 0;
+      for (const RegisterReadPlan::Block &block : plan.blocks()) {
+        time += joint_count_ * scheduler_->transactionTime(block.length);
       }
-    }
-  }
-  return success;
-}
-
-bool ServoBusInterface::syncReadVelocities() {
-  /**
-   * Reads all velocity information with a single sync read
-   */
-  bool success = driver_->syncRead("Present_Velocity", data_sync_read_velocities_.data());
-  if (success) {
-    for (int i = 0; i < joint_count_; i++) {
-      current_velocity_[i] = driver_->convertValue2Velocity(joint_ids_[i], data_sync_read_velocities_[i]);
-    }
+      return time;
+    };
+    vte_task_ = scheduler_->addTask("servo_vte", vt_update_rate_, plan_time(vte_read_plan_) - plan_time(read_plan_));
   }
-  return success;
 }
 
-bool ServoBusInterface::syncReadEfforts() {
+void ServoBusInterface::syncReadPlan(RegisterReadPlan &plan, std::array<bool, SERVO_REGISTER_COUNT> &register_read) {
   /**
-   * Reads all effort information with a single sync read
+   * Reads each block of the plan with a single sync read
    */
-  bool success = driver_->syncRead("Present_Current", data_sync_read_efforts_.data());
-  if (success) {
-    for (int i = 0; i < joint_count_; i++) {
-      current_effort_[i] = driver_->convertValue2Torque(joint_ids_[i], data_sync_read_efforts_[i]);
-    }
-  }
-  return success;
-}
-
-bool ServoBusInterface::syncReadPWMs() {
-  /**
-   * Reads all PWM information with a single sync read
-   */
-  bool success = driver_->syncRead("Present_PWM", data_sync_read_pwms_.data());
-  if (success) {
-    for (int i = 0; i < joint_count_; i++) {
-      // the data is in int16
-      // 100% is a value of 885
-      // convert to range -1 to 1
-      current_pwm_[i] = ((int16_t)data_sync_read_pwms_[i]) / 885.0;
-    }
-  }
-  return success;
-}
-
-bool ServoBusInterface::syncReadError() {
-  /**
-   * Reads all error bytes with a single sync read
-   */
-  bool success = driver_->syncRead("Hardware_Error_Status", data_sync_read_error_.data());
-  if (success) {
-    for (int i = 0; i < joint_count_; i++) {
-      current_error_[i] = data_sync_read_error_[i];
-    }
-  }
-  return success;
-}
-
-bool ServoBusInterface::syncReadVoltageAndTemp() {
-  /**
-   * Reads all voltages and temperature information with a single sync read
-   */
-  std::vector<uint8_t> data;
-  if (driver_->syncReadMultipleRegisters(144, 3, &data)) {
-    for (int i = 0; i < joint_count_; i++) {
-      uint16_t volt = dxlMakeword(data[i * 3], data[i * 3 + 1]);
-      uint8_t temp = data[i * 3 + 2];
-      // convert value to voltage
-      current_input_voltage_[i] = volt * 0.1;
-      // is already in °C
-      current_temperature_[i] = temp;
-    }
-    return true;
-  } else {
-    return false;
-  }
-}
-
-bool ServoBusInterface::syncReadAll() {
-  /**
-   * Reads all positions, velocities and efforts with a single sync read
-   */
-  if (driver_->syncReadMultipleRegisters(126, 10, &sync_read_all_data_)) {
-    for (int i = 0; i < joint_count_; i++) {
-      int16_t eff = dxlMakeword(sync_read_all_data_[i * 10], sync_read_all_data_[i * 10 + 1]);
-      uint32_t vel = dxlMakedword(dxlMakeword(sync_read_all_data_[i * 10 + 2], sync_read_all_data_[i * 10 + 3]),
-                                  dxlMakeword(sync_read_all_data_[i * 10 + 4], sync_read_all_data_[i * 10 + 5]));
-      uint32_t pos = dxlMakedword(dxlMakeword(sync_read_all_data_[i * 10 + 6], sync_read_all_data_[i * 10 + 7]),
-                                  dxlMakeword(sync_read_all_data_[i * 10 + 8], sync_read_all_data_[i * 10 + 9]));
-      current_effort_[i] = driver_->convertValue2Torque(joint_ids_[i], eff);
-      current_velocity_[i] = driver_->convertValue2Velocity(joint_ids_[i], vel);
-      double current_pos = driver_->convertValue2Radian(joint_ids_[i], pos);
-      if (current_pos < 3.15 && current_pos > -3.15) {
-        // only write values which are possible
-        current_position_[i] = current_pos;
+  for (size_t b = 0; b < plan.blocks().size(); b++) {
+    const RegisterReadPlan::Block &block = plan.blocks()[b];
+    if (driver_->syncReadMultipleRegisters(block.address, block.length, &sync_read_data_) &&
+        plan.decode(b, sync_read_data_)) {
+      for (ServoRegister reg : block.registers) {
+        register_read[reg] = true;
+      }
+    } else {
+      for (ServoRegister reg : block.registers) {
+        if (SYNC_READ_ITEMS[reg] != nullptr) {
+          driver_->reinitSyncReadHandler(SYNC_READ_ITEMS[reg]);
+        }
       }
     }
-    return true;
-  } else {
-    return false;
   }
 }
 
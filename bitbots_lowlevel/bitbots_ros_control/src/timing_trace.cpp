@@ -0,0 +1,69 @@
+#include <algorithm>
+#include <bitbots_ros_control/timing_trace.hpp>
+#include <chrono>
+
+namespace bitbots_ros_control {
+
+TimingTrace::TimingTrace(const std::string &path, const std::vector<std::string> &fields, size_t capacity)
+    : file_(path, std::ios::binary | std::ios::trunc),
+      field_count_(fields.size()),
+      capacity_(std::max<size_t>(capacity, 1)),
+      stamps_(capacity_),
+      durations_(capacity_ * field_count_) {
+  if (!file_) {
+    return;
+  }
+  file_.write("BBTT", 4);
+  auto write_uint32 = [this](uint32_t value) { file_.write(reinterpret_cast<const char *>(&value), sizeof(value)); };
+  write_uint32(VERSION);
+  write_uint32(field_count_);
+  for (const std::string &field : fields) {
+    write_uint32(field.size());
+    file_.write(field.data(), field.size());
+  }
+  writer_ = std::thread(&TimingTrace::writerLoop, this);
+}
+
+TimingTrace::~TimingTrace() {
+  stop_ = true;
+  if (writer_.joinable()) {
+    writer_.join();
+  }
+}
+
+bool TimingTrace::isOpen() const { return file_.is_open() && file_.good(); }
+
+void TimingTrace::push(int64_t stamp, const std::vector<uint32_t> &durations) {
+  size_t head = head_.load(std::memory_order_relaxed);
+  if (head - tail_.load(std::memory_order_acquire) >= capacity_) {
+    dropped_.fetch_add(1, std::memory_order_relaxed);
+    return;
+  }
+  size_t slot = head % capacity_;
+  stamps_[slot] = stamp;
+  std::copy_n(durations.begin(), std::min(durations.size(), field_count_), durations_.begin() + slot * field_count_);
+  head_.store(head + 1, std::memory_order_release);
+}
+
+uint64_t TimingTrace::dropped() const { return dropped_.load(std::memory_order_relaxed); }
+
+void TimingTrace::writerLoop() {
+  while (true) {
+    // read stop_ before draining, so all records pushed before the destructor are written
+    bool stop = stop_;
+    size_t tail = tail_.load(std::memory_order_relaxed);
+    size_t head = head_.load(std::memory_order_acquire);
+    for (; tail != head; tail++) {
+      size_t slot = tail % capacity_;
+      file_.write(reinterpret_cast<const char *>(&stamps_[slot]), sizeof(int64_t));
+      file_.write(reinterpret_cast<const char *>(&durations_[slot * field_count_]), field_count_ * sizeof(uint32_t));
+    }
+    tail_.store(tail, std::memory_order_release);
+    if (stop) {
+      file_.flush();
+      return;
+    }
+    std::this_thread::sleep_for(std::chrono::milliseconds(100));
+  }
+}
+}  // namespace bitbots_ros_control
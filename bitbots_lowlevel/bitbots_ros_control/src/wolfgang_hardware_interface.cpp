@@ -14,10 +14,15 @@ WolfgangHardwareInterface::WolfgangHardwareInterface(rclcpp::Node::SharedPtr nh)
   last_power_status_ = false;
   current_power_status_ = false;
   speak_pub_ = nh->create_publisher<bitbots_msgs::msg::Audio>("/speak", 1);
+  diagnostics_ = std::make_shared<DiagnosticPublisher>(nh, std::chrono::milliseconds(100));
 
   // load parameters
   nh_->get_parameter("only_imu", only_imu_);
   nh_->get_parameter("only_pressure", only_pressure_);
+  nh_->get_parameter_or("pipelined_cycle", pipelined_cycle_, false);
+  double control_loop_hz = 500.0;
+  nh_->get_parameter("control_loop_hz", control_loop_hz);
+  cycle_period_ = std::chrono::nanoseconds(int64_t(1e9 / control_loop_hz));
   if (only_imu_) RCLCPP_WARN(nh_->get_logger(), "Starting in only IMU mode");
   if (only_pressure_) RCLCPP_WARN(nh_->get_logger(), "starting in only pressure sensor mode");
 
@@ -84,6 +89,7 @@ bool WolfgangHardwareInterface::create_interfaces(std::vector<std::pair<std::str
       // sleep(1);
       driver->setPacketHandler(protocol_version);
       std::vector<std::shared_ptr<HardwareInterface>> interfaces_on_port;
+      std::vector<std::string> interface_names_on_port;
       // iterate over all devices and ping them to see what is connected to this bus
       std::vector<std::tuple<int, std::string, float, float, std::string>> servos_on_port;
       for (std::pair<std::string, int> &device : dxl_devices) {
@@ -117,6 +123,7 @@ bool WolfgangHardwareInterface::create_interfaces(std::vector<std::pair<std::str
               // turn on power, just to be sure
               core_interface_->write(nh_->get_clock()->now(), rclcpp::Duration::from_nanoseconds(1e9 * 0));
               interfaces_on_port.push_back(core_interface_);
+              interface_names_on_port.push_back(name);
               core_present_ = true;
             } else if (model_number_specified == 0 && !only_imu_) {  // model number is currently 0 on foot sensors
               // bitfoot
@@ -126,6 +133,7 @@ bool WolfgangHardwareInterface::create_interfaces(std::vector<std::pair<std::str
               }
               auto interface = std::make_shared<BitFootHardwareInterface>(nh_, driver, id, topic, name);
               interfaces_on_port.push_back(interface);
+              interface_names_on_port.push_back(name);
             } else if (model_number_specified == 0xBAFF && interface_type == "IMU" && !only_pressure_) {
               // IMU
               std::string topic;
@@ -142,6 +150,7 @@ bool WolfgangHardwareInterface::create_interfaces(std::vector<std::pair<std::str
                * Therefore, a pointer to this class is passed down to the RobotHW classes
                * registering further interfaces */
               interfaces_on_port.push_back(interface);
+              interface_names_on_port.push_back(name);
             } else if (model_number_specified == 0xBAFF && interface_type == "Button" && !only_pressure_) {
               // Buttons
               std::string topic;
@@ -152,14 +161,18 @@ bool WolfgangHardwareInterface::create_interfaces(std::vector<std::pair<std::str
               nh_->get_parameter("device_info." + name + ".read_rate", read_rate);
               interfaces_on_port.push_back(
                   std::make_shared<ButtonHardwareInterface>(nh_, driver, id, topic, read_rate));
+              interface_names_on_port.push_back(name);
             } else if ((model_number_specified == 0xBAFF || model_number_specified == 0xABBA) &&
                        interface_type == "LED" && !only_pressure_) {
               // LEDs
               int number_of_LEDs, start_number;
               nh_->get_parameter("device_info." + name + ".number_of_LEDs", number_of_LEDs);
               nh_->get_parameter("device_info." + name + ".start_number", start_number);
+              int write_rate;
+              nh_->get_parameter_or("device_info." + name + ".write_rate", write_rate, 1);
               interfaces_on_port.push_back(
-                  std::make_shared<LedsHardwareInterface>(nh_, driver, id, number_of_LEDs, start_number));
+                  std::make_shared<LedsHardwareInterface>(nh_, driver, id, number_of_LEDs, start_number, write_rate));
+              interface_names_on_port.push_back(name);
             } else if ((model_number_specified == 311 || model_number_specified == 321 ||
                         model_number_specified == 1100) &&
                        !only_pressure_ && !only_imu_) {
@@ -186,10 +199,14 @@ bool WolfgangHardwareInterface::create_interfaces(std::vector<std::pair<std::str
       if (servos_on_port.size() > 0) {
         auto interface = std::make_shared<ServoBusInterface>(nh_, driver, servos_on_port);
         interfaces_on_port.push_back(interface);
+        interface_names_on_port.push_back("servos");
         servo_interface_.addBusInterface(interface);
       }
       // add vector of interfaces on this port to overall collection of interfaces
       interfaces_.push_back(interfaces_on_port);
+      interface_names_.push_back(interface_names_on_port);
+      port_names_.push_back(port_name);
+      port_baudrates_.push_back(baudrate);
     }
   }
 
@@ -247,17 +264,36 @@ bool WolfgangHardwareInterface::init() {
   bool success = std::all_of(successes.begin(), successes.end(), [](int *s) { return *s; });
   // init servo interface last after all servo busses are there
   success &= servo_interface_.init();
-  return success;
-}
 
-void threaded_read(const std::vector<std::shared_ptr<HardwareInterface>> &port_interfaces, const rclcpp::Time &t,
-                   const rclcpp::Duration &dt) {
-  for (std::shared_ptr<HardwareInterface> interface : port_interfaces) {
-    interface->read(t, dt);
+  // spread the low rate transactions of each port over the cycles, and register the diagnostics of the interfaces
+  for (size_t port = 0; port < interfaces_.size(); port++) {
+    auto scheduler = std::make_shared<CycleScheduler>(port_baudrates_[port]);
+    for (std::shared_ptr<HardwareInterface> &interface : interfaces_[port]) {
+      interface->registerTasks(scheduler);
+      interface->registerDiagnostics(diagnostics_);
+    }
+    scheduler->build();
+    RCLCPP_INFO(nh_->get_logger(), "Schedule of %s (phase/period): %s. Worst case %.0f us instead of %.0f us",
+                port_names_[port].c_str(), scheduler->describe().c_str(), scheduler->worstCycleCost(),
+                scheduler->unscheduledWorstCycleCost());
+    schedulers_.push_back(scheduler);
+  }
+
+  // start the I/O threads that are used in the control loop
+  int realtime_priority;
+  nh_->get_parameter_or("io_thread_priority", realtime_priority, 0);
+  for (size_t port = 0; port < interfaces_.size(); port++) {
+    int cpu_core;
+    nh_->get_parameter_or("port_info." + port_names_[port] + ".cpu_core", cpu_core, -1);
+    port_workers_.push_back(
+        std::make_unique<PortWorker>(nh_, interfaces_[port], interface_names_[port], port_names_[port], cpu_core,
+                                     realtime_priority));
   }
+  return success;
 }
 
 void WolfgangHardwareInterface::read(const rclcpp::Time &t, const rclcpp::Duration &dt) {
+  cycle_start_ = std::chrono::steady_clock::now();
   // give feedback to power changes
   if (core_present_) {
     if (current_power_status_ && !last_power_status_) {
@@ -268,14 +304,17 @@ void WolfgangHardwareInterface::read(const rclcpp::Time &t, const rclcpp::Durati
   }
   if (!core_present_ || current_power_status_) {
     // only read all hardware if power is on
-    std::vector<std::thread> threads;
-    // start all reads
-    for (std::vector<std::shared_ptr<HardwareInterface>> &port_interfaces : interfaces_) {
-      threads.push_back(std::thread(threaded_read, std::ref(port_interfaces), std::ref(t), std::ref(dt)));
+    // start all reads, in the pipelined cycle they were already started after the last write
+    if (!pipelined_read_pending_) {
+      advanceSchedulers();
+      for (std::unique_ptr<PortWorker> &worker : port_workers_) {
+        worker->startRead(t, dt);
+      }
     }
+    pipelined_read_pending_ = false;
     // wait for all reads to finish
-    for (std::thread &thread : threads) {
-      thread.join();
+    for (std::unique_ptr<PortWorker> &worker : port_workers_) {
+      worker->wait();
     }
     // aggregate all servo values for controller
     servo_interface_.read(t, dt);
@@ -284,7 +323,13 @@ void WolfgangHardwareInterface::read(const rclcpp::Time &t, const rclcpp::Durati
       current_power_status_ = core_interface_->get_power_status();
     }
   } else {
+    // a pipelined read may still use the bus of the core
+    for (std::unique_ptr<PortWorker> &worker : port_workers_) {
+      worker->wait();
+    }
+    pipelined_read_pending_ = false;
     // read core to see if power is back on
+    advanceSchedulers();
     core_interface_->read(t, dt);
     last_power_status_ = current_power_status_;
     current_power_status_ = core_interface_->get_power_status();
@@ -292,13 +337,6 @@ void WolfgangHardwareInterface::read(const rclcpp::Time &t, const rclcpp::Durati
   }
 }
 
-void threaded_write(const std::vector<std::shared_ptr<HardwareInterface>> &port_interfaces, const rclcpp::Time &t,
-                    const rclcpp::Duration &dt) {
-  for (std::shared_ptr<HardwareInterface> interface : port_interfaces) {
-    interface->write(t, dt);
-  }
-}
-
 void WolfgangHardwareInterface::write(const rclcpp::Time &t, const rclcpp::Duration &dt) {
   if (core_present_ && !last_power_status_ && current_power_status_ &&
       nh_->get_parameter("servos.set_ROM_RAM").as_bool()) {
@@ -320,17 +358,41 @@ void WolfgangHardwareInterface::write(const rclcpp::Time &t, const rclcpp::Durat
     } else {
       // write all controller values to interfaces
       servo_interface_.write(t, dt);
-      std::vector<std::thread> threads;
-      // start all writes
-      for (std::vector<std::shared_ptr<HardwareInterface>> &port_interfaces : interfaces_) {
-        threads.push_back(std::thread(threaded_write, std::ref(port_interfaces), std::ref(t), std::ref(dt)));
-      }
+      if (pipelined_cycle_) {
+        // write and read the next cycle on each port, read() waits for the result.
+        // The read is timed to finish shortly before the next cycle starts, so the values are not older than
+        // in the sequential cycle. A margin of a tenth of the period covers reads that take longer than the last one.
+        advanceSchedulers();
+        auto read_deadline = cycle_start_ + cycle_period_ - cycle_period_ / 10;
+        for (std::unique_ptr<PortWorker> &worker : port_workers_) {
+          worker->startWriteRead(t, dt, read_deadline - worker->lastReadDuration());
+        }
+        pipelined_read_pending_ = true;
+      } else {
+        // start all writes
+        for (std::unique_ptr<PortWorker> &worker : port_workers_) {
+          worker->startWrite(t, dt);
+        }
 
-      // wait for all writes to finish
-      for (std::thread &thread : threads) {
-        thread.join();
+        // wait for all writes to finish
+        for (std::unique_ptr<PortWorker> &worker : port_workers_) {
+          worker->wait();
+        }
       }
     }
   }
 }
+
+void WolfgangHardwareInterface::advanceSchedulers() {
+  // a cycle starts with each read, the workers are idle at this point
+  for (std::shared_ptr<CycleScheduler> &scheduler : schedulers_) {
+    scheduler->advance();
+  }
+}
+
+const std::vector<std::unique_ptr<PortWorker>> &WolfgangHardwareInterface::getPortWorkers() const {
+  return port_workers_;
+}
+
+std::shared_ptr<DiagnosticPublisher> WolfgangHardwareInterface::getDiagnosticPublisher() const { return diagnostics_; }
 }  // namespace bitbots_ros_control
@@ -0,0 +1,109 @@
+#include <gtest/gtest.h>
+
+#include <bitbots_ros_control/cycle_scheduler.hpp>
+#include <vector>
+
+using namespace bitbots_ros_control;
+
+TEST(CycleScheduler, TransactionTime) {
+  CycleScheduler scheduler(1000000);
+  // 10 bits per byte at 1 Mbaud, 25 bytes of packet overhead and 50 us turnaround
+  EXPECT_DOUBLE_EQ(scheduler.transactionTime(0), 300.0);
+  EXPECT_DOUBLE_EQ(scheduler.transactionTime(4), 340.0);
+  CycleScheduler slow_scheduler(57600);
+  EXPECT_GT(slow_scheduler.transactionTime(4), scheduler.transactionTime(4));
+}
+
+TEST(CycleScheduler, SpreadsTasksOverCycles) {
+  CycleScheduler scheduler(1000000);
+  CycleScheduler::TaskId a = scheduler.addTask("a", 2, 100);
+  CycleScheduler::TaskId b = scheduler.addTask("b", 2, 100);
+  scheduler.build();
+  EXPECT_DOUBLE_EQ(scheduler.worstCycleCost(), 100);
+  EXPECT_DOUBLE_EQ(scheduler.unscheduledWorstCycleCost(), 200);
+
+  for (int cycle = 0; cycle < 10; cycle++) {
+    EXPECT_NE(scheduler.isDue(a), scheduler.isDue(b)) << "cycle " << cycle;
+    scheduler.advance();
+  }
+}
+
+TEST(CycleScheduler, PlacesExpensiveTasksFirst) {
+  CycleScheduler scheduler(1000000);
+  scheduler.addTask("cheap_1", 4, 10);
+  scheduler.addTask("cheap_2", 4, 10);
+  scheduler.addTask("expensive", 2, 30);
+  scheduler.build();
+  // The cheap tasks go into the cycles without the expensive one
+  EXPECT_DOUBLE_EQ(scheduler.worstCycleCost(), 30);
+  EXPECT_DOUBLE_EQ(scheduler.unscheduledWorstCycleCost(), 50);
+}
+
+TEST(CycleScheduler, TasksRunOncePerPeriod) {
+  CycleScheduler scheduler(1000000);
+  std::vector<int> periods = {1, 3, 5, 6};
+  std::vector<CycleScheduler::TaskId> tasks;
+  for (int period : periods) {
+    tasks.push_back(scheduler.addTask("task", period, period));
+  }
+  scheduler.build();
+
+  const int cycles = 60;
+  std::vector<int> executions(tasks.size(), 0);
+  std::vector<int> last_execution(tasks.size(), -1);
+  for (int cycle = 0; cycle < cycles; cycle++) {
+    for (size_t i = 0; i < tasks.size(); i++) {
+      if (scheduler.isDue(tasks[i])) {
+        if (last_execution[i] >= 0) {
+          EXPECT_EQ(cycle - last_execution[i], periods[i]);
+        }
+        last_execution[i] = cycle;
+        executions[i]++;
+      }
+    }
+    scheduler.advance();
+  }
+  for (size_t i = 0; i < tasks.size(); i++) {
+    EXPECT_EQ(executions[i], cycles / periods[i]);
+  }
+}
+
+TEST(CycleScheduler, InvalidPeriodRunsEveryCycle) {
+  CycleScheduler scheduler(1000000);
+  CycleScheduler::TaskId task = scheduler.addTask("task", 0, 10);
+  scheduler.build();
+  for (int cycle = 0; cycle < 3; cycle++) {
+    EXPECT_TRUE(scheduler.isDue(task));
+    scheduler.advance();
+  }
+}
+
+TEST(CycleScheduler, LongHyperperiod) {
+  // The periods are coprime, their hyperperiod is capped
+  CycleScheduler scheduler(1000000);
+  CycleScheduler::TaskId a = scheduler.addTask("a", 9973, 10);
+  CycleScheduler::TaskId b = scheduler.addTask("b", 9967, 10);
+  scheduler.build();
+  EXPECT_DOUBLE_EQ(scheduler.worstCycleCost(), 10);
+  int executions = 0;
+  for (int cycle = 0; cycle < 9973; cycle++) {
+    executions += scheduler.isDue(a);
+    EXPECT_FALSE(scheduler.isDue(a) && scheduler.isDue(b));
+    scheduler.advance();
+  }
+  EXPECT_EQ(executions, 1);
+}
+
+TEST(CycleScheduler, Empty) {
+  CycleScheduler scheduler(1000000);
+  scheduler.build();
+  EXPECT_DOUBLE_EQ(scheduler.worstCycleCost(), 0);
+  EXPECT_EQ(scheduler.describe(), "");
+}
+
+TEST(CycleScheduler, Describe) {
+  CycleScheduler scheduler(1000000);
+  scheduler.addTask("vte", 4, 10);
+  scheduler.build();
+  EXPECT_EQ(scheduler.describe(), "vte 0/4");
+}
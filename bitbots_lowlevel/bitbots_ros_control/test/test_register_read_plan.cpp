@@ -0,0 +1,102 @@
+#include <gtest/gtest.h>
+
+#include <bitbots_ros_control/register_read_plan.hpp>
+#include <cstdint>
+#include <vector>
+
+using namespace bitbots_ros_control;
+
+namespace {
+// Writes a little endian value of the given size at the offset
+void put(std::vector<uint8_t> &data, size_t offset, int32_t value, size_t size) {
+  for (size_t i = 0; i < size; i++) {
+    data[offset + i] = static_cast<uint8_t>(static_cast<uint32_t>(value) >> (8 * i));
+  }
+}
+}  // namespace
+
+TEST(RegisterReadPlan, MergesAdjacentRegisters) {
+  RegisterReadPlan plan({PRESENT_POSITION, PRESENT_VELOCITY, PRESENT_CURRENT}, 0, 2);
+  ASSERT_EQ(plan.blocks().size(), 1u);
+  const RegisterReadPlan::Block &block = plan.blocks()[0];
+  EXPECT_EQ(block.address, 126);
+  EXPECT_EQ(block.length, 10);
+  EXPECT_EQ(block.registers, (std::vector<ServoRegister>{PRESENT_CURRENT, PRESENT_VELOCITY, PRESENT_POSITION}));
+  EXPECT_EQ(block.offsets, (std::vector<uint16_t>{0, 2, 6}));
+  EXPECT_TRUE(plan.contains(PRESENT_POSITION));
+  EXPECT_FALSE(plan.contains(PRESENT_PWM));
+}
+
+TEST(RegisterReadPlan, SplitsAtLargeGaps) {
+  // There are 8 unused bytes between the position and the input voltage
+  std::vector<ServoRegister> registers = {PRESENT_POSITION, PRESENT_INPUT_VOLTAGE, HARDWARE_ERROR_STATUS};
+  RegisterReadPlan merged(registers, 8, 1);
+  ASSERT_EQ(merged.blocks().size(), 2u);
+  EXPECT_EQ(merged.blocks()[0].address, 70);
+  EXPECT_EQ(merged.blocks()[0].length, 1);
+  EXPECT_EQ(merged.blocks()[1].address, 132);
+  EXPECT_EQ(merged.blocks()[1].length, 14);
+
+  RegisterReadPlan split(registers, 7, 1);
+  ASSERT_EQ(split.blocks().size(), 3u);
+  EXPECT_EQ(split.blocks()[1].length, 4);
+  EXPECT_EQ(split.blocks()[2].address, 144);
+}
+
+TEST(RegisterReadPlan, IgnoresDuplicates) {
+  RegisterReadPlan plan({PRESENT_TEMPERATURE, PRESENT_TEMPERATURE}, 0, 1);
+  ASSERT_EQ(plan.blocks().size(), 1u);
+  EXPECT_EQ(plan.blocks()[0].registers.size(), 1u);
+}
+
+TEST(RegisterReadPlan, Decode) {
+  const size_t servo_count = 2;
+  RegisterReadPlan plan({PRESENT_PWM, PRESENT_CURRENT, PRESENT_VELOCITY, PRESENT_POSITION}, 0, servo_count);
+  ASSERT_EQ(plan.blocks().size(), 1u);
+  const RegisterReadPlan::Block &block = plan.blocks()[0];
+  ASSERT_EQ(block.length, 12);
+
+  std::vector<uint8_t> data(servo_count * block.length, 0);
+  // PWM, current, velocity and position of both servos
+  put(data, 0, 885, 2);
+  put(data, 2, -3, 2);
+  put(data, 4, -1000, 4);
+  put(data, 8, 2048, 4);
+  put(data, 12, -885, 2);
+  put(data, 14, 32767, 2);
+  put(data, 16, 70000, 4);
+  put(data, 20, -1, 4);
+  ASSERT_TRUE(plan.decode(0, data));
+
+  EXPECT_EQ(plan.values(PRESENT_PWM), (std::vector<int32_t>{885, -885}));
+  EXPECT_EQ(plan.values(PRESENT_CURRENT), (std::vector<int32_t>{-3, 32767}));
+  EXPECT_EQ(plan.values(PRESENT_VELOCITY), (std::vector<int32_t>{-1000, 70000}));
+  EXPECT_EQ(plan.values(PRESENT_POSITION), (std::vector<int32_t>{2048, -1}));
+}
+
+TEST(RegisterReadPlan, DecodeSingleByteRegisters) {
+  RegisterReadPlan plan({PRESENT_INPUT_VOLTAGE, PRESENT_TEMPERATURE}, 0, 2);
+  ASSERT_EQ(plan.blocks().size(), 1u);
+  std::vector<uint8_t> data = {120, 0, 200, 118, 0, 45};
+  ASSERT_TRUE(plan.decode(0, data));
+  EXPECT_EQ(plan.values(PRESENT_INPUT_VOLTAGE), (std::vector<int32_t>{120, 118}));
+  // Single bytes are not sign extended
+  EXPECT_EQ(plan.values(PRESENT_TEMPERATURE), (std::vector<int32_t>{200, 45}));
+}
+
+TEST(RegisterReadPlan, DecodeShortBuffer) {
+  const size_t servo_count = 3;
+  RegisterReadPlan plan({PRESENT_POSITION}, 0, servo_count);
+  std::vector<uint8_t> data(servo_count * 4, 0);
+  put(data, 0, 1, 4);
+  put(data, 4, 2, 4);
+  put(data, 8, 3, 4);
+  ASSERT_TRUE(plan.decode(0, data));
+
+  // The data of the last servo is missing, the values of the last read are kept
+  std::vector<uint8_t> short_data(data.begin(), data.end() - 1);
+  put(short_data, 0, 10, 4);
+  EXPECT_FALSE(plan.decode(0, short_data));
+  EXPECT_FALSE(plan.decode(0, {}));
+  EXPECT_EQ(plan.values(PRESENT_POSITION), (std::vector<int32_t>{1, 2, 3}));
+}
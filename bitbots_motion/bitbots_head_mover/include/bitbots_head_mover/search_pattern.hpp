@@ -0,0 +1,43 @@
+#ifndef BITBOTS_HEAD_MOVER_SEARCH_PATTERN_HPP
+#define BITBOTS_HEAD_MOVER_SEARCH_PATTERN_HPP
+
+#include <cmath>
+#include <utility>
+#include <vector>
+
+namespace move_head {
+
+/**
+ * @brief Returns the index of the pattern keypoint that is closest to the current head position
+ *
+ * @param pattern The search pattern, pan and tilt in degrees
+ * @param pan The current pan position in radians
+ * @param tilt The current tilt position in radians
+ * @return int The index of the pattern keypoint that is closest to the current head position, -1 if the pattern is
+ * empty
+ */
+inline int get_near_pattern_position(const std::vector<std::pair<double, double>>& pattern, double pan,
+                                     double tilt) {
+  // The pattern is given in degrees
+  double pan_deg = pan * 180 / M_PI;
+  double tilt_deg = tilt * 180 / M_PI;
+  // Store the index and distance of the closest keypoint
+  std::pair<double, int> min_distance_point = {10000.0, -1};
+  // Iterate over all keypoints and calculate the distance to the current head position
+  for (size_t i = 0; i < pattern.size(); i++) {
+    // Calculate the cartesian distance between the current head position and the keypoint
+    double distance = std::hypot(pattern[i].first - pan_deg, pattern[i].second - tilt_deg);
+    // Check if the distance is smaller than the current minimum distance
+    // and if so, update the minimum distance accordingly
+    if (distance < min_distance_point.first) {
+      min_distance_point.first = distance;
+      min_distance_point.second = i;
+    }
+  }
+  // Return the index of the closest keypoint
+  return min_distance_point.second;
+}
+
+}  // namespace move_head
+
+#endif  // BITBOTS_HEAD_MOVER_SEARCH_PATTERN_HPP
@@ -1,24 +1,31 @@
+#include <Eigen/Geometry>
 #include <bio_ik/bio_ik.h>
 #include <moveit/planning_scene/planning_scene.h>
 #include <moveit/planning_scene_monitor/planning_scene_monitor.h>
 #include <moveit/robot_model_loader/robot_model_loader.h>
-#include <moveit/robot_state/conversions.h>
 #include <tf2/convert.h>
 #include <tf2_ros/buffer.h>
 #include <tf2_ros/transform_listener.h>
 
-#include <bio_ik_msgs/msg/ik_response.hpp>
+#include <bitbots_head_mover/search_pattern.hpp>
 #include <bitbots_msgs/action/look_at.hpp>
 #include <bitbots_msgs/msg/head_mode.hpp>
 #include <bitbots_msgs/msg/joint_command.hpp>
+#include <bitbots_splines/smooth_spline.hpp>
+#include <atomic>
 #include <chrono>
 #include <cmath>
+#include <fstream>
+#include <functional>
+#include <future>
 #include <geometry_msgs/msg/pose_stamped.hpp>
 #include <geometry_msgs/msg/pose_with_covariance_stamped.hpp>
 #include <iostream>
 #include <memory>
+#include <mutex>
+#include <optional>
+#include <random>
 #include <rclcpp/clock.hpp>
-#include <rclcpp/experimental/executors/events_executor/events_executor.hpp>
 #include <rclcpp/logger.hpp>
 #include <rclcpp/rclcpp.hpp>
 #include <rclcpp/time.hpp>
@@ -36,11 +43,341 @@ using namespace std::chrono_literals;
 
 namespace move_head {
 
-#define DEG_TO_RAD M_PI / 180
+#define DEG_TO_RAD (M_PI / 180)
 
 using LookAtGoal = bitbots_msgs::action::LookAt;
 using LookAtGoalHandle = rclcpp_action::ServerGoalHandle<LookAtGoal>;
 
+/**
+ * @brief Seqlock protected snapshot of the head joint positions. It is written by a single joint state callback and
+ * can be read from other threads without locking or copying the whole joint state message.
+ */
+class HeadJointSnapshot {
+  // Odd while a write is in progress, zero if nothing was written yet
+  std::atomic<uint32_t> sequence_{0};
+  std::atomic<double> pan_{0.0};
+  std::atomic<double> tilt_{0.0};
+
+ public:
+  /**
+   * @brief Stores new head joint positions, must only be called from one thread
+   */
+  void write(double pan, double tilt) {
+    uint32_t sequence = sequence_.load(std::memory_order_relaxed);
+    sequence_.store(sequence + 1, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_release);
+    pan_.store(pan, std::memory_order_relaxed);
+    tilt_.store(tilt, std::memory_order_relaxed);
+    sequence_.store(sequence + 2, std::memory_order_release);
+  }
+
+  /**
+   * @brief Returns the latest consistent pair of head joint positions
+   */
+  std::pair<double, double> read() const {
+    uint32_t before, after;
+    double pan, tilt;
+    do {
+      before = sequence_.load(std::memory_order_acquire);
+      pan = pan_.load(std::memory_order_relaxed);
+      tilt = tilt_.load(std::memory_order_relaxed);
+      std::atomic_thread_fence(std::memory_order_acquire);
+      after = sequence_.load(std::memory_order_relaxed);
+    } while (before != after || (before & 1));
+    return {pan, tilt};
+  }
+
+  /**
+   * @brief Returns true if head joint positions were written at least once
+   */
+  bool received() const { return sequence_.load(std::memory_order_acquire) != 0; }
+};
+
+/**
+ * @brief Regular pan/tilt grid that stores for each sampled head position whether the head collides with the body.
+ * This allows O(1) collision checks instead of a full MoveIt collision check for each query.
+ */
+class HeadCollisionMap {
+  // Identifies the binary cache file format
+  static constexpr uint32_t MAGIC = 0x48434d31;  // "HCM1"
+  static constexpr uint32_t VERSION = 1;
+
+  double min_pan_ = 0;
+  double max_pan_ = 0;
+  double min_tilt_ = 0;
+  double max_tilt_ = 0;
+  double resolution_ = 0;
+  size_t pan_cells_ = 0;
+  size_t tilt_cells_ = 0;
+  // Row major (tilt rows, pan columns), 1 = collision
+  std::vector<uint8_t> cells_;
+
+ public:
+  /**
+   * @brief Returns true if the map was built or loaded for the given range and resolution
+   */
+  bool covers(double min_pan, double max_pan, double min_tilt, double max_tilt, double resolution) const {
+    return !cells_.empty() && min_pan_ == min_pan && max_pan_ == max_pan && min_tilt_ == min_tilt &&
+           max_tilt_ == max_tilt && resolution_ == resolution;
+  }
+
+  /**
+   * @brief Samples the given collision check function on every grid point of the given range
+   */
+  void build(double min_pan, double max_pan, double min_tilt, double max_tilt, double resolution,
+             const std::function<bool(double, double)>& check_collision) {
+    set_range(min_pan, max_pan, min_tilt, max_tilt, resolution);
+    for (size_t t = 0; t < tilt_cells_; t++) {
+      for (size_t p = 0; p < pan_cells_; p++) {
+        cells_[t * pan_cells_ + p] = check_collision(pan_at(p), tilt_at(t));
+      }
+    }
+  }
+
+  /**
+   * @brief Checks a number of random grid points against the given collision check function
+   *
+   * @return true if all checked grid points match
+   */
+  bool validate(int samples, const std::function<bool(double, double)>& check_collision) const {
+    std::mt19937 generator(std::random_device{}());
+    std::uniform_int_distribution<size_t> distribution(0, cells_.size() - 1);
+    for (int i = 0; i < samples; i++) {
+      size_t index = distribution(generator);
+      if (cells_[index] != check_collision(pan_at(index % pan_cells_), tilt_at(index / pan_cells_))) {
+        return false;
+      }
+    }
+    return true;
+  }
+
+  /**
+   * @brief Returns whether the head collides at the given position
+   *
+   * @param conservative If true, the position is colliding if any of the four surrounding grid points collides.
+   * Otherwise the bilinear interpolation of the surrounding grid points is thresholded at 0.5
+   */
+  bool in_collision(double pan, double tilt, bool conservative) const {
+    if (cells_.empty()) {
+      return true;
+    }
+    // Positions outside of the map are checked at its border, so searches that step past the limits still work
+    pan = std::clamp(pan, min_pan_, max_pan_);
+    tilt = std::clamp(tilt, min_tilt_, max_tilt_);
+
+    // Get the grid cell containing the position and the relative position inside of it
+    double pan_index = (pan - min_pan_) / resolution_;
+    double tilt_index = (tilt - min_tilt_) / resolution_;
+    size_t p0 = std::min(static_cast<size_t>(pan_index), pan_cells_ - 1);
+    size_t t0 = std::min(static_cast<size_t>(tilt_index), tilt_cells_ - 1);
+    size_t p1 = std::min(p0 + 1, pan_cells_ - 1);
+    size_t t1 = std::min(t0 + 1, tilt_cells_ - 1);
+
+    uint8_t c00 = cells_[t0 * pan_cells_ + p0];
+    uint8_t c01 = cells_[t0 * pan_cells_ + p1];
+    uint8_t c10 = cells_[t1 * pan_cells_ + p0];
+    uint8_t c11 = cells_[t1 * pan_cells_ + p1];
+
+    if (conservative) {
+      return c00 | c01 | c10 | c11;
+    }
+
+    double pan_fraction = std::clamp(pan_index - p0, 0.0, 1.0);
+    double tilt_fraction = std::clamp(tilt_index - t0, 0.0, 1.0);
+    double value = (1 - tilt_fraction) * ((1 - pan_fraction) * c00 + pan_fraction * c01) +
+                   tilt_fraction * ((1 - pan_fraction) * c10 + pan_fraction * c11);
+    return value >= 0.5;
+  }
+
+  /**
+   * @brief Writes the map into a binary file
+   */
+  bool save(const std::string& path) const {
+    std::ofstream file(path, std::ios::binary);
+    if (!file) {
+      return false;
+    }
+    uint64_t pan_cells = pan_cells_;
+    uint64_t tilt_cells = tilt_cells_;
+    file.write(reinterpret_cast<const char*>(&MAGIC), sizeof(MAGIC));
+    file.write(reinterpret_cast<const char*>(&VERSION), sizeof(VERSION));
+    for (double value : {min_pan_, max_pan_, min_tilt_, max_tilt_, resolution_}) {
+      file.write(reinterpret_cast<const char*>(&value), sizeof(value));
+    }
+    file.write(reinterpret_cast<const char*>(&pan_cells), sizeof(pan_cells));
+    file.write(reinterpret_cast<const char*>(&tilt_cells), sizeof(tilt_cells));
+    file.write(reinterpret_cast<const char*>(cells_.data()), cells_.size());
+    return file.good();
+  }
+
+  /**
+   * @brief Loads the map from a binary file if it was stored for the given range and resolution
+   */
+  bool load(const std::string& path, double min_pan, double max_pan, double min_tilt, double max_tilt,
+            double resolution) {
+    std::ifstream file(path, std::ios::binary);
+    if (!file) {
+      return false;
+    }
+    uint32_t magic, version;
+    double header[5];
+    uint64_t pan_cells, tilt_cells;
+    file.read(reinterpret_cast<char*>(&magic), sizeof(magic));
+    file.read(reinterpret_cast<char*>(&version), sizeof(version));
+    file.read(reinterpret_cast<char*>(header), sizeof(header));
+    file.read(reinterpret_cast<char*>(&pan_cells), sizeof(pan_cells));
+    file.read(reinterpret_cast<char*>(&tilt_cells), sizeof(tilt_cells));
+    if (!file || magic != MAGIC || version != VERSION || header[0] != min_pan || header[1] != max_pan ||
+        header[2] != min_tilt || header[3] != max_tilt || header[4] != resolution) {
+      return false;
+    }
+    set_range(min_pan, max_pan, min_tilt, max_tilt, resolution);
+    if (pan_cells != pan_cells_ || tilt_cells != tilt_cells_) {
+      cells_.clear();
+      return false;
+    }
+    file.read(reinterpret_cast<char*>(cells_.data()), cells_.size());
+    if (!file) {
+      cells_.clear();
+      return false;
+    }
+    return true;
+  }
+
+  /**
+   * @brief Returns the number of grid points
+   */
+  size_t size() const { return cells_.size(); }
+
+ private:
+  void set_range(double min_pan, double max_pan, double min_tilt, double max_tilt, double resolution) {
+    min_pan_ = min_pan;
+    max_pan_ = max_pan;
+    min_tilt_ = min_tilt;
+    max_tilt_ = max_tilt;
+    resolution_ = resolution;
+    // Add one grid point so the upper limit is always covered
+    pan_cells_ = static_cast<size_t>(std::ceil((max_pan - min_pan) / resolution)) + 1;
+    tilt_cells_ = static_cast<size_t>(std::ceil((max_tilt - min_tilt) / resolution)) + 1;
+    cells_.assign(pan_cells_ * tilt_cells_, 0);
+  }
+
+  double pan_at(size_t index) const { return std::min(min_pan_ + index * resolution_, max_pan_); }
+  double tilt_at(size_t index) const { return std::min(min_tilt_ + index * resolution_, max_tilt_); }
+};
+
+/**
+ * @brief Closed form look at solution for a pan/tilt head where the tilt axis is perpendicular to the pan axis.
+ * The geometry of the kinematic chain is extracted once from the robot model at zero pan and tilt.
+ */
+class HeadLookAtSolver {
+  bool valid_ = false;
+  // Pan frame: origin on the pan axis, z along the pan axis and x along the viewing direction at zero pan and tilt
+  Eigen::Matrix3d pan_frame_rotation_;
+  Eigen::Vector3d pan_frame_origin_;
+  // Geometry in the pan frame, only the x/z components are needed for the tilt because it rotates around y
+  Eigen::Vector3d tilt_origin_;
+  Eigen::Vector3d camera_position_;
+  Eigen::Vector3d camera_direction_;
+  // Sign of the tilt joint axis relative to the y axis of the pan frame
+  double tilt_sign_ = 1;
+
+ public:
+  /**
+   * @brief Extracts the geometry of the chain from the global transforms of the pan, tilt and camera links
+   *
+   * @param pan_link Transform of the pan joint child link at zero pan and tilt
+   * @param pan_axis Pan joint axis in the pan joint child link frame
+   * @param tilt_link Transform of the tilt joint child link at zero pan and tilt
+   * @param tilt_axis Tilt joint axis in the tilt joint child link frame
+   * @param camera_link Transform of the camera link at zero pan and tilt
+   * @param camera_axis Viewing direction in the camera link frame
+   * @return true if the chain can be solved analytically
+   */
+  bool init(const Eigen::Isometry3d& pan_link, const Eigen::Vector3d& pan_axis, const Eigen::Isometry3d& tilt_link,
+            const Eigen::Vector3d& tilt_axis, const Eigen::Isometry3d& camera_link,
+            const Eigen::Vector3d& camera_axis) {
+    valid_ = false;
+
+    // Build the pan frame from the pan axis and the viewing direction
+    Eigen::Vector3d z = (pan_link.linear() * pan_axis).normalized();
+    Eigen::Vector3d view = (camera_link.linear() * camera_axis).normalized();
+    Eigen::Vector3d x = view - view.dot(z) * z;
+    if (x.norm() < 1e-6) {
+      // Camera looks along the pan axis, the pan angle is undefined
+      return false;
+    }
+    x.normalize();
+    pan_frame_rotation_.col(0) = x;
+    pan_frame_rotation_.col(1) = z.cross(x);
+    pan_frame_rotation_.col(2) = z;
+    pan_frame_origin_ = pan_link.translation();
+
+    // Express the remaining chain in the pan frame
+    Eigen::Vector3d axis = pan_frame_rotation_.transpose() * (tilt_link.linear() * tilt_axis).normalized();
+    if (std::abs(axis.x()) > 1e-3 || std::abs(axis.z()) > 1e-3) {
+      // The tilt axis is not perpendicular to the pan axis and the viewing direction
+      return false;
+    }
+    tilt_sign_ = axis.y() > 0 ? 1 : -1;
+    tilt_origin_ = pan_frame_rotation_.transpose() * (tilt_link.translation() - pan_frame_origin_);
+    camera_position_ = pan_frame_rotation_.transpose() * (camera_link.translation() - pan_frame_origin_);
+    camera_direction_ = pan_frame_rotation_.transpose() * view;
+
+    valid_ = true;
+    return true;
+  }
+
+  /**
+   * @brief Returns true if the chain can be solved analytically
+   */
+  bool valid() const { return valid_; }
+
+  /**
+   * @brief Calculates the pan and tilt joint positions so the camera looks at the given point
+   *
+   * @param point Target point in the frame of the transforms passed to init
+   * @return The pan and tilt joint positions or nothing if the point can not be looked at
+   */
+  std::optional<std::pair<double, double>> solve(const Eigen::Vector3d& point) const {
+    if (!valid_) {
+      return std::nullopt;
+    }
+
+    // Pan so that the target lies in the plane of the viewing ray, which is not changed by the tilt
+    Eigen::Vector3d target = pan_frame_rotation_.transpose() * (point - pan_frame_origin_);
+    double radius = std::hypot(target.x(), target.y());
+    if (radius <= std::abs(camera_position_.y())) {
+      return std::nullopt;
+    }
+    double pan = std::atan2(target.y(), target.x()) - std::asin(camera_position_.y() / radius);
+
+    // Target relative to the tilt axis after the pan rotation, only using the x/z plane
+    double target_x = std::sqrt(radius * radius - camera_position_.y() * camera_position_.y()) - tilt_origin_.x();
+    double target_z = target.z() - tilt_origin_.z();
+    double camera_x = camera_position_.x() - tilt_origin_.x();
+    double camera_z = camera_position_.z() - tilt_origin_.z();
+    double target_distance = std::hypot(target_x, target_z);
+
+    // Offset of the viewing ray from the tilt axis, which stays constant during the tilt rotation
+    double ray_offset = camera_x * camera_direction_.z() - camera_z * camera_direction_.x();
+    if (target_distance <= std::abs(ray_offset)) {
+      return std::nullopt;
+    }
+    double tilt = std::atan2(camera_direction_.z(), camera_direction_.x()) - std::atan2(target_z, target_x) -
+                  std::asin(ray_offset / target_distance);
+
+    // Make sure the camera looks towards the target and not away from it
+    double rotated_x = target_x * std::cos(tilt) - target_z * std::sin(tilt) - camera_x;
+    double rotated_z = target_x * std::sin(tilt) + target_z * std::cos(tilt) - camera_z;
+    if (rotated_x * camera_direction_.x() + rotated_z * camera_direction_.z() <= 0) {
+      return std::nullopt;
+    }
+
+    return std::make_pair(std::remainder(pan, 2 * M_PI), std::remainder(tilt_sign_ * tilt, 2 * M_PI));
+  }
+};
+
 class HeadMover {
   std::shared_ptr<rclcpp::Node> node_;
 
@@ -48,6 +385,10 @@ class HeadMover {
   rclcpp::Subscription<bitbots_msgs::msg::HeadMode>::SharedPtr head_mode_subscriber_;
   rclcpp::Subscription<sensor_msgs::msg::JointState>::SharedPtr joint_state_subscriber_;
 
+  // Callback groups for the joint states and the look at action, everything else runs in the default group
+  rclcpp::CallbackGroup::SharedPtr joint_state_callback_group_;
+  rclcpp::CallbackGroup::SharedPtr action_callback_group_;
+
   // Declare publisher
   rclcpp::Publisher<bitbots_msgs::msg::JointCommand>::SharedPtr position_publisher_;
 
@@ -57,7 +398,13 @@ class HeadMover {
 
   // Declare variables
   uint head_mode_ = bitbots_msgs::msg::HeadMode::LOOK_FORWARD;
-  std::optional<sensor_msgs::msg::JointState> current_joint_state_;
+  HeadJointSnapshot head_joint_state_;
+  // Indices of the head joints in the joint state messages, resolved again if the message layout changes
+  size_t head_pan_index_ = 0;
+  size_t head_tilt_index_ = 0;
+  bool head_joint_indices_valid_ = false;
+  // Serializes the main loop and the look at action, as both use the parameters, the collision map and the IK
+  std::mutex control_mutex_;
   geometry_msgs::msg::PoseWithCovarianceStamped tf_precision_pose_;
 
   // Declare robot model and planning scene for moveit
@@ -68,6 +415,16 @@ class HeadMover {
   planning_scene_monitor::PlanningSceneMonitorPtr planning_scene_monitor_;
   planning_scene::PlanningScenePtr planning_scene_;
 
+  // Precomputed collision map for the pan/tilt range, replaced as a whole once a new one is built
+  std::shared_ptr<const HeadCollisionMap> collision_map_;
+  // Builds the collision map in the background, so the main loop is not blocked while MoveIt samples the grid
+  std::future<std::shared_ptr<const HeadCollisionMap>> collision_map_future_;
+
+  // Closed form look at solver and the last solution to avoid solving for the same target again
+  HeadLookAtSolver look_at_solver_;
+  Eigen::Vector3d last_look_at_target_;
+  std::optional<std::pair<double, double>> last_look_at_solution_;
+
   // Declare parameters and parameter listener
   move_head::Params params_;
   std::shared_ptr<move_head::ParamListener> param_listener_;
@@ -86,9 +443,22 @@ class HeadMover {
   double pan_speed_ = 0;
   double tilt_speed_ = 0;
 
+  // Trajectory through the current search pattern that is streamed by its own timer
+  rclcpp::TimerBase::SharedPtr trajectory_timer_;
+  bitbots_splines::SmoothSpline pan_trajectory_;
+  bitbots_splines::SmoothSpline tilt_trajectory_;
+  rclcpp::Time trajectory_start_time_;
+  // Time at which the approach to the first keyframe ends and the periodic part of the trajectory starts
+  double trajectory_loop_start_ = 0;
+  // Cleared by the look at action when it takes over the head, which runs in another callback group
+  std::atomic<bool> trajectory_active_{false};
+
   // Action server for the look at action
   rclcpp_action::Server<LookAtGoal>::SharedPtr action_server_;
-  bool action_running_ = false;
+  std::atomic<bool> action_running_{false};
+  // Goal that is currently executed by the look at timer
+  std::shared_ptr<LookAtGoalHandle> look_at_goal_handle_;
+  rclcpp::TimerBase::SharedPtr look_at_timer_;
 
  public:
   HeadMover() : node_(std::make_shared<rclcpp::Node>("head_mover")) {
@@ -99,9 +469,15 @@ class HeadMover {
     head_mode_subscriber_ = node_->create_subscription<bitbots_msgs::msg::HeadMode>(
         "head_mode", 10, [this](const bitbots_msgs::msg::HeadMode::SharedPtr msg) { head_mode_callback(msg); });
 
-    // Initialize subscriber for the current joint states of the robot
+    // Initialize subscriber for the current joint states of the robot in its own callback group,
+    // so the high frequency joint states are not delayed by the main loop
+    joint_state_callback_group_ = node_->create_callback_group(rclcpp::CallbackGroupType::MutuallyExclusive);
+    rclcpp::SubscriptionOptions joint_state_options;
+    joint_state_options.callback_group = joint_state_callback_group_;
     joint_state_subscriber_ = node_->create_subscription<sensor_msgs::msg::JointState>(
-        "joint_states", 1, [this](const sensor_msgs::msg::JointState::SharedPtr msg) { joint_state_callback(msg); });
+        "joint_states", 1,
+        [this](const sensor_msgs::msg::JointState::ConstSharedPtr msg) { joint_state_callback(msg); },
+        joint_state_options);
 
     // Create parameter listener and load initial set of parameters
     param_listener_ = std::make_shared<move_head::ParamListener>(node_);
@@ -152,6 +528,9 @@ class HeadMover {
     collision_state_.reset(new moveit::core::RobotState(robot_model_));
     collision_state_->setToDefaultValues();
 
+    // Derive the closed form look at solution from the robot model
+    init_look_at_solver();
+
     // Get planning scene for collision checking
     planning_scene_monitor_ = std::make_shared<planning_scene_monitor::PlanningSceneMonitor>(moveit_node, loader_);
     planning_scene_ = planning_scene_monitor_->getPlanningScene();
@@ -159,6 +538,9 @@ class HeadMover {
       RCLCPP_ERROR_ONCE(node_->get_logger(), "failed to connect to planning scene");
     }
 
+    // Start building or loading the collision map, so we do not need to query MoveIt during normal operation
+    update_collision_map();
+
     // Create tf buffer and listener to update it
     tf_buffer_ = std::make_shared<tf2_ros::Buffer>(node_->get_clock());
     tf_listener_ = std::make_shared<tf2_ros::TransformListener>(*tf_buffer_);
@@ -166,14 +548,24 @@ class HeadMover {
     // Initialize variables
     threshold_ = params_.position_reached_threshold * DEG_TO_RAD;
 
-    // Initialize action server for look at action
+    // Initialize action server for look at action and the timer that executes it in a separate callback group
+    action_callback_group_ = node_->create_callback_group(rclcpp::CallbackGroupType::MutuallyExclusive);
     action_server_ = rclcpp_action::create_server<LookAtGoal>(
         node_, "look_at_goal", std::bind(&HeadMover::handle_goal, this, std::placeholders::_1, std::placeholders::_2),
         std::bind(&HeadMover::handle_cancel, this, std::placeholders::_1),
-        std::bind(&HeadMover::handle_accepted, this, std::placeholders::_1));
+        std::bind(&HeadMover::handle_accepted, this, std::placeholders::_1), rcl_action_server_get_default_options(),
+        action_callback_group_);
+    look_at_timer_ =
+        rclcpp::create_timer(node_, node_->get_clock(), rclcpp::Duration::from_seconds(1.0 / params_.look_at.rate),
+                             [this] { execute_look_at(); }, action_callback_group_);
 
     // Initialize timer for main loop
     timer_ = rclcpp::create_timer(node_, node_->get_clock(), 50ms, [this] { behave(); });
+
+    // Initialize timer that streams the search pattern trajectory to the motors
+    trajectory_timer_ = rclcpp::create_timer(node_, node_->get_clock(),
+                                             rclcpp::Duration::from_seconds(1.0 / params_.trajectory.rate),
+                                             [this] { stream_trajectory(); });
   }
 
   /**
@@ -184,7 +576,24 @@ class HeadMover {
   /**
    * @brief Callback used to get updates of the current joint states of the robot
    */
-  void joint_state_callback(const sensor_msgs::msg::JointState::SharedPtr msg) { current_joint_state_ = *msg; }
+  void joint_state_callback(const sensor_msgs::msg::JointState::ConstSharedPtr& msg) {
+    // Resolve the indices of the head joints only if the layout of the message changed
+    if (!head_joint_indices_valid_ || head_pan_index_ >= msg->name.size() || head_tilt_index_ >= msg->name.size() ||
+        msg->name[head_pan_index_] != "HeadPan" || msg->name[head_tilt_index_] != "HeadTilt") {
+      auto pan = std::find(msg->name.begin(), msg->name.end(), "HeadPan");
+      auto tilt = std::find(msg->name.begin(), msg->name.end(), "HeadTilt");
+      head_joint_indices_valid_ = pan != msg->name.end() && tilt != msg->name.end();
+      if (!head_joint_indices_valid_) {
+        return;
+      }
+      head_pan_index_ = pan - msg->name.begin();
+      head_tilt_index_ = tilt - msg->name.begin();
+    }
+    if (head_pan_index_ >= msg->position.size() || head_tilt_index_ >= msg->position.size()) {
+      return;
+    }
+    head_joint_state_.write(msg->position[head_pan_index_], msg->position[head_tilt_index_]);
+  }
 
   /***
    * @brief Handles the goal request for the look at action
@@ -208,6 +617,8 @@ class HeadMover {
       return rclcpp_action::GoalResponse::REJECT;
     }
 
+    std::lock_guard<std::mutex> lock(control_mutex_);
+
     // Get the motor goals that are needed to look at the point
     std::pair<double, double> pan_tilt = get_motor_goals_from_point(new_point.point);
 
@@ -233,8 +644,6 @@ class HeadMover {
     // Avoid unused parameter warning
     (void)goal_handle;
     RCLCPP_INFO(node_->get_logger(), "Received request to cancel goal");
-    // Set the action_running_ flag to false, so that the action can be executed again
-    action_running_ = false;
     return rclcpp_action::CancelResponse::ACCEPT;
   }
 
@@ -244,58 +653,59 @@ class HeadMover {
    * @param goal_handle
    */
   void handle_accepted(const std::shared_ptr<LookAtGoalHandle> goal_handle) {
-    // Spawn a new thread that executes the look at action until we reach the goal
-    std::thread{std::bind(&HeadMover::execute_look_at, this, std::placeholders::_1), goal_handle}.detach();
+    // The goal is executed by the look at timer, which runs in the same callback group
+    action_running_ = true;
+    // Stop streaming the search pattern trajectory right away, so it does not command the head at the same time
+    trajectory_active_ = false;
+    look_at_goal_handle_ = goal_handle;
+    RCLCPP_INFO(node_->get_logger(), "Executing goal");
   }
 
   /**
-   * @brief Executes the look at action that looks at a specific point in a given frame until the goal is reached or the
-   * action is canceled
-   *
-   * @param goal_handle
+   * @brief Executes one step of the look at action that looks at a specific point in a given frame until the goal is
+   * reached or the action is canceled
    */
-  void execute_look_at(const std::shared_ptr<LookAtGoalHandle> goal_handle) {
-    // Yeah seems like we are executing the action
-    action_running_ = true;
-
-    RCLCPP_INFO(node_->get_logger(), "Executing goal");
-
-    // Get the goal from the goal handle
-    const auto goal = goal_handle->get_goal();
+  void execute_look_at() {
+    // Check if there is a goal to execute
+    if (!look_at_goal_handle_) {
+      return;
+    }
 
     // Create feedback and result messages
     auto feedback = std::make_shared<LookAtGoal::Feedback>();
-    // Flag that indicates whether the action was successful yet
-    bool success = false;
     auto result = std::make_shared<LookAtGoal::Result>();
 
-    // Execute the action until we reach the goal or the action is canceled
-    while (!success && rclcpp::ok()) {
-      RCLCPP_INFO(node_->get_logger(), "Looking at point");
+    // Check if the action was canceled and if so, set the result accordingly
+    if (look_at_goal_handle_->is_canceling()) {
+      look_at_goal_handle_->canceled(result);
+      look_at_goal_handle_.reset();
+      RCLCPP_INFO(node_->get_logger(), "Goal was canceled");
 
-      // Check if the action was canceled and if so, set the result accordingly
-      if (goal_handle->is_canceling()) {
-        goal_handle->canceled(result);
-        RCLCPP_INFO(node_->get_logger(), "Goal was canceled");
-        return;
-      }
-
-      // Look at the goal point
-      success = look_at(goal->look_at_position);
+      // Set the action_running_ flag to false, so that the action can be executed again
+      action_running_ = false;
+      return;
+    }
 
-      // Publish feedback to the client
-      goal_handle->publish_feedback(feedback);  // TODO: currently feedback is empty
+    // Look at the goal point
+    bool success;
+    {
+      std::lock_guard<std::mutex> lock(control_mutex_);
+      success = look_at(look_at_goal_handle_->get_goal()->look_at_position);
     }
 
-    // If we reach this point, the action was successful
-    if (rclcpp::ok()) {
+    // Publish feedback to the client
+    look_at_goal_handle_->publish_feedback(feedback);  // TODO: currently feedback is empty
+
+    // Finish the action once we reached the goal
+    if (success) {
       result->success = true;
-      goal_handle->succeed(result);
+      look_at_goal_handle_->succeed(result);
+      look_at_goal_handle_.reset();
       RCLCPP_INFO(node_->get_logger(), "Goal succeeded");
-    }
 
-    // Set the action_running_ flag to false, so that the action can be executed again
-    action_running_ = false;
+      // Set the action_running_ flag to false, so that the action can be executed again
+      action_running_ = false;
+    }
   }
 
   /**
@@ -406,15 +816,95 @@ class HeadMover {
    * @brief Checks if the head collides with the body at a given pan and tilt position
    */
   bool check_head_collision(double pan, double tilt) {
+    // Use the precomputed collision map if it is available for the current parameters
+    if (params_.collision_map.enabled && collision_map_ &&
+        collision_map_->covers(params_.max_pan[0], params_.max_pan[1], params_.max_tilt[0], params_.max_tilt[1],
+                               params_.collision_map.resolution * DEG_TO_RAD)) {
+      return collision_map_->in_collision(pan, tilt, params_.collision_map.conservative);
+    }
+    return check_head_collision_moveit(pan, tilt);
+  }
+
+  /**
+   * @brief Checks if the head collides with the body at a given pan and tilt position using a full MoveIt collision
+   * check
+   */
+  bool check_head_collision_moveit(double pan, double tilt) {
     collision_state_->setJointPositions("HeadPan", &pan);
     collision_state_->setJointPositions("HeadTilt", &tilt);
     collision_detection::CollisionRequest req;
     collision_detection::CollisionResult res;
-    collision_detection::AllowedCollisionMatrix acm = planning_scene_->getAllowedCollisionMatrix();
-    planning_scene_->checkCollision(req, res, *collision_state_, acm);
+    planning_scene_->checkCollision(req, res, *collision_state_, planning_scene_->getAllowedCollisionMatrix());
     return res.collision;
   }
 
+  /**
+   * @brief Takes over a collision map that finished building and starts building a new one in the background if the
+   * current one does not match the parameters. Until then, collisions are checked with MoveIt
+   */
+  void update_collision_map() {
+    if (collision_map_future_.valid() &&
+        collision_map_future_.wait_for(std::chrono::seconds(0)) == std::future_status::ready) {
+      collision_map_ = collision_map_future_.get();
+    }
+
+    if (!params_.collision_map.enabled || !planning_scene_ || collision_map_future_.valid()) {
+      return;
+    }
+
+    double resolution = params_.collision_map.resolution * DEG_TO_RAD;
+    if (collision_map_ && collision_map_->covers(params_.max_pan[0], params_.max_pan[1], params_.max_tilt[0],
+                                                 params_.max_tilt[1], resolution)) {
+      return;
+    }
+
+    // The parameters may change while the map is built, so the builder gets its own copy
+    collision_map_future_ = std::async(std::launch::async, [this, params = params_, resolution] {
+      return build_collision_map(params, resolution);
+    });
+  }
+
+  /**
+   * @brief Loads the collision map from the cache file or builds it using MoveIt. Runs in the background and uses its
+   * own robot state, so it does not interfere with the collision checks of the main loop
+   */
+  std::shared_ptr<const HeadCollisionMap> build_collision_map(const move_head::Params& params, double resolution) {
+    auto collision_map = std::make_shared<HeadCollisionMap>();
+    moveit::core::RobotState state(robot_model_);
+    state.setToDefaultValues();
+    auto moveit_check = [this, &state](double pan, double tilt) {
+      state.setJointPositions("HeadPan", &pan);
+      state.setJointPositions("HeadTilt", &tilt);
+      collision_detection::CollisionRequest req;
+      collision_detection::CollisionResult res;
+      planning_scene_->checkCollision(req, res, state, planning_scene_->getAllowedCollisionMatrix());
+      return res.collision;
+    };
+    const std::string& cache_file = params.collision_map.cache_file;
+
+    // Try to load a cached collision map and check some random samples to make sure the robot model did not change
+    if (!cache_file.empty() && collision_map->load(cache_file, params.max_pan[0], params.max_pan[1],
+                                                   params.max_tilt[0], params.max_tilt[1], resolution)) {
+      if (collision_map->validate(params.collision_map.validation_samples, moveit_check)) {
+        RCLCPP_INFO(node_->get_logger(), "Loaded head collision map from %s", cache_file.c_str());
+        return collision_map;
+      }
+      RCLCPP_WARN(node_->get_logger(), "Cached head collision map %s does not match the robot model, rebuilding it",
+                  cache_file.c_str());
+    }
+
+    auto start = std::chrono::steady_clock::now();
+    collision_map->build(params.max_pan[0], params.max_pan[1], params.max_tilt[0], params.max_tilt[1], resolution,
+                         moveit_check);
+    RCLCPP_INFO(node_->get_logger(), "Built head collision map with %zu samples in %.2f s", collision_map->size(),
+                std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count());
+
+    if (!cache_file.empty() && !collision_map->save(cache_file)) {
+      RCLCPP_WARN(node_->get_logger(), "Could not write head collision map to %s", cache_file.c_str());
+    }
+    return collision_map;
+  }
+
   /**
    * @brief Move the head to the target position but adjust the speed of the joints so both reach the goal at the same
    * time
@@ -449,20 +939,7 @@ class HeadMover {
   /**
    * @brief Returns the current position of the head motors
    */
-  std::pair<double, double> get_head_position() {
-    double head_pan = 0.0;
-    double head_tilt = 0.0;
-
-    // Iterate over all joints and find the head pan and tilt joints
-    for (size_t i = 0; i < current_joint_state_->name.size(); i++) {
-      if (current_joint_state_->name[i] == "HeadPan") {
-        head_pan = current_joint_state_->position[i];
-      } else if (current_joint_state_->name[i] == "HeadTilt") {
-        head_tilt = current_joint_state_->position[i];
-      }
-    }
-    return {head_pan, head_tilt};
-  }
+  std::pair<double, double> get_head_position() { return head_joint_state_.read(); }
 
   /**
    * @brief Converts a scanline number to a tilt angle
@@ -574,16 +1051,74 @@ class HeadMover {
   }
 
   /**
-   * @brief Calculates the motor goals that are needed to look at a given point using the inverse kinematics
+   * @brief Extracts the geometry of the head kinematic chain for the closed form look at solution
+   */
+  void init_look_at_solver() {
+    if (!robot_model_) {
+      return;
+    }
+    auto pan_joint = dynamic_cast<const moveit::core::RevoluteJointModel*>(robot_model_->getJointModel("HeadPan"));
+    auto tilt_joint = dynamic_cast<const moveit::core::RevoluteJointModel*>(robot_model_->getJointModel("HeadTilt"));
+    auto camera_link = robot_model_->getLinkModel("camera");
+    if (!pan_joint || !tilt_joint || !camera_link) {
+      RCLCPP_WARN(node_->get_logger(), "Head chain not found in the robot model, using BioIK for look at goals");
+      return;
+    }
+
+    // Get the link transforms with the head in its zero position
+    moveit::core::RobotState state(robot_model_);
+    state.setToDefaultValues();
+    double zero = 0.0;
+    state.setJointPositions(pan_joint, &zero);
+    state.setJointPositions(tilt_joint, &zero);
+    state.update();
+
+    if (!look_at_solver_.init(state.getGlobalLinkTransform(pan_joint->getChildLinkModel()), pan_joint->getAxis(),
+                              state.getGlobalLinkTransform(tilt_joint->getChildLinkModel()), tilt_joint->getAxis(),
+                              state.getGlobalLinkTransform(camera_link), Eigen::Vector3d::UnitX())) {
+      RCLCPP_WARN(node_->get_logger(), "Head chain can not be solved analytically, using BioIK for look at goals");
+    }
+  }
+
+  /**
+   * @brief Calculates the motor goals that are needed to look at a given point
    */
   std::pair<double, double> get_motor_goals_from_point(geometry_msgs::msg::Point point) {
+    Eigen::Vector3d target(point.x, point.y, point.z);
+
+    // Reuse the previous solution if the target did not move
+    if (last_look_at_solution_ && (target - last_look_at_target_).norm() <= params_.look_at.ik_cache_tolerance) {
+      return *last_look_at_solution_;
+    }
+
+    // Use the closed form solution if possible and fall back to BioIK otherwise
+    std::optional<std::pair<double, double>> solution;
+    if (params_.look_at.analytic_ik) {
+      solution = look_at_solver_.solve(target);
+    }
+    if (!solution) {
+      solution = get_motor_goals_from_point_bio_ik(target);
+    }
+    if (!solution) {
+      return {0.0, 0.0};
+    }
+
+    last_look_at_target_ = target;
+    last_look_at_solution_ = solution;
+    return *solution;
+  }
+
+  /**
+   * @brief Calculates the motor goals that are needed to look at a given point using the inverse kinematics
+   */
+  std::optional<std::pair<double, double>> get_motor_goals_from_point_bio_ik(const Eigen::Vector3d& point) {
     // Create a new IK options object
     bio_ik::BioIKKinematicsQueryOptions ik_options;
     ik_options.return_approximate_solution = true;
     ik_options.replace = true;
 
     // Create a new look at goal and set the target point as the position the camera link should look at
-    ik_options.goals.emplace_back(new bio_ik::LookAtGoal("camera", {1.0, 0.0, 0.0}, {point.x, point.y, point.z}));
+    ik_options.goals.emplace_back(new bio_ik::LookAtGoal("camera", {1.0, 0.0, 0.0}, {point.x(), point.y(), point.z()}));
 
     // Get the joint model group for the head
     auto joint_model_group = robot_model_->getJointModelGroup("Head");
@@ -592,19 +1127,15 @@ class HeadMover {
     double timeout_seconds = 1.0;
     bool success = robot_state_->setFromIK(joint_model_group, EigenSTL::vector_Isometry3d(), std::vector<std::string>(),
                                            timeout_seconds, moveit::core::GroupStateValidityCallbackFn(), ik_options);
-    robot_state_->update();
 
-    // Get the solution from the IK response
-    bio_ik_msgs::msg::IKResponse response;
-    moveit::core::robotStateToRobotStateMsg(*robot_state_, response.solution);
-    response.solution_fitness = ik_options.solution_fitness;
     // Return the motor goals if the IK was successful
     if (success) {
-      return {response.solution.joint_state.position[0], response.solution.joint_state.position[1]};
+      return std::make_pair(robot_state_->getVariablePosition("HeadPan"),
+                            robot_state_->getVariablePosition("HeadTilt"));
     } else {
       RCLCPP_ERROR_STREAM_THROTTLE(node_->get_logger(), *node_->get_clock(), 1000,
-                                   "BioIK failed with error code: " << response.error_code.val);
-      return {0.0, 0.0};
+                                   "BioIK failed with fitness: " << ik_options.solution_fitness);
+      return std::nullopt;
     }
   }
 
@@ -641,29 +1172,113 @@ class HeadMover {
   }
 
   /**
-   * @brief Returns the index of the pattern keypoint that is closest to the current head position
-   *
-   * @param pattern The search pattern
-   * @param pan The current pan position
-   * @param tilt The current tilt position
-   * @return int The index of the pattern keypoint that is closest to the current head position
-   */
-  int get_near_pattern_position(std::vector<std::pair<double, double>> pattern, double pan, double tilt) {
-    // Store the index and distance of the closest keypoint
-    std::pair<double, int> min_distance_point = {10000.0, -1};
-    // Iterate over all keypoints and calculate the distance to the current head position
-    for (size_t i = 0; i < pattern.size(); i++) {
-      // Calculate the cartesian distance between the current head position and the keypoint
-      double distance = std::sqrt(std::pow(pattern[i].first - pan, 2) + std::pow(pattern[i].second - tilt, 2));
-      // Check if the distance is smaller than the current minimum distance
-      // and if so, update the minimum distance accordingly
-      if (distance < min_distance_point.first) {
-        min_distance_point.first = distance;
-        min_distance_point.second = i;
+   * @brief Returns the velocity of one axis at a keyframe that is passed through. The velocity is zero if the axis
+   * stops or reverses at the keyframe and limited otherwise, so the trajectory does not overshoot the keyframes.
+   */
+  double keyframe_velocity(double previous, double current, double next, double previous_duration,
+                           double next_duration) {
+    double previous_slope = (current - previous) / previous_duration;
+    double next_slope = (next - current) / next_duration;
+    if (previous_slope * next_slope <= 0) {
+      return 0;
+    }
+    double velocity = (next - previous) / (previous_duration + next_duration);
+    double limit = 3 * std::min(std::abs(previous_slope), std::abs(next_slope));
+    return std::clamp(velocity, -limit, limit);
+  }
+
+  /**
+   * @brief Plans a smooth trajectory from the current head position through all keyframes of the search pattern,
+   * starting at the closest keyframe. The keyframes after the first one form a closed loop that is repeated.
+   */
+  void plan_search_pattern_trajectory() {
+    pan_trajectory_ = bitbots_splines::SmoothSpline();
+    tilt_trajectory_ = bitbots_splines::SmoothSpline();
+
+    auto [current_pan, current_tilt] = get_head_position();
+    index_ = get_near_pattern_position(pattern_, current_pan, current_tilt);
+
+    // Limit the scan speed so the camera does not rotate more than the allowed motion blur during one exposure
+    double max_scan_speed = params_.trajectory.max_motion_blur * DEG_TO_RAD / params_.trajectory.exposure_time;
+    double pan_speed = std::min(pan_speed_, max_scan_speed);
+    double tilt_speed = std::min(tilt_speed_, max_scan_speed);
+
+    // Collect the keyframes in the order they are visited, the first keyframe is repeated to close the loop
+    size_t keyframe_count = pattern_.size();
+    std::vector<std::pair<double, double>> keyframes;
+    for (size_t i = 0; i <= keyframe_count; i++) {
+      const auto& keyframe = pattern_[(index_ + i) % keyframe_count];
+      keyframes.emplace_back(keyframe.first * DEG_TO_RAD, keyframe.second * DEG_TO_RAD);
+    }
+
+    // Calculate the time at which each keyframe is reached.
+    // A quintic between two rests peaks at 15/8 of its average velocity, so this keeps the peak below the speed limit.
+    auto segment_duration = [&](const std::pair<double, double>& from, const std::pair<double, double>& to) {
+      return std::max({15.0 / 8.0 * std::abs(to.first - from.first) / pan_speed,
+                       15.0 / 8.0 * std::abs(to.second - from.second) / tilt_speed,
+                       params_.trajectory.min_segment_duration});
+    };
+    std::vector<double> times = {segment_duration({current_pan, current_tilt}, keyframes[0])};
+    for (size_t i = 1; i <= keyframe_count; i++) {
+      times.push_back(times.back() + segment_duration(keyframes[i - 1], keyframes[i]));
+    }
+
+    // Start at rest at the current head position
+    pan_trajectory_.points().push_back({0, current_pan, 0, 0});
+    tilt_trajectory_.points().push_back({0, current_tilt, 0, 0});
+
+    // Pass through the keyframes, the neighbours of the first and last keyframe are taken from the loop
+    for (size_t i = 0; i <= keyframe_count; i++) {
+      size_t previous = i == 0 ? keyframe_count - 1 : i - 1;
+      size_t next = i == keyframe_count ? 1 : i + 1;
+      double previous_duration = i == 0 ? times[keyframe_count] - times[keyframe_count - 1] : times[i] - times[i - 1];
+      double next_duration = i == keyframe_count ? times[1] - times[0] : times[i + 1] - times[i];
+      if (keyframe_count == 1) {
+        previous = next = 0;
       }
+      pan_trajectory_.points().push_back(
+          {times[i], keyframes[i].first,
+           keyframe_velocity(keyframes[previous].first, keyframes[i].first, keyframes[next].first, previous_duration,
+                             next_duration),
+           0});
+      tilt_trajectory_.points().push_back(
+          {times[i], keyframes[i].second,
+           keyframe_velocity(keyframes[previous].second, keyframes[i].second, keyframes[next].second,
+                             previous_duration, next_duration),
+           0});
+    }
+    pan_trajectory_.computeSplines();
+    tilt_trajectory_.computeSplines();
+
+    trajectory_loop_start_ = times[0];
+    trajectory_start_time_ = node_->now();
+    trajectory_active_ = true;
+  }
+
+  /**
+   * @brief Samples the current search pattern trajectory and sends it to the head motors
+   */
+  void stream_trajectory() {
+    if (!trajectory_active_ || action_running_ || pan_trajectory_.size() == 0) {
+      return;
     }
-    // Return the index of the closest keypoint
-    return min_distance_point.second;
+
+    // Repeat the periodic part of the trajectory after the approach to the first keyframe
+    double t = (node_->now() - trajectory_start_time_).seconds();
+    double end = pan_trajectory_.max();
+    if (t > end) {
+      t = trajectory_loop_start_ + std::fmod(t - trajectory_loop_start_, end - trajectory_loop_start_);
+    }
+
+    bitbots_msgs::msg::JointCommand pos_msg;
+    pos_msg.header.stamp = node_->now();
+    pos_msg.joint_names = {"HeadPan", "HeadTilt"};
+    pos_msg.positions = {pan_trajectory_.pos(t), tilt_trajectory_.pos(t)};
+    pos_msg.velocities = {pan_speed_, tilt_speed_};
+    pos_msg.accelerations = {params_.max_acceleration_pan, params_.max_acceleration_tilt};
+    pos_msg.max_currents = {-1, -1};
+
+    position_publisher_->publish(pos_msg);
   }
 
   /**
@@ -674,6 +1289,16 @@ class HeadMover {
     if (pattern_.size() == 0) {
       return;
     }
+
+    // The trajectory is sent to the motors by its own timer, so it only needs to be planned once
+    if (params_.trajectory.enabled) {
+      if (!trajectory_active_) {
+        plan_search_pattern_trajectory();
+      }
+      return;
+    }
+    trajectory_active_ = false;
+
     // Wrap the index that points to the current keypoint around if necessary
     index_ = index_ % int(pattern_.size());
     // Get the current keypoint and convert it to radians
@@ -703,14 +1328,19 @@ class HeadMover {
    * @brief Callback for the ticks of the main loop
    */
   void behave() {
+    std::lock_guard<std::mutex> lock(control_mutex_);
+
     // Get the current head mode
     uint curr_head_mode = head_mode_;
 
     // Pull the parameters from the parameter server
     params_ = param_listener_->get_params();
 
+    // Swap in a finished collision map or rebuild it in the background if the relevant parameters changed
+    update_collision_map();
+
     // Check if we received the joint states yet and if not, return
-    if (!current_joint_state_) {
+    if (!head_joint_state_.received()) {
       return;
     }
 
@@ -768,6 +1398,9 @@ class HeadMover {
 
       // Select the closest keypoint in the search pattern as a starting point
       index_ = get_near_pattern_position(pattern_, head_position.first, head_position.second);
+
+      // Plan a new trajectory for the new search pattern
+      trajectory_active_ = false;
     }
     // Check if no look at action is running or if the head mode is DONT_MOVE
     // if this is not the case, perform the search pattern
@@ -778,6 +1411,9 @@ class HeadMover {
       prev_head_mode_ = curr_head_mode;
       // Execute the search pattern
       perform_search_pattern();
+    } else {
+      // Stop streaming the trajectory, it is planned again from the current head position once we continue
+      trajectory_active_ = false;
     }
   }
 
@@ -790,7 +1426,8 @@ class HeadMover {
 
 int main(int argc, char* argv[]) {
   rclcpp::init(argc, argv);
-  rclcpp::experimental::executors::EventsExecutor exec;
+  // Use multiple threads, so the joint states and the look at action are handled in parallel to the main loop
+  rclcpp::executors::MultiThreadedExecutor exec(rclcpp::ExecutorOptions(), 3);
   auto head_mover = std::make_shared<move_head::HeadMover>();
   exec.add_node(head_mover->get_node());
   exec.spin();
@@ -0,0 +1,32 @@
+#include <gtest/gtest.h>
+
+#include <bitbots_head_mover/search_pattern.hpp>
+#include <cmath>
+#include <vector>
+
+using namespace move_head;
+
+namespace {
+constexpr double DEG = M_PI / 180;
+
+// Pattern in degrees, like the generated search patterns
+const std::vector<std::pair<double, double>> PATTERN = {{-60, 0}, {0, 0}, {60, 0}, {60, -30}, {0, -30}, {-60, -30}};
+}  // namespace
+
+TEST(SearchPattern, EmptyPattern) { EXPECT_EQ(get_near_pattern_position({}, 0, 0), -1); }
+
+TEST(SearchPattern, CenterPose) { EXPECT_EQ(get_near_pattern_position(PATTERN, 0, 0), 1); }
+
+TEST(SearchPattern, HeadPoseInRadians) {
+  // The head pose is given in radians and compared with the pattern in degrees
+  EXPECT_EQ(get_near_pattern_position(PATTERN, 55 * DEG, -5 * DEG), 2);
+  EXPECT_EQ(get_near_pattern_position(PATTERN, 50 * DEG, -25 * DEG), 3);
+  EXPECT_EQ(get_near_pattern_position(PATTERN, -50 * DEG, -28 * DEG), 5);
+  EXPECT_EQ(get_near_pattern_position(PATTERN, 10 * DEG, -20 * DEG), 4);
+}
+
+TEST(SearchPattern, SmallRadianPoseIsNotTheCenter) {
+  // 1 rad is about 57 degrees, which is close to the right keyframe and far from the center
+  EXPECT_EQ(get_near_pattern_position(PATTERN, 1.0, 0.0), 2);
+  EXPECT_EQ(get_near_pattern_position(PATTERN, -1.0, -0.5), 5);
+}
@@ -104,6 +104,9 @@ class WalkEngine : public bitbots_splines::AbstractEngine<WalkRequest, WalkRespo
   bitbots_splines::SmoothSpline is_left_support_foot_spline_;
   bitbots_splines::PoseSpline trunk_spline_;
   bitbots_splines::PoseSpline foot_spline_;
+  // last evaluated parts of the support splines, the trajectory time only increases during a half step
+  size_t is_double_support_cursor_ = 0;
+  size_t is_left_support_foot_cursor_ = 0;
 
   // Movement phase between 0 and 1
   double phase_ = 0.0;
@@ -775,8 +775,8 @@ WalkResponse WalkEngine::createResponse() {
   // Evaluate target cartesian state from trajectories at current trajectory time
   double time = getTrajsTime();
   WalkResponse response;
-  response.is_double_support = is_double_support_spline_.pos(time) >= 0.5;
-  response.is_left_support_foot = is_left_support_foot_spline_.pos(time) >= 0.5;
+  response.is_double_support = is_double_support_spline_.state(time, is_double_support_cursor_).pos >= 0.5;
+  response.is_left_support_foot = is_left_support_foot_spline_.state(time, is_left_support_foot_cursor_).pos >= 0.5;
   response.support_foot_to_flying_foot = foot_spline_.getTfTransform(time);
   response.support_foot_to_trunk = trunk_spline_.getTfTransform(time);
 
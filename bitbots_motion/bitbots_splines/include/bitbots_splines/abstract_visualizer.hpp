@@ -3,7 +3,9 @@
 
 #include <tf2/LinearMath/Vector3.h>
 
+#include <algorithm>
 #include <bitbots_splines/pose_spline.hpp>
+#include <stdexcept>
 #include <visualization_msgs/msg/marker.hpp>
 #include <visualization_msgs/msg/marker_array.hpp>
 
@@ -12,6 +14,8 @@ namespace bitbots_splines {
 class AbstractVisualizer {
  protected:
   int id = 0;
+  // reused for the path samples, so that drawing the path does not allocate each time
+  PoseSpline::Samples samples_;
   /**
    * Utility function to create a visualization marker for a position with default properties.
    * @param position The position of the marker
@@ -44,11 +48,14 @@ class AbstractVisualizer {
    * Utility function to create a visualization marker for a trajectory with default properties.
    * @param spline A PoseSpline containing the splines to be displayed
    * @param frame The frame in which the splines are given
-   * @param smoothness The smoothness of the splines
+   * @param smoothness The smoothness of the splines, the number of sampled intervals. Has to be positive
    * @return The visualization markers
    */
   visualization_msgs::msg::MarkerArray getPath(bitbots_splines::PoseSpline &spline, const std::string &frame,
                                                const double smoothness, rclcpp::Node::SharedPtr node) {
+    if (!(smoothness > 0)) {
+      throw std::logic_error("AbstractVisualizer smoothness has to be positive");
+    }
     visualization_msgs::msg::MarkerArray marker_array;
     visualization_msgs::msg::Marker base_marker;
     base_marker.action = visualization_msgs::msg::Marker::ADD;
@@ -69,15 +76,15 @@ class AbstractVisualizer {
     double first_time = spline.x()->min();
     double last_time = spline.x()->max();
 
-    // Iterate over splines, get points everywhere
+    // Sample the splines everywhere
     // Taking the manually set points is not enough because velocities and accelerations influence the curve
-    for (double i = first_time; i <= last_time; i += (last_time - first_time) / smoothness) {
-      geometry_msgs::msg::Point point;
-      point.x = spline.x()->pos(i);
-      point.y = spline.y()->pos(i);
-      point.z = spline.z()->pos(i);
-
-      path_marker.points.push_back(point);
+    size_t sample_count = std::max(static_cast<size_t>(smoothness), size_t(1)) + 1;
+    spline.sampleGrid(first_time, last_time, sample_count, samples_);
+    path_marker.points.resize(sample_count);
+    for (size_t i = 0; i < sample_count; i++) {
+      path_marker.points[i].x = samples_.x[i];
+      path_marker.points[i].y = samples_.y[i];
+      path_marker.points[i].z = samples_.z[i];
     }
     marker_array.markers.push_back(path_marker);
 
@@ -104,19 +111,20 @@ class AbstractVisualizer {
     for (double time : times) {
       orientation_marker.id = id++;
       orientation_marker.pose.position = spline.getGeometryMsgPosition(time);
+      tf2::Quaternion orientation = spline.getOrientation(time);
 
       // We use three axes for every orientation
       // x
       orientation_marker.color.b = 0;
       orientation_marker.color.r = 1;
-      tf2::Quaternion x_rotation = spline.getOrientation(time) * tf2::Vector3(1, 0, 0);
+      tf2::Quaternion x_rotation = orientation * tf2::Vector3(1, 0, 0);
       orientation_marker.pose.orientation = tf2::toMsg(x_rotation.normalize());
       marker_array.markers.push_back(orientation_marker);
 
       // y
       orientation_marker.color.r = 0;
       orientation_marker.color.g = 1;
-      tf2::Quaternion y_rotation = spline.getOrientation(time) * tf2::Vector3(1, 1, 0);
+      tf2::Quaternion y_rotation = orientation * tf2::Vector3(1, 1, 0);
       orientation_marker.pose.orientation = tf2::toMsg(y_rotation.normalize());
       orientation_marker.id = id++;
       marker_array.markers.push_back(orientation_marker);
@@ -124,7 +132,7 @@ class AbstractVisualizer {
       // z
       orientation_marker.color.g = 0;
       orientation_marker.color.b = 1;
-      tf2::Quaternion z_rotation = spline.getOrientation(time) * tf2::Vector3(1, 0, 1);
+      tf2::Quaternion z_rotation = orientation * tf2::Vector3(1, 0, 1);
       orientation_marker.pose.orientation = tf2::toMsg(z_rotation.normalize());
       orientation_marker.id = id++;
       marker_array.markers.push_back(orientation_marker);
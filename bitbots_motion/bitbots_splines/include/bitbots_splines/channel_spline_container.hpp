@@ -0,0 +1,157 @@
+#ifndef BITBOTS_SPLINES_INCLUDE_BITBOTS_SPLINES_CHANNEL_SPLINE_CONTAINER_H_
+#define BITBOTS_SPLINES_INCLUDE_BITBOTS_SPLINES_CHANNEL_SPLINE_CONTAINER_H_
+
+#include <algorithm>
+#include <array>
+#include <bitbots_splines/smooth_spline.hpp>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+namespace bitbots_splines {
+
+/**
+ * ChannelSplineContainer
+ *
+ * Splines for a fixed set of channels, as an alternative to the
+ * SplineContainer for engines that always use the same channels.
+ * The splines are stored contiguously and accessed by the channel
+ * enum without any lookup. Names are resolved at compile time by
+ * index(), the string interface is kept for dynamic use.
+ *
+ * The layout defines the channels and their names, the values of
+ * the enum have to be 0 to the number of names - 1, e.g.:
+ *
+ * struct FootLayout {
+ *   enum Channel { X, Y, Z };
+ *   static constexpr std::array<const char *, 3> names = {"x", "y", "z"};
+ * };
+ * ChannelSplineContainer<SmoothSpline, FootLayout> splines;
+ * splines.get<FootLayout::X>().addPoint(0.0, 1.0);
+ */
+template <class T, class Layout>
+class ChannelSplineContainer {
+ public:
+  using Channel = typename Layout::Channel;
+  static constexpr size_t COUNT = Layout::names.size();
+
+  /**
+   * Return the index of the channel with the given name.
+   * In a constant expression, an unknown name is a compile error
+   */
+  static constexpr size_t index(const char *name) {
+    for (size_t i = 0; i < COUNT; i++) {
+      if (equal(Layout::names[i], name)) {
+        return i;
+      }
+    }
+    throw std::logic_error("ChannelSplineContainer invalid name: " + std::string(name));
+  }
+
+  /**
+   * Return the name of the given channel
+   */
+  static constexpr const char *name(Channel channel) { return Layout::names[static_cast<size_t>(channel)]; }
+
+  /**
+   * Return the number of contained splines
+   */
+  static constexpr size_t size() { return COUNT; }
+
+  /**
+   * Access to the spline of the given channel
+   */
+  template <Channel C>
+  const T &get() const {
+    static_assert(static_cast<size_t>(C) < COUNT, "ChannelSplineContainer invalid channel");
+    return container_[static_cast<size_t>(C)];
+  }
+  template <Channel C>
+  T &get() {
+    static_assert(static_cast<size_t>(C) < COUNT, "ChannelSplineContainer invalid channel");
+    return container_[static_cast<size_t>(C)];
+  }
+  const T &get(Channel channel) const { return container_[static_cast<size_t>(channel)]; }
+  T &get(Channel channel) { return container_[static_cast<size_t>(channel)]; }
+
+  /**
+   * Access to the spline with the given name,
+   * searches the names at runtime
+   */
+  const T &get(const std::string &name) const { return container_[index(name.c_str())]; }
+  T &get(const std::string &name) { return container_[index(name.c_str())]; }
+
+  /**
+   * Return true if given spline
+   * name is contained
+   */
+  static bool exist(const std::string &name) {
+    return std::any_of(Layout::names.begin(), Layout::names.end(),
+                       [&name](const char *channel_name) { return name == channel_name; });
+  }
+
+  /**
+   * Access to internal array, indexed by the channels
+   */
+  const std::array<T, COUNT> &get() const { return container_; }
+  std::array<T, COUNT> &get() { return container_; }
+
+  /**
+   * Writes all time points where a point in any spline exists
+   * into the given vector, which does not allocate when it is reused.
+   */
+  void getTimes(std::vector<double> &times) const {
+    times.clear();
+    for (const T &spline : container_) {
+      for (const SmoothSpline::Point &point : spline.points()) {
+        times.push_back(point.time);
+      }
+    }
+    std::sort(times.begin(), times.end());
+    times.erase(std::unique(times.begin(), times.end()), times.end());
+  }
+  std::vector<double> getTimes() const {
+    std::vector<double> times;
+    getTimes(times);
+    return times;
+  }
+
+  /**
+   * Return minimum and maximum abscisse values
+   * of all registered splines parts
+   */
+  double min() const {
+    double m = container_[0].min();
+    for (const T &spline : container_) {
+      m = std::min(m, spline.min());
+    }
+    return m;
+  }
+  double max() const {
+    double m = container_[0].max();
+    for (const T &spline : container_) {
+      m = std::max(m, spline.max());
+    }
+    return m;
+  }
+
+ private:
+  static_assert(COUNT > 0, "ChannelSplineContainer needs at least one channel");
+
+  static constexpr bool equal(const char *a, const char *b) {
+    while (*a != '\0' && *a == *b) {
+      a++;
+      b++;
+    }
+    return *a == *b;
+  }
+
+  /**
+   * Splines indexed by their channel
+   */
+  std::array<T, COUNT> container_;
+};
+
+}  // namespace bitbots_splines
+
+#endif
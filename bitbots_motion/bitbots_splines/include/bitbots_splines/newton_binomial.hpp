@@ -8,6 +8,8 @@ https://github.com/Rhoban/model/
 
 #include <stddef.h>
 
+#include <cmath>
+
 #include "combination.hpp"
 #include "polynom.hpp"
 
@@ -25,9 +27,20 @@ class NewtonBinomial {
   /**
    * Expand the given formula (x + y)^degree
    * and return the polynom in x whose coefficient
-   * are computed using binomial coefficient
+   * are computed using binomial coefficient.
+   * The degree has to be at most N.
    */
-  static Polynom expandPolynom(double y, unsigned int degree);
+  template <size_t N>
+  static Polynom<N> expandPolynom(double y, unsigned int degree) {
+    Combination combination;
+
+    Polynom<N> polynom;
+    for (size_t k = 0; k <= degree; k++) {
+      polynom(k) = combination.binomialCoefficient(k, degree) * pow(y, degree - k);
+    }
+
+    return polynom;
+  }
 
  private:
 };
@@ -6,80 +6,180 @@ https://github.com/Rhoban/model/
 #ifndef BITBOTS_SPLINES_INCLUDE_BITBOTS_SPLINES_POLYNOM_H_
 #define BITBOTS_SPLINES_INCLUDE_BITBOTS_SPLINES_POLYNOM_H_
 
+#include <array>
 #include <cstdlib>
 #include <iostream>
-#include <vector>
 
 namespace bitbots_splines {
 
+/**
+ * Value, first and second derivative
+ * of a polynom or spline at one abscisse
+ */
+struct PolynomState {
+  double pos;
+  double vel;
+  double acc;
+};
+
 /**
  * Polynom
  *
- * Simple one dimensional
- * polynom class for spline
- * generation
+ * Simple one dimensional polynom class
+ * for spline generation with a degree
+ * that is fixed at compile time.
+ * Coefficients are stored inline and all
+ * evaluations use the Horner scheme,
+ * so nothing is allocated.
  */
+template <size_t N>
 class Polynom {
  public:
   /**
-   * Default and initial degree initialization
+   * All coefficients are initialized to zero
    */
-  Polynom();
-  explicit Polynom(unsigned int degree);
+  Polynom() : coefs_() {}
 
   /**
    * Access to coefficient
    * indexed from constant to
    * higher degree
    */
-  const std::vector<double> &getCoefs() const;
-  std::vector<double> &getCoefs();
+  const std::array<double, N + 1> &getCoefs() const { return coefs_; }
+  std::array<double, N + 1> &getCoefs() { return coefs_; }
 
   /**
    * Access to coefficient
    */
-  const double &operator()(size_t index) const;
-  double &operator()(size_t index);
+  const double &operator()(size_t index) const { return coefs_[index]; }
+  double &operator()(size_t index) { return coefs_[index]; }
 
   /**
    * Return polynom degree
-   * -1 mean empty polynom
    */
-  size_t degree() const;
+  static constexpr size_t degree() { return N; }
 
   /**
    * Polynom evaluation, its first,
    * second and third derivative at given x
    */
-  double pos(double x) const;
-  double vel(double x) const;
-  double acc(double x) const;
-  double jerk(double x) const;
+  double pos(double x) const {
+    double val = coefs_[N];
+    for (size_t i = N; i-- > 0;) {
+      val = val * x + coefs_[i];
+    }
+    return val;
+  }
+  double vel(double x) const {
+    double val = 0.0;
+    for (size_t i = N; i >= 1; i--) {
+      val = val * x + i * coefs_[i];
+    }
+    return val;
+  }
+  double acc(double x) const {
+    double val = 0.0;
+    for (size_t i = N; i >= 2; i--) {
+      val = val * x + (i - 1) * i * coefs_[i];
+    }
+    return val;
+  }
+  double jerk(double x) const {
+    double val = 0.0;
+    for (size_t i = N; i >= 3; i--) {
+      val = val * x + (i - 2) * (i - 1) * i * coefs_[i];
+    }
+    return val;
+  }
+
+  /**
+   * Polynom evaluation at n abscisses, written
+   * to values. Both may be the same buffer.
+   * The loop is vectorized by the compiler
+   */
+  void pos(const double *x, size_t n, double *values) const {
+    // a local copy of the coefficients cannot alias the output
+    const std::array<double, N + 1> coefs = coefs_;
+    for (size_t i = 0; i < n; i++) {
+      double val = coefs[N];
+      for (size_t j = N; j-- > 0;) {
+        val = val * x[i] + coefs[j];
+      }
+      values[i] = val;
+    }
+  }
+
+  /**
+   * Polynom value, first and second derivative
+   * at given x, computed in a single Horner pass
+   */
+  PolynomState state(double x) const {
+    double pos = coefs_[N];
+    double vel = 0.0;
+    double acc = 0.0;
+    for (size_t i = N; i-- > 0;) {
+      acc = acc * x + vel;
+      vel = vel * x + pos;
+      pos = pos * x + coefs_[i];
+    }
+    // the Horner pass yields the Taylor coefficients, the second derivative is twice the second one
+    return {pos, vel, 2.0 * acc};
+  }
 
   /**
    * Some useful operators
    */
-  void operator*=(double coef);
-  void operator+=(const Polynom &p);
+  void operator*=(double coef) {
+    for (double &_coef : coefs_) {
+      _coef *= coef;
+    }
+  }
+  void operator+=(const Polynom &p) {
+    for (size_t i = 0; i <= N; i++) {
+      coefs_[i] += p.coefs_[i];
+    }
+  }
 
   /**
    * Update the polynom coefficients
    * by applying delta offset
    * on X abscisse
    */
-  void shift(double delta);
+  void shift(double delta) {
+    // repeated synthetic division (Taylor shift), equivalent to expanding
+    // each (x + delta)^k with the Newton binomial
+    for (size_t k = 0; k < N; k++) {
+      for (size_t i = N - 1; i + 1 > k; i--) {
+        coefs_[i] += delta * coefs_[i + 1];
+      }
+    }
+  }
 
  private:
   /**
    * Polynom coefficients
    */
-  std::vector<double> coefs_;
+  std::array<double, N + 1> coefs_;
 };
 
+/**
+ * Fifth order polynom, used by all
+ * spline parts
+ */
+using QuinticPolynom = Polynom<5>;
+
 /**
  * Print operator
  */
-std::ostream &operator<<(std::ostream &os, const Polynom &p);
+template <size_t N>
+std::ostream &operator<<(std::ostream &os, const Polynom<N> &p) {
+  os << "degree=" << p.degree() << " ";
+  for (size_t i = 0; i < p.degree() + 1; i++) {
+    os << p(i) << " ";
+  }
+
+  return os;
+}
 
 }  // namespace bitbots_splines
 
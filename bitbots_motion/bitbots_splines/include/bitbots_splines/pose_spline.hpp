@@ -5,6 +5,7 @@
 #include <tf2/LinearMath/Transform.h>
 #include <tf2/LinearMath/Vector3.h>
 
+#include <array>
 #include <bitbots_splines/smooth_spline.hpp>
 #include <bitbots_splines/spline_container.hpp>
 #include <geometry_msgs/msg/point.hpp>
@@ -15,8 +16,54 @@
 
 namespace bitbots_splines {
 
+/**
+ * Six dimensional spline of a pose, the orientation is given by euler angles.
+ * Each channel keeps a cursor to its last evaluated part, so evaluating the spline at increasing times does not
+ * search the parts again.
+ */
 class PoseSpline {
  public:
+  /**
+   * Position, orientation and their derivatives at one time
+   */
+  struct State {
+    tf2::Vector3 position;
+    tf2::Vector3 position_vel;
+    tf2::Vector3 position_acc;
+    tf2::Vector3 euler_angles;
+    tf2::Vector3 euler_vel;
+    tf2::Vector3 euler_acc;
+    tf2::Quaternion orientation;
+  };
+
+  /**
+   * Poses sampled at evenly spaced times, stored as one array per channel.
+   * The buffers keep their capacity, so reusing an instance only allocates when more samples than before are taken.
+   */
+  struct Samples {
+    std::vector<double> time;
+    std::vector<double> x;
+    std::vector<double> y;
+    std::vector<double> z;
+    std::vector<double> roll;
+    std::vector<double> pitch;
+    std::vector<double> yaw;
+
+    tf2::Vector3 position(size_t i) const;
+    tf2::Quaternion orientation(size_t i) const;
+    tf2::Transform transform(size_t i) const;
+  };
+
+  /**
+   * Evaluates all channels with their value, first and second derivative at once
+   */
+  State getState(double time);
+
+  /**
+   * Samples the pose at n times evenly spaced between t_0 and t_1, both included
+   */
+  void sampleGrid(double t_0, double t_1, size_t n, Samples &samples) const;
+
   tf2::Transform getTfTransform(double time);
 
   geometry_msgs::msg::Pose getGeometryMsgPose(double time);
@@ -49,6 +96,9 @@ class PoseSpline {
   SmoothSpline roll_;
   SmoothSpline pitch_;
   SmoothSpline yaw_;
+
+  // part of the last evaluation of x, y, z, roll, pitch and yaw
+  std::array<size_t, 6> cursors_{};
 };
 }  // namespace bitbots_splines
 #endif  // BITBOTS_SPLINES_INCLUDE_BITBOTS_SPLINES_POSE_SPLINE_H_
@@ -68,8 +68,8 @@ class SmoothSpline : public Spline {
    * Fit a polynom between 0 and t with given
    * pos, vel and acc initial and final conditions
    */
-  Polynom polynomFit(double t, double pos_1, double vel_1, double acc_1, double pos_2, double vel_2,
-                     double acc_2) const;
+  QuinticPolynom polynomFit(double t, double pos_1, double vel_1, double acc_1, double pos_2, double vel_2,
+                            double acc_2) const;
 };
 
 }  // namespace bitbots_splines
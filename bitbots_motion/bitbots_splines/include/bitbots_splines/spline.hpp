@@ -17,7 +17,10 @@ namespace bitbots_splines {
  * Spline
  *
  * Generic one dimentional
- * polynomial spline generator
+ * polynomial spline generator.
+ * All parts are quintic polynoms, so the parts
+ * are stored inline and the evaluation is
+ * inlined and does not allocate.
  */
 class Spline {
  public:
@@ -26,7 +29,7 @@ class Spline {
    * with a polynom valid on an interval
    */
   struct SplineT {
-    Polynom polynom;
+    QuinticPolynom polynom;
     double min;
     double max;
   };
@@ -36,20 +39,57 @@ class Spline {
    * at given t. Compute spline value,
    * its first, second and third derivative
    */
-  double pos(double t) const;
-  double vel(double t) const;
-  double acc(double t) const;
-  double jerk(double t) const;
+  double pos(double t) const { return interpolation(t, &QuinticPolynom::pos); }
+  double vel(double t) const { return interpolation(t, &QuinticPolynom::vel); }
+  double acc(double t) const { return interpolation(t, &QuinticPolynom::acc); }
+  double jerk(double t) const { return interpolation(t, &QuinticPolynom::jerk); }
+
+  /**
+   * Return spline value, first and second
+   * derivative at given t in one evaluation
+   */
+  PolynomState state(double t) const { return interpolation(t, &QuinticPolynom::state); }
+
+  /**
+   * Return spline value, first and second
+   * derivative at given t. The search starts at
+   * the part found by the last call with the same
+   * cursor, so evaluating increasing t advances the
+   * cursor linearly instead of bisecting each time.
+   * Any cursor value is valid, start with 0
+   */
+  PolynomState state(double t, size_t &cursor) const {
+    if (splines_.empty()) {
+      return PolynomState();
+    }
+    t = bound(t);
+    if (cursor >= splines_.size() || t < splines_[cursor].min) {
+      cursor = findPart(t);
+    }
+    while (t > splines_[cursor].max && cursor + 1 < splines_.size()) {
+      cursor++;
+    }
+    return splines_[cursor].polynom.state(t - splines_[cursor].min);
+  }
+
+  /**
+   * Write the spline values at the given n times
+   * into the buffer of n values. Consecutive times
+   * in the same part are evaluated in one loop
+   * the compiler can vectorize, so increasing
+   * times are the fastest
+   */
+  void sample(const double *times, size_t n, double *values) const;
 
   /**
    * Return spline interpolation
    * value, first, second and third derivative
    * with given t bound between 0 and 1
    */
-  double posMod(double t) const;
-  double velMod(double t) const;
-  double accMod(double t) const;
-  double jerkMod(double t) const;
+  double posMod(double t) const { return interpolationMod(t, &QuinticPolynom::pos); }
+  double velMod(double t) const { return interpolationMod(t, &QuinticPolynom::vel); }
+  double accMod(double t) const { return interpolationMod(t, &QuinticPolynom::acc); }
+  double jerkMod(double t) const { return interpolationMod(t, &QuinticPolynom::jerk); }
 
   /**
    * Return minimum and maximum abscisse
@@ -60,7 +100,9 @@ class Spline {
 
   /**
    * Write and read splines data into given
-   * iostream in ascii format
+   * iostream in ascii format.
+   * Imported polynoms of lower degree are
+   * padded with zero coefficients
    */
   void exportData(std::ostream &os) const;
   void importData(std::istream &is);
@@ -79,7 +121,13 @@ class Spline {
    * Add a part with given polynom
    * and min/max time range
    */
-  void addPart(const Polynom &poly, double min, double max);
+  void addPart(const QuinticPolynom &poly, double min, double max);
+
+  /**
+   * Replace all parts with the given
+   * ones, e.g. loaded from a binary file
+   */
+  void setParts(const SplineT *parts, size_t count);
 
   /**
    * Replace this spline part with the
@@ -105,13 +153,65 @@ class Spline {
    * used given polynom evaluation function
    * (member function pointer)
    */
-  double interpolation(double x, double (Polynom::*func)(double) const) const;
+  template <typename R>
+  R interpolation(double x, R (QuinticPolynom::*func)(double) const) const {
+    // Empty case
+    if (splines_.empty()) {
+      return R();
+    }
+    x = bound(x);
+    size_t index = findPart(x);
+    // Compute and return spline value
+    return (splines_[index].polynom.*func)(x - splines_[index].min);
+  }
+
+  /**
+   * Bound asked abscisse into spline range
+   */
+  double bound(double x) const {
+    if (x <= splines_.front().min) {
+      x = splines_.front().min;
+    }
+    if (x >= splines_.back().max) {
+      x = splines_.back().max;
+    }
+    return x;
+  }
+
+  /**
+   * Bijection search of the part containing
+   * x, the spline must not be empty
+   */
+  size_t findPart(double x) const {
+    size_t index_low = 0;
+    size_t index_up = splines_.size() - 1;
+    while (index_low != index_up) {
+      size_t index = (index_up + index_low) / 2;
+      if (x < splines_[index].min) {
+        index_up = index - 1;
+      } else if (x > splines_[index].max) {
+        index_low = index + 1;
+      } else {
+        index_up = index;
+        index_low = index;
+      }
+    }
+    return index_up;
+  }
 
   /**
    * Return interpolation with x
    * bound between 0 and 1
    */
-  double interpolationMod(double x, double (Polynom::*func)(double) const) const;
+  template <typename R>
+  R interpolationMod(double x, R (QuinticPolynom::*func)(double) const) const {
+    if (x < 0.0) {
+      x = 1.0 + (x - ((int)x / 1));
+    } else if (x > 1.0) {
+      x = (x - ((int)x / 1));
+    }
+    return interpolation(x, func);
+  }
 };
 
 }  // namespace bitbots_splines
@@ -8,11 +8,13 @@ https://github.com/Rhoban/model/
 
 #include <algorithm>
 #include <bitbots_splines/smooth_spline.hpp>
+#include <cstdint>
+#include <cstring>
 #include <fstream>
 #include <map>
-#include <set>
 #include <stdexcept>
 #include <string>
+#include <type_traits>
 #include <vector>
 
 #include "spline.hpp"
@@ -57,16 +59,18 @@ class SplineContainer {
    * Access to given named spline
    */
   inline const T &get(const std::string &name) const {
-    if (container_.count(name) == 0) {
+    auto it = container_.find(name);
+    if (it == container_.end()) {
       throw std::logic_error("SplineContainer invalid name: " + name);
     }
-    return container_.at(name);
+    return it->second;
   }
   inline T &get(const std::string &name) {
-    if (container_.count(name) == 0) {
+    auto it = container_.find(name);
+    if (it == container_.end()) {
       throw std::logic_error("SplineContainer invalid name: " + name);
     }
-    return container_.at(name);
+    return it->second;
   }
 
   /**
@@ -79,19 +83,18 @@ class SplineContainer {
    * Returns all time points where a point in any spline exists.
    */
   std::vector<double> getTimes() const {
-    std::set<double> times;
-    std::vector<double> times_sorted;
+    std::vector<double> times;
     // go trough all splines
     for (const auto &sp : container_) {
       // go trough all points of the spline
       for (const SmoothSpline::Point &point : sp.second.points()) {
-        times.insert(point.time);
+        times.push_back(point.time);
       }
     }
-    // insert set into vector
-    times_sorted.insert(times_sorted.end(), times.begin(), times.end());
-    std::sort(times_sorted.begin(), times_sorted.end());
-    return times_sorted;
+    // sort and remove duplicates in place instead of building a set
+    std::sort(times.begin(), times.end());
+    times.erase(std::unique(times.begin(), times.end()), times.end());
+    return times;
   }
 
   /**
@@ -182,7 +185,148 @@ class SplineContainer {
     file.close();
   }
 
+  /**
+   * Export to and Import from given file name in a binary format.
+   * The parts are stored with the memory layout of Spline::SplineT
+   * and the byte order of the host, so they are loaded with one read
+   * and copied without parsing. Text files are converted by
+   * importData() followed by exportBinary().
+   *
+   * header: "BBSC", uint32 version, uint32 spline count, uint32 part count,
+   *         uint64 FNV-1a checksum of everything after the header
+   * name table: for each spline a uint32 name length, a uint32 part count
+   *             and the name, padded with zeros to a multiple of 8 bytes
+   * parts: the parts of all splines in the order of the name table, each
+   *        with the six polynom coefficients, min and max as double
+   */
+  void exportBinary(const std::string &file_name) const {
+    if (container_.size() == 0) {
+      throw std::logic_error("SplineContainer empty");
+    }
+
+    std::string body;
+    auto append = [&body](const void *data, size_t size) { body.append(static_cast<const char *>(data), size); };
+    uint32_t part_count = 0;
+    for (const auto &sp : container_) {
+      uint32_t name_size = sp.first.size();
+      uint32_t size = sp.second.size();
+      append(&name_size, sizeof(name_size));
+      append(&size, sizeof(size));
+      append(sp.first.data(), name_size);
+      part_count += size;
+    }
+    body.resize((body.size() + 7) / 8 * 8, '\0');
+    for (const auto &sp : container_) {
+      for (size_t i = 0; i < sp.second.size(); i++) {
+        append(&sp.second.part(i), sizeof(Spline::SplineT));
+      }
+    }
+
+    std::ofstream file(file_name, std::ios::binary | std::ios::trunc);
+    if (!file.is_open()) {
+      throw std::runtime_error("SplineContainer unable to write file: " + file_name);
+    }
+    uint32_t spline_count = container_.size();
+    uint64_t checksum = fnv1a(body.data(), body.size());
+    file.write(BINARY_MAGIC, 4);
+    file.write(reinterpret_cast<const char *>(&BINARY_VERSION), sizeof(BINARY_VERSION));
+    file.write(reinterpret_cast<const char *>(&spline_count), sizeof(spline_count));
+    file.write(reinterpret_cast<const char *>(&part_count), sizeof(part_count));
+    file.write(reinterpret_cast<const char *>(&checksum), sizeof(checksum));
+    file.write(body.data(), body.size());
+    if (!file.good()) {
+      throw std::runtime_error("SplineContainer unable to write file: " + file_name);
+    }
+  }
+  void importBinary(const std::string &file_name) {
+    std::ifstream file(file_name, std::ios::binary | std::ios::ate);
+    if (!file.is_open()) {
+      throw std::runtime_error("SplineContainer unable to read file: " + file_name);
+    }
+    std::string data(static_cast<size_t>(file.tellg()), '\0');
+    file.seekg(0);
+    file.read(&data[0], data.size());
+    if (!file.good()) {
+      throw std::runtime_error("SplineContainer unable to read file: " + file_name);
+    }
+
+    size_t offset = 0;
+    auto read = [&data, &offset](void *value, size_t size) {
+      if (data.size() - offset < size) {
+        throw std::logic_error("SplineContainer invalid binary format");
+      }
+      std::memcpy(value, data.data() + offset, size);
+      offset += size;
+    };
+    char magic[4];
+    uint32_t version;
+    uint32_t spline_count;
+    uint32_t part_count;
+    uint64_t checksum;
+    read(magic, sizeof(magic));
+    read(&version, sizeof(version));
+    read(&spline_count, sizeof(spline_count));
+    read(&part_count, sizeof(part_count));
+    read(&checksum, sizeof(checksum));
+    if (std::memcmp(magic, BINARY_MAGIC, 4) != 0 || version != BINARY_VERSION) {
+      throw std::logic_error("SplineContainer invalid binary format");
+    }
+    if (fnv1a(data.data() + offset, data.size() - offset) != checksum) {
+      throw std::logic_error("SplineContainer binary checksum mismatch");
+    }
+    // the header is not covered by the checksum, every name takes at least its size and part count
+    if (spline_count > (data.size() - offset) / (2 * sizeof(uint32_t))) {
+      throw std::logic_error("SplineContainer invalid binary format");
+    }
+
+    std::vector<std::pair<std::string, uint32_t>> names(spline_count);
+    uint64_t total_parts = 0;
+    for (auto &name : names) {
+      uint32_t name_size;
+      read(&name_size, sizeof(name_size));
+      read(&name.second, sizeof(name.second));
+      if (data.size() - offset < name_size) {
+        throw std::logic_error("SplineContainer invalid binary format");
+      }
+      name.first.assign(data.data() + offset, name_size);
+      offset += name_size;
+      total_parts += name.second;
+    }
+    offset = (offset + 7) / 8 * 8;
+    if (total_parts != part_count || offset > data.size() ||
+        data.size() - offset != part_count * sizeof(Spline::SplineT)) {
+      throw std::logic_error("SplineContainer invalid binary format");
+    }
+
+    std::vector<Spline::SplineT> parts;
+    for (const auto &name : names) {
+      parts.resize(name.second);
+      std::memcpy(parts.data(), data.data() + offset, name.second * sizeof(Spline::SplineT));
+      offset += name.second * sizeof(Spline::SplineT);
+      add(name.first);
+      container_.at(name.first).setParts(parts.data(), parts.size());
+    }
+  }
+
  private:
+  static_assert(std::is_trivially_copyable<Spline::SplineT>::value && sizeof(Spline::SplineT) == 8 * sizeof(double),
+                "The binary format stores the spline parts as they are in memory");
+  static constexpr const char *BINARY_MAGIC = "BBSC";
+  static constexpr uint32_t BINARY_VERSION = 1;
+
+  /**
+   * 64 bit FNV-1a hash, used as checksum
+   * of the binary format
+   */
+  static uint64_t fnv1a(const char *data, size_t size) {
+    uint64_t hash = 14695981039346656037ull;
+    for (size_t i = 0; i < size; i++) {
+      hash ^= static_cast<unsigned char>(data[i]);
+      hash *= 1099511628211ull;
+    }
+    return hash;
+  }
+
   /**
    * Spline container indexed
    * by their name
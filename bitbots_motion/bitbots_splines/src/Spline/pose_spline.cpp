@@ -2,11 +2,55 @@
 
 namespace bitbots_splines {
 
+PoseSpline::State PoseSpline::getState(double time) {
+  const std::array<const SmoothSpline *, 6> channels = {&x_, &y_, &z_, &roll_, &pitch_, &yaw_};
+  std::array<PolynomState, 6> states;
+  for (size_t i = 0; i < channels.size(); i++) {
+    states[i] = channels[i]->state(time, cursors_[i]);
+  }
+  State state;
+  state.position.setValue(states[0].pos, states[1].pos, states[2].pos);
+  state.position_vel.setValue(states[0].vel, states[1].vel, states[2].vel);
+  state.position_acc.setValue(states[0].acc, states[1].acc, states[2].acc);
+  state.euler_angles.setValue(states[3].pos, states[4].pos, states[5].pos);
+  state.euler_vel.setValue(states[3].vel, states[4].vel, states[5].vel);
+  state.euler_acc.setValue(states[3].acc, states[4].acc, states[5].acc);
+  state.orientation.setRPY(states[3].pos, states[4].pos, states[5].pos);
+  state.orientation.normalize();
+  return state;
+}
+
+void PoseSpline::sampleGrid(double t_0, double t_1, size_t n, Samples &samples) const {
+  for (std::vector<double> *buffer :
+       {&samples.time, &samples.x, &samples.y, &samples.z, &samples.roll, &samples.pitch, &samples.yaw}) {
+    buffer->resize(n);
+  }
+  double step = n > 1 ? (t_1 - t_0) / (n - 1) : 0.0;
+  for (size_t i = 0; i < n; i++) {
+    samples.time[i] = t_0 + i * step;
+  }
+  x_.sample(samples.time.data(), n, samples.x.data());
+  y_.sample(samples.time.data(), n, samples.y.data());
+  z_.sample(samples.time.data(), n, samples.z.data());
+  roll_.sample(samples.time.data(), n, samples.roll.data());
+  pitch_.sample(samples.time.data(), n, samples.pitch.data());
+  yaw_.sample(samples.time.data(), n, samples.yaw.data());
+}
+
+tf2::Vector3 PoseSpline::Samples::position(size_t i) const { return {x[i], y[i], z[i]}; }
+
+tf2::Quaternion PoseSpline::Samples::orientation(size_t i) const {
+  tf2::Quaternion quat;
+  quat.setRPY(roll[i], pitch[i], yaw[i]);
+  quat.normalize();
+  return quat;
+}
+
+tf2::Transform PoseSpline::Samples::transform(size_t i) const { return tf2::Transform(orientation(i), position(i)); }
+
 tf2::Transform PoseSpline::getTfTransform(double time) {
-  tf2::Transform trans;
-  trans.setOrigin(getPositionPos(time));
-  trans.setRotation(getOrientation(time));
-  return trans;
+  State state = getState(time);
+  return tf2::Transform(state.orientation, state.position);
 }
 geometry_msgs::msg::Pose PoseSpline::getGeometryMsgPose(double time) {
   geometry_msgs::msg::Pose msg;
@@ -32,46 +76,46 @@ geometry_msgs::msg::Quaternion PoseSpline::getGeometryMsgOrientation(double time
 
 tf2::Vector3 PoseSpline::getPositionPos(double time) {
   tf2::Vector3 pos;
-  pos[0] = x_.pos(time);
-  pos[1] = y_.pos(time);
-  pos[2] = z_.pos(time);
+  pos[0] = x_.state(time, cursors_[0]).pos;
+  pos[1] = y_.state(time, cursors_[1]).pos;
+  pos[2] = z_.state(time, cursors_[2]).pos;
   return pos;
 }
 
 tf2::Vector3 PoseSpline::getPositionVel(double time) {
   tf2::Vector3 vel;
-  vel[0] = x_.vel(time);
-  vel[1] = y_.vel(time);
-  vel[2] = z_.vel(time);
+  vel[0] = x_.state(time, cursors_[0]).vel;
+  vel[1] = y_.state(time, cursors_[1]).vel;
+  vel[2] = z_.state(time, cursors_[2]).vel;
   return vel;
 }
 tf2::Vector3 PoseSpline::getPositionAcc(double time) {
   tf2::Vector3 acc;
-  acc[0] = x_.acc(time);
-  acc[1] = y_.acc(time);
-  acc[2] = z_.acc(time);
+  acc[0] = x_.state(time, cursors_[0]).acc;
+  acc[1] = y_.state(time, cursors_[1]).acc;
+  acc[2] = z_.state(time, cursors_[2]).acc;
   return acc;
 }
 
 tf2::Vector3 PoseSpline::getEulerAngles(double time) {
   tf2::Vector3 pos;
-  pos[0] = roll_.pos(time);
-  pos[1] = pitch_.pos(time);
-  pos[2] = yaw_.pos(time);
+  pos[0] = roll_.state(time, cursors_[3]).pos;
+  pos[1] = pitch_.state(time, cursors_[4]).pos;
+  pos[2] = yaw_.state(time, cursors_[5]).pos;
   return pos;
 }
 tf2::Vector3 PoseSpline::getEulerVel(double time) {
   tf2::Vector3 vel;
-  vel[0] = roll_.vel(time);
-  vel[1] = pitch_.vel(time);
-  vel[2] = yaw_.vel(time);
+  vel[0] = roll_.state(time, cursors_[3]).vel;
+  vel[1] = pitch_.state(time, cursors_[4]).vel;
+  vel[2] = yaw_.state(time, cursors_[5]).vel;
   return vel;
 }
 tf2::Vector3 PoseSpline::getEulerAcc(double time) {
   tf2::Vector3 acc;
-  acc[0] = roll_.acc(time);
-  acc[1] = pitch_.acc(time);
-  acc[2] = yaw_.acc(time);
+  acc[0] = roll_.state(time, cursors_[3]).acc;
+  acc[1] = pitch_.state(time, cursors_[4]).acc;
+  acc[2] = yaw_.state(time, cursors_[5]).acc;
   return acc;
 }
 
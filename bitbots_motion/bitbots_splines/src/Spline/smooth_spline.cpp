@@ -47,17 +47,20 @@ void SmoothSpline::importCallBack() {
   }
 
   double t_begin = Spline::splines_.front().min;
-  points_.push_back({t_begin, Spline::pos(t_begin), Spline::vel(t_begin), Spline::acc(t_begin)});
+  PolynomState begin = Spline::state(t_begin);
+  points_.push_back({t_begin, begin.pos, begin.vel, begin.acc});
 
   for (size_t i = 1; i < size; i++) {
     double t_1 = Spline::splines_[i - 1].max;
     double t_2 = Spline::splines_[i].min;
-    double pos_1 = Spline::pos(t_1);
-    double vel_1 = Spline::vel(t_1);
-    double acc_1 = Spline::acc(t_1);
-    double pos_2 = Spline::pos(t_2);
-    double vel_2 = Spline::vel(t_2);
-    double acc_2 = Spline::acc(t_2);
+    PolynomState state_1 = Spline::state(t_1);
+    PolynomState state_2 = Spline::state(t_2);
+    double pos_1 = state_1.pos;
+    double vel_1 = state_1.vel;
+    double acc_1 = state_1.acc;
+    double pos_2 = state_2.pos;
+    double vel_2 = state_2.vel;
+    double acc_2 = state_2.acc;
 
     if (fabs(t_2 - t_1) < 0.0001 && fabs(pos_2 - pos_1) < 0.0001 && fabs(vel_2 - vel_1) < 0.0001 &&
         fabs(acc_2 - acc_1) < 0.0001) {
@@ -69,11 +72,12 @@ void SmoothSpline::importCallBack() {
   }
 
   double t_end = Spline::splines_.back().max;
-  points_.push_back({t_end, Spline::pos(t_end), Spline::vel(t_end), Spline::acc(t_end)});
+  PolynomState end = Spline::state(t_end);
+  points_.push_back({t_end, end.pos, end.vel, end.acc});
 }
 
-Polynom SmoothSpline::polynomFit(double t, double pos_1, double vel_1, double acc_1, double pos_2, double vel_2,
-                                 double acc_2) const {
+QuinticPolynom SmoothSpline::polynomFit(double t, double pos_1, double vel_1, double acc_1, double pos_2, double vel_2,
+                                        double acc_2) const {
   if (t <= 0.00001) {
     throw std::logic_error("SmoothSpline invalid spline interval");
   }
@@ -81,8 +85,7 @@ Polynom SmoothSpline::polynomFit(double t, double pos_1, double vel_1, double ac
   double t_3 = t_2 * t;
   double t_4 = t_3 * t;
   double t_5 = t_4 * t;
-  Polynom p;
-  p.getCoefs().resize(6);
+  QuinticPolynom p;
   p.getCoefs()[0] = pos_1;
   p.getCoefs()[1] = vel_1;
   p.getCoefs()[2] = acc_1 / 2;
@@ -5,20 +5,42 @@ https://github.com/Rhoban/model/
 */
 #include "bitbots_splines/spline.hpp"
 
+#include <algorithm>
 #include <iomanip>
 #include <stdexcept>
 
 namespace bitbots_splines {
 
-double Spline::pos(double t) const { return interpolation(t, &Polynom::pos); }
-double Spline::vel(double t) const { return interpolation(t, &Polynom::vel); }
-double Spline::acc(double t) const { return interpolation(t, &Polynom::acc); }
-double Spline::jerk(double t) const { return interpolation(t, &Polynom::jerk); }
-
-double Spline::posMod(double t) const { return interpolationMod(t, &Polynom::pos); }
-double Spline::velMod(double t) const { return interpolationMod(t, &Polynom::vel); }
-double Spline::accMod(double t) const { return interpolationMod(t, &Polynom::acc); }
-double Spline::jerkMod(double t) const { return interpolationMod(t, &Polynom::jerk); }
+void Spline::sample(const double *times, size_t n, double *values) const {
+  if (splines_.empty()) {
+    std::fill(values, values + n, 0.0);
+    return;
+  }
+  size_t part = 0;
+  size_t begin = 0;
+  while (begin < n) {
+    // Find the part of the first remaining sample, usually the current or one of the next ones
+    double t = bound(times[begin]);
+    if (t < splines_[part].min) {
+      part = findPart(t);
+    }
+    while (t > splines_[part].max && part + 1 < splines_.size()) {
+      part++;
+    }
+    // Find all following samples in this part
+    size_t end = begin + 1;
+    while (end < n && bound(times[end]) <= splines_[part].max && bound(times[end]) >= splines_[part].min) {
+      end++;
+    }
+    // Evaluate them in place on their abscisses relative to the part
+    double offset = splines_[part].min;
+    for (size_t i = begin; i < end; i++) {
+      values[i] = bound(times[i]) - offset;
+    }
+    splines_[part].polynom.pos(values + begin, end - begin, values + begin);
+    begin = end;
+  }
+}
 
 double Spline::min() const {
   if (splines_.empty()) {
@@ -53,7 +75,7 @@ void Spline::importData(std::istream &is) {
     double min;
     double max;
     size_t size;
-    Polynom p;
+    QuinticPolynom p;
     // Load spline interval and degree
     is >> min;
     if (!is.good()) break;
@@ -61,7 +83,9 @@ void Spline::importData(std::istream &is) {
     if (!is.good()) break;
     is >> size;
     // Load polynom coeficients
-    p.getCoefs().resize(size);
+    if (size > p.getCoefs().size()) {
+      throw std::logic_error("Spline import polynom degree too high");
+    }
     for (size_t i = 0; i < size; i++) {
       if (!is.good()) break;
       is >> p.getCoefs()[i];
@@ -89,7 +113,13 @@ size_t Spline::size() const { return splines_.size(); }
 
 const Spline::SplineT &Spline::part(size_t index) const { return splines_.at(index); }
 
-void Spline::addPart(const Polynom &poly, double min, double max) { splines_.push_back({poly, min, max}); }
+void Spline::addPart(const QuinticPolynom &poly, double min, double max) { splines_.push_back({poly, min, max}); }
+
+void Spline::setParts(const SplineT *parts, size_t count) {
+  splines_.assign(parts, parts + count);
+  // Call possible post import
+  importCallBack();
+}
 
 void Spline::copyData(const Spline &sp) {
   splines_ = sp.splines_;
@@ -99,43 +129,4 @@ void Spline::copyData(const Spline &sp) {
 
 void Spline::importCallBack() {}
 
-double Spline::interpolation(double x, double (Polynom::*func)(double) const) const {
-  // Empty case
-  if (splines_.empty()) {
-    return 0.0;
-  }
-  // Bound asked abscisse into spline range
-  if (x <= splines_.front().min) {
-    x = splines_.front().min;
-  }
-  if (x >= splines_.back().max) {
-    x = splines_.back().max;
-  }
-  // Bijection spline search
-  size_t index_low = 0;
-  size_t index_up = splines_.size() - 1;
-  while (index_low != index_up) {
-    size_t index = (index_up + index_low) / 2;
-    if (x < splines_[index].min) {
-      index_up = index - 1;
-    } else if (x > splines_[index].max) {
-      index_low = index + 1;
-    } else {
-      index_up = index;
-      index_low = index;
-    }
-  }
-  // Compute and return spline value
-  return (splines_[index_up].polynom.*func)(x - splines_[index_up].min);
-}
-
-double Spline::interpolationMod(double x, double (Polynom::*func)(double) const) const {
-  if (x < 0.0) {
-    x = 1.0 + (x - ((int)x / 1));
-  } else if (x > 1.0) {
-    x = (x - ((int)x / 1));
-  }
-  return interpolation(x, func);
-}
-
 }  // namespace bitbots_splines
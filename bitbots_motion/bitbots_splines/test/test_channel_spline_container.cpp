@@ -0,0 +1,89 @@
+#include <gtest/gtest.h>
+
+#include <array>
+#include <bitbots_splines/channel_spline_container.hpp>
+#include <bitbots_splines/smooth_spline.hpp>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+using namespace bitbots_splines;
+
+namespace {
+struct TestLayout {
+  enum Channel { X, Y, PITCH };
+  static constexpr std::array<const char *, 3> names = {"x", "y", "pitch"};
+};
+
+using Container = ChannelSplineContainer<SmoothSpline, TestLayout>;
+
+// The names are resolved at compile time
+static_assert(Container::index("x") == TestLayout::X);
+static_assert(Container::index("y") == TestLayout::Y);
+static_assert(Container::index("pitch") == TestLayout::PITCH);
+static_assert(Container::size() == 3);
+}  // namespace
+
+TEST(ChannelSplineContainer, Index) {
+  EXPECT_EQ(Container::index("x"), 0u);
+  EXPECT_EQ(Container::index("y"), 1u);
+  EXPECT_EQ(Container::index("pitch"), 2u);
+  EXPECT_THROW(Container::index("z"), std::logic_error);
+  EXPECT_THROW(Container::index(""), std::logic_error);
+  EXPECT_STREQ(Container::name(TestLayout::PITCH), "pitch");
+}
+
+TEST(ChannelSplineContainer, Exist) {
+  EXPECT_TRUE(Container::exist("x"));
+  EXPECT_TRUE(Container::exist("pitch"));
+  EXPECT_FALSE(Container::exist("z"));
+  EXPECT_FALSE(Container::exist("pitc"));
+  EXPECT_FALSE(Container::exist("pitch_"));
+}
+
+TEST(ChannelSplineContainer, GetByChannelAndName) {
+  Container container;
+  container.get<TestLayout::X>().addPoint(0.0, 1.0);
+  container.get<TestLayout::X>().addPoint(1.0, 2.0);
+  container.get(TestLayout::Y).addPoint(0.5, -1.0);
+  container.get("pitch").addPoint(0.25, 0.5);
+
+  // All accessors refer to the same splines
+  EXPECT_EQ(&container.get<TestLayout::X>(), &container.get("x"));
+  EXPECT_EQ(&container.get<TestLayout::Y>(), &container.get(TestLayout::Y));
+  EXPECT_EQ(&container.get<TestLayout::PITCH>(), &container.get()[TestLayout::PITCH]);
+  const Container &const_container = container;
+  EXPECT_EQ(&const_container.get<TestLayout::X>(), &container.get<TestLayout::X>());
+  EXPECT_EQ(&const_container.get("y"), &container.get<TestLayout::Y>());
+
+  EXPECT_EQ(container.get<TestLayout::X>().points().size(), 2u);
+  EXPECT_EQ(container.get<TestLayout::Y>().points().size(), 1u);
+  EXPECT_EQ(container.get<TestLayout::PITCH>().points().size(), 1u);
+  EXPECT_THROW(container.get("z"), std::logic_error);
+
+  container.get<TestLayout::X>().computeSplines();
+  EXPECT_DOUBLE_EQ(container.get("x").pos(0.0), 1.0);
+  EXPECT_DOUBLE_EQ(container.get("x").pos(1.0), 2.0);
+  EXPECT_DOUBLE_EQ(container.min(), 0.0);
+  EXPECT_DOUBLE_EQ(container.max(), 1.0);
+}
+
+TEST(ChannelSplineContainer, GetTimes) {
+  Container container;
+  EXPECT_TRUE(container.getTimes().empty());
+
+  container.get<TestLayout::X>().addPoint(1.0, 0.0);
+  container.get<TestLayout::X>().addPoint(0.0, 0.0);
+  container.get<TestLayout::Y>().addPoint(0.5, 0.0);
+  container.get<TestLayout::Y>().addPoint(1.0, 0.0);
+  container.get<TestLayout::PITCH>().addPoint(0.25, 0.0);
+
+  // The times of all splines are sorted and contain no duplicates
+  std::vector<double> expected = {0.0, 0.25, 0.5, 1.0};
+  EXPECT_EQ(container.getTimes(), expected);
+
+  // The given vector is cleared before it is filled
+  std::vector<double> times = {2.0, 3.0};
+  container.getTimes(times);
+  EXPECT_EQ(times, expected);
+}
@@ -0,0 +1,141 @@
+#include <gtest/gtest.h>
+
+#include <bitbots_splines/polynom.hpp>
+#include <bitbots_splines/smooth_spline.hpp>
+#include <vector>
+
+using namespace bitbots_splines;
+
+namespace {
+// 1 + 2x - 3x^2 + 0.5x^3 + 0.25x^4 - 0.1x^5
+QuinticPolynom testPolynom() {
+  QuinticPolynom p;
+  p(0) = 1.0;
+  p(1) = 2.0;
+  p(2) = -3.0;
+  p(3) = 0.5;
+  p(4) = 0.25;
+  p(5) = -0.1;
+  return p;
+}
+
+SmoothSpline testSpline() {
+  SmoothSpline spline;
+  spline.addPoint(0.0, 0.0);
+  spline.addPoint(0.5, 1.0, 0.5);
+  spline.addPoint(1.2, -0.5, 0.0, 1.0);
+  spline.addPoint(2.0, 0.25);
+  spline.computeSplines();
+  return spline;
+}
+}  // namespace
+
+TEST(Polynom, Evaluation) {
+  QuinticPolynom p = testPolynom();
+  for (double x : {-1.5, 0.0, 0.3, 2.0}) {
+    double x2 = x * x, x3 = x2 * x, x4 = x3 * x, x5 = x4 * x;
+    EXPECT_NEAR(p.pos(x), 1.0 + 2.0 * x - 3.0 * x2 + 0.5 * x3 + 0.25 * x4 - 0.1 * x5, 1e-12);
+    EXPECT_NEAR(p.vel(x), 2.0 - 6.0 * x + 1.5 * x2 + x3 - 0.5 * x4, 1e-12);
+    EXPECT_NEAR(p.acc(x), -6.0 + 3.0 * x + 3.0 * x2 - 2.0 * x3, 1e-12);
+    EXPECT_NEAR(p.jerk(x), 3.0 + 6.0 * x - 6.0 * x2, 1e-12);
+  }
+}
+
+TEST(Polynom, StateMatchesDerivatives) {
+  QuinticPolynom p = testPolynom();
+  for (double x : {-1.5, 0.0, 0.3, 2.0}) {
+    PolynomState state = p.state(x);
+    EXPECT_NEAR(state.pos, p.pos(x), 1e-12);
+    EXPECT_NEAR(state.vel, p.vel(x), 1e-12);
+    EXPECT_NEAR(state.acc, p.acc(x), 1e-12);
+  }
+}
+
+TEST(Polynom, BatchEvaluation) {
+  QuinticPolynom p = testPolynom();
+  std::vector<double> x = {-1.0, -0.25, 0.0, 0.5, 1.0, 1.75, 3.0};
+  std::vector<double> values(x.size());
+  p.pos(x.data(), x.size(), values.data());
+  for (size_t i = 0; i < x.size(); i++) {
+    EXPECT_DOUBLE_EQ(values[i], p.pos(x[i]));
+  }
+  // The output may be the input buffer
+  p.pos(x.data(), x.size(), x.data());
+  EXPECT_EQ(x, values);
+}
+
+TEST(Polynom, Shift) {
+  QuinticPolynom p = testPolynom();
+  QuinticPolynom shifted = p;
+  shifted.shift(0.7);
+  for (double x : {-1.0, 0.0, 0.5, 1.3}) {
+    EXPECT_NEAR(shifted.pos(x), p.pos(x + 0.7), 1e-12);
+  }
+}
+
+TEST(Polynom, OtherDegree) {
+  Polynom<2> p;
+  p(0) = 1.0;
+  p(1) = -1.0;
+  p(2) = 2.0;
+  EXPECT_EQ(Polynom<2>::degree(), 2u);
+  EXPECT_DOUBLE_EQ(p.pos(2.0), 7.0);
+  EXPECT_DOUBLE_EQ(p.vel(2.0), 7.0);
+  EXPECT_DOUBLE_EQ(p.acc(2.0), 4.0);
+  EXPECT_DOUBLE_EQ(p.jerk(2.0), 0.0);
+}
+
+TEST(SmoothSpline, PassesThroughPoints) {
+  SmoothSpline spline = testSpline();
+  for (const SmoothSpline::Point &point : spline.points()) {
+    EXPECT_NEAR(spline.pos(point.time), point.position, 1e-9);
+    EXPECT_NEAR(spline.vel(point.time), point.velocity, 1e-9);
+    EXPECT_NEAR(spline.acc(point.time), point.acceleration, 1e-9);
+  }
+  EXPECT_DOUBLE_EQ(spline.min(), 0.0);
+  EXPECT_DOUBLE_EQ(spline.max(), 2.0);
+}
+
+TEST(SmoothSpline, BoundsOutsideOfParts) {
+  SmoothSpline spline = testSpline();
+  EXPECT_DOUBLE_EQ(spline.pos(-1.0), spline.pos(0.0));
+  EXPECT_DOUBLE_EQ(spline.pos(3.0), spline.pos(2.0));
+}
+
+TEST(SmoothSpline, CursorStateMatchesState) {
+  SmoothSpline spline = testSpline();
+  size_t cursor = 0;
+  // Forward, backward and with an invalid cursor
+  for (double t : {0.0, 0.1, 0.5, 0.9, 1.2, 1.9, 2.0, 0.2, 1.5, -1.0, 3.0}) {
+    PolynomState expected = spline.state(t);
+    PolynomState state = spline.state(t, cursor);
+    // At the boundary of two parts, both of them are valid
+    EXPECT_NEAR(state.pos, expected.pos, 1e-9) << "t = " << t;
+    EXPECT_NEAR(state.vel, expected.vel, 1e-9) << "t = " << t;
+    EXPECT_NEAR(state.acc, expected.acc, 1e-9) << "t = " << t;
+  }
+  cursor = 100;
+  EXPECT_NEAR(spline.state(1.0, cursor).pos, spline.pos(1.0), 1e-12);
+}
+
+TEST(SmoothSpline, SampleMatchesPos) {
+  SmoothSpline spline = testSpline();
+  std::vector<double> times;
+  for (int i = -5; i <= 45; i++) {
+    times.push_back(i * 0.05);
+  }
+  // Unsorted times are valid as well
+  times.push_back(0.7);
+  times.push_back(0.1);
+  std::vector<double> values(times.size());
+  spline.sample(times.data(), times.size(), values.data());
+  for (size_t i = 0; i < times.size(); i++) {
+    EXPECT_NEAR(values[i], spline.pos(times[i]), 1e-9) << "t = " << times[i];
+  }
+}
+
+TEST(SmoothSpline, EmptySpline) {
+  SmoothSpline spline;
+  size_t cursor = 0;
+  EXPECT_DOUBLE_EQ(spline.state(1.0, cursor).pos, 0.0);
+}
@@ -0,0 +1,138 @@
+#include <gtest/gtest.h>
+
+#include <bitbots_splines/smooth_spline.hpp>
+#include <bitbots_splines/spline_container.hpp>
+#include <cstdint>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <iterator>
+#include <stdexcept>
+#include <string>
+
+using namespace bitbots_splines;
+
+namespace {
+SplineContainer<SmoothSpline> testContainer() {
+  SplineContainer<SmoothSpline> container;
+  container.add("x");
+  container.get("x").addPoint(0.0, 0.0);
+  container.get("x").addPoint(0.5, 1.0, 0.5);
+  container.get("x").addPoint(1.0, -0.5);
+  container.get("x").computeSplines();
+  container.add("pitch");
+  container.get("pitch").addPoint(0.2, 0.1, 0.0, 1.0);
+  container.get("pitch").addPoint(0.8, -0.3);
+  container.get("pitch").computeSplines();
+  // Splines without parts are valid as well
+  container.add("empty");
+  return container;
+}
+
+class SplineContainerBinary : public ::testing::Test {
+ protected:
+  void SetUp() override {
+    std::string test_name = ::testing::UnitTest::GetInstance()->current_test_info()->name();
+    file_name_ = (std::filesystem::temp_directory_path() / ("test_spline_container_" + test_name + ".bin")).string();
+  }
+
+  void TearDown() override { std::filesystem::remove(file_name_); }
+
+  std::string readFile() const {
+    std::ifstream file(file_name_, std::ios::binary);
+    return std::string(std::istreambuf_iterator<char>(file), std::istreambuf_iterator<char>());
+  }
+
+  void writeFile(const std::string &data) const {
+    std::ofstream file(file_name_, std::ios::binary | std::ios::trunc);
+    file.write(data.data(), data.size());
+  }
+
+  std::string file_name_;
+};
+}  // namespace
+
+TEST_F(SplineContainerBinary, RoundTrip) {
+  SplineContainer<SmoothSpline> exported = testContainer();
+  exported.exportBinary(file_name_);
+
+  SplineContainer<SmoothSpline> imported;
+  imported.importBinary(file_name_);
+
+  ASSERT_EQ(imported.size(), exported.size());
+  for (const auto &sp : exported.get()) {
+    ASSERT_TRUE(imported.exist(sp.first)) << sp.first;
+    const SmoothSpline &spline = imported.get(sp.first);
+    ASSERT_EQ(spline.size(), sp.second.size()) << sp.first;
+    for (size_t i = 0; i < spline.size(); i++) {
+      EXPECT_EQ(spline.part(i).min, sp.second.part(i).min);
+      EXPECT_EQ(spline.part(i).max, sp.second.part(i).max);
+      EXPECT_EQ(spline.part(i).polynom.getCoefs(), sp.second.part(i).polynom.getCoefs());
+    }
+    for (double t = -0.1; t < 1.1; t += 0.05) {
+      EXPECT_EQ(spline.pos(t), sp.second.pos(t)) << sp.first << " t = " << t;
+    }
+  }
+}
+
+TEST_F(SplineContainerBinary, ExportEmptyThrows) {
+  SplineContainer<SmoothSpline> container;
+  EXPECT_THROW(container.exportBinary(file_name_), std::logic_error);
+}
+
+TEST_F(SplineContainerBinary, MissingFileThrows) {
+  SplineContainer<SmoothSpline> container;
+  EXPECT_THROW(container.importBinary(file_name_ + ".missing"), std::runtime_error);
+}
+
+TEST_F(SplineContainerBinary, InvalidMagicThrows) {
+  testContainer().exportBinary(file_name_);
+  std::string data = readFile();
+  data[0] = 'X';
+  writeFile(data);
+  SplineContainer<SmoothSpline> container;
+  EXPECT_THROW(container.importBinary(file_name_), std::logic_error);
+}
+
+TEST_F(SplineContainerBinary, CorruptedBodyThrows) {
+  testContainer().exportBinary(file_name_);
+  std::string data = readFile();
+  data[data.size() - 3] ^= 0x10;
+  writeFile(data);
+  SplineContainer<SmoothSpline> container;
+  EXPECT_THROW(container.importBinary(file_name_), std::logic_error);
+}
+
+TEST_F(SplineContainerBinary, TruncatedFileThrows) {
+  testContainer().exportBinary(file_name_);
+  std::string data = readFile();
+  for (size_t size : {size_t(0), size_t(10), size_t(24), data.size() - 8}) {
+    writeFile(data.substr(0, size));
+    SplineContainer<SmoothSpline> container;
+    EXPECT_THROW(container.importBinary(file_name_), std::logic_error) << "size = " << size;
+  }
+}
+
+TEST_F(SplineContainerBinary, InvalidSplineCountThrows) {
+  testContainer().exportBinary(file_name_);
+  std::string data = readFile();
+  // The counts in the header are not covered by the checksum
+  for (uint32_t spline_count : {uint32_t(2), uint32_t(4), uint32_t(0xFFFFFFFF)}) {
+    std::memcpy(&data[8], &spline_count, sizeof(spline_count));
+    writeFile(data);
+    SplineContainer<SmoothSpline> container;
+    EXPECT_THROW(container.importBinary(file_name_), std::logic_error) << "spline count = " << spline_count;
+  }
+}
+
+TEST_F(SplineContainerBinary, InvalidPartCountThrows) {
+  testContainer().exportBinary(file_name_);
+  std::string data = readFile();
+  uint32_t part_count;
+  std::memcpy(&part_count, &data[12], sizeof(part_count));
+  part_count++;
+  std::memcpy(&data[12], &part_count, sizeof(part_count));
+  writeFile(data);
+  SplineContainer<SmoothSpline> container;
+  EXPECT_THROW(container.importBinary(file_name_), std::logic_error);
+}
@@ -0,0 +1,84 @@
+#ifndef BITBOTS_LOCALIZATION_HYPOTHESISCLUSTERING_H
+#define BITBOTS_LOCALIZATION_HYPOTHESISCLUSTERING_H
+
+#include <array>
+#include <bitbots_localization/ParticleArrays.hpp>
+#include <bitbots_localization/RobotState.hpp>
+#include <cstdint>
+#include <unordered_map>
+#include <vector>
+
+namespace bitbots_localization {
+
+/**
+ * @brief One pose hypothesis, i.e. a cluster of particles
+ */
+struct PoseHypothesis {
+  RobotState mean;
+  // Row major 6x6 pose covariance (x, y, z, roll, pitch, yaw)
+  std::array<double, 36> covariance{};
+  // Share of the particle weight in this cluster
+  double weight = 0;
+};
+
+/**
+ * @class HypothesisClustering
+ * @brief Groups the particles into pose hypotheses.
+ *
+ * The particles are hashed into a grid over x, y and theta, which accumulates the weighted moments of each cell in a
+ * single pass. Neighboring occupied cells are merged into clusters, whose moments give the mean and covariance of each
+ * hypothesis without another pass over the particles. This makes ambiguities like the symmetric field visible.
+ */
+class HypothesisClustering {
+ public:
+  /**
+   * @param bin_size_x Size of a grid cell in x direction (m)
+   * @param bin_size_y Size of a grid cell in y direction (m)
+   * @param bin_size_theta Size of a grid cell in theta direction (rad)
+   * @param max_hypotheses Maximum number of returned hypotheses
+   */
+  HypothesisClustering(double bin_size_x, double bin_size_y, double bin_size_theta, size_t max_hypotheses);
+
+  /**
+   * Clusters the given particles
+   * @param particles Weighted particles
+   * @param ignore_explorers If true, explorer particles are not clustered
+   * @return Hypotheses sorted by descending weight
+   */
+  const std::vector<PoseHypothesis> &update(const ParticleArrays &particles, bool ignore_explorers);
+
+  const std::vector<PoseHypothesis> &hypotheses() const;
+
+ private:
+  // Weighted sums of the particles in a cell or cluster
+  struct Moments {
+    double w = 0, x = 0, y = 0, s = 0, c = 0;
+    double xx = 0, xy = 0, yy = 0, ss = 0, sc = 0, cc = 0, xs = 0, xc = 0, ys = 0, yc = 0;
+
+    void add(const Moments &other);
+  };
+
+  struct Cell {
+    uint32_t x, y, theta;
+    Moments moments;
+    bool visited = false;
+  };
+
+  uint64_t key(uint32_t x, uint32_t y, uint32_t theta) const;
+
+  PoseHypothesis toHypothesis(const Moments &moments, double total_weight) const;
+
+  double bin_size_x_, bin_size_y_, bin_size_theta_;
+  uint32_t theta_bins_;
+  size_t max_hypotheses_;
+
+  // Reused buffers of the occupied cells, the lookup from cell key to cell and the flood fill
+  std::vector<Cell> cells_;
+  std::unordered_map<uint64_t, uint32_t> cell_lookup_;
+  std::vector<uint32_t> stack_;
+  std::vector<Moments> clusters_;
+  std::vector<PoseHypothesis> hypotheses_;
+};
+}  // namespace bitbots_localization
+
+#endif  // BITBOTS_LOCALIZATION_HYPOTHESISCLUSTERING_H
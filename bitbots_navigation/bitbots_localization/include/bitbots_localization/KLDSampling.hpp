@@ -0,0 +1,55 @@
+#ifndef BITBOTS_LOCALIZATION_KLDSAMPLING_H
+#define BITBOTS_LOCALIZATION_KLDSAMPLING_H
+
+#include <particle_filter/ParticleFilter.h>
+
+#include <bitbots_localization/RobotState.hpp>
+#include <cstdint>
+#include <vector>
+
+namespace bitbots_localization {
+/**
+ * @class KLDSampling
+ * @brief Calculates the number of particles that is needed to represent the current belief (KLD-sampling).
+ *
+ * The particles are sorted into a histogram over x, y and theta. The number of occupied bins determines the
+ * number of particles, so that the Kullback-Leibler distance between the sample based and the true
+ * distribution stays below epsilon with the probability given by the z quantile (Fox, 2003).
+ */
+class KLDSampling {
+ public:
+  /**
+   * @param bin_size_x Size of a histogram bin in x direction (m)
+   * @param bin_size_y Size of a histogram bin in y direction (m)
+   * @param bin_size_theta Size of a histogram bin in theta direction (rad)
+   * @param epsilon Maximum error between the sample based and the true distribution
+   * @param z_quantile Upper quantile of the standard normal distribution for the probability of staying below epsilon
+   * @param min_particles Lower bound of the particle count
+   * @param max_particles Upper bound of the particle count
+   */
+  KLDSampling(double bin_size_x, double bin_size_y, double bin_size_theta, double epsilon, double z_quantile,
+              size_t min_particles, size_t max_particles);
+
+  /**
+   * Changes the parameters, the arguments are the same as for the constructor
+   */
+  void set_parameters(double bin_size_x, double bin_size_y, double bin_size_theta, double epsilon, double z_quantile,
+                      size_t min_particles, size_t max_particles);
+
+  /**
+   * @param particles Current (resampled) particles
+   * @return Number of particles that is needed for the belief represented by the particles
+   */
+  size_t required_particles(const std::vector<particle_filter::Particle<RobotState> *> &particles);
+
+ private:
+  double bin_size_x_, bin_size_y_, bin_size_theta_;
+  double epsilon_, z_quantile_;
+  size_t min_particles_, max_particles_;
+
+  // Reused buffer for the bin keys of the particles
+  std::vector<uint64_t> bins_;
+};
+}  // namespace bitbots_localization
+
+#endif  // BITBOTS_LOCALIZATION_KLDSAMPLING_H
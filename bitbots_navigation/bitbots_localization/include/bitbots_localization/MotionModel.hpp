@@ -13,6 +13,7 @@
 #include <cstdlib>
 #include <geometry_msgs/msg/vector3.hpp>
 #include <memory>
+#include <random>
 
 namespace bitbots_localization {
 /**
@@ -48,6 +49,19 @@ class RobotMotionModel : public particle_filter::MovementModel<RobotState> {
    */
   void diffuse(RobotState &state) const override;
 
+  /**
+   * Same as drift(), but draws the noise from the given random number stream, so it can be called from multiple
+   * threads at once.
+   */
+  void drift(RobotState &state, geometry_msgs::msg::Vector3 linear, geometry_msgs::msg::Vector3 angular,
+             std::mt19937 &generator) const;
+
+  /**
+   * Same as diffuse(), but draws the noise from the given random number stream, so it can be called from multiple
+   * threads at once.
+   */
+  void diffuse(RobotState &state, std::mt19937 &generator) const;
+
   double diffuse_multiplier_;
 
  protected:
@@ -60,6 +74,13 @@ class RobotMotionModel : public particle_filter::MovementModel<RobotState> {
   Eigen::Matrix<double, 3, 2> drift_cov_;
 
   double sample(double b) const;
+
+  template <class Sampler>
+  void drift_with_sampler(RobotState &state, geometry_msgs::msg::Vector3 linear_movement,
+                          geometry_msgs::msg::Vector3 rotational_movement, const Sampler &sample) const;
+
+  template <class Sampler>
+  void diffuse_with_sampler(RobotState &state, const Sampler &sample) const;
 };
 };      // namespace bitbots_localization
 #endif  // BITBOTS_LOCALIZATION_MOTIONMODEL_H
@@ -7,6 +7,7 @@
 
 #include <particle_filter/ParticleFilter.h>
 
+#include <bitbots_localization/ParticleWorkers.hpp>
 #include <bitbots_localization/RobotState.hpp>
 #include <bitbots_localization/map.hpp>
 #include <bitbots_localization/tools.hpp>
@@ -41,11 +42,19 @@ class RobotPoseObservationModel : public particle_filter::ObservationModel<Robot
    */
   double measure(const RobotState &state) const override;
 
-  void set_measurement_lines_pc(sm::msg::PointCloud2 measurement);
+  /**
+   * Rates all given particles in parallel and sets their weights in the same way as the measure step of the
+   * particle filter, i.e. the new weights are added to the previous ones and normalized afterwards.
+   * @param particles All particles of the particle filter
+   * @param workers Workers that split the particles between the threads
+   */
+  void weigh_particles(const std::vector<particle_filter::Particle<RobotState> *> &particles, ParticleWorkers &workers);
+
+  void set_measurement_lines_pc(const sm::msg::PointCloud2 &measurement);
 
-  void set_measurement_goalposts(sv3dm::msg::GoalpostArray measurement);
+  void set_measurement_goalposts(const sv3dm::msg::GoalpostArray &measurement);
 
-  void set_measurement_field_boundary(sv3dm::msg::FieldBoundary measurement);
+  void set_measurement_field_boundary(const sv3dm::msg::FieldBoundary &measurement);
 
   void set_measurement_markings(sv3dm::msg::MarkingArray measurement);
 
@@ -62,14 +71,28 @@ class RobotPoseObservationModel : public particle_filter::ObservationModel<Robot
   bool measurements_available() override;
 
  private:
-  double calculate_weight_for_class(const RobotState &state,
-                                    const std::vector<std::pair<double, double>> &last_measurement,
-                                    std::shared_ptr<Map> map, double element_weight) const;
-
-  // Measurements
-  std::vector<std::pair<double, double>> last_measurement_lines_;
-  std::vector<std::pair<double, double>> last_measurement_goal_;
-  std::vector<std::pair<double, double>> last_measurement_field_boundary_;
+  double calculate_weight(const RobotState &state) const;
+
+  /**
+   * Replaces all measurements inside a voxel by their centroid
+   * @param measurement Measurements that are downsampled in place
+   * @param voxel_size Edge length of the voxels in m, 0 disables the downsampling
+   */
+  void downsample(MeasurementPoints &measurement, double voxel_size);
+
+  double calculate_weight_for_class(const RobotState &state, const MeasurementPoints &last_measurement,
+                                    const std::shared_ptr<Map> &map, double element_weight) const;
+
+  // Measurements in cartesian coordinates relative to the robot
+  MeasurementPoints last_measurement_lines_;
+  MeasurementPoints last_measurement_goal_;
+  MeasurementPoints last_measurement_field_boundary_;
+
+  // Buffers for the downsampling that are reused between measurements
+  std::vector<std::pair<uint64_t, uint32_t>> voxel_keys_;
+  MeasurementPoints downsampled_;
+
+  // Weights that were calculated in parallel for the current particles and the next particle to look up
 
   // Reference to the maps for the different classes
   std::shared_ptr<Map> map_lines_;
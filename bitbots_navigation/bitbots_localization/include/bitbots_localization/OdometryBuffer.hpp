@@ -0,0 +1,85 @@
+#ifndef BITBOTS_LOCALIZATION_ODOMETRYBUFFER_H
+#define BITBOTS_LOCALIZATION_ODOMETRYBUFFER_H
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <optional>
+#include <vector>
+
+namespace bitbots_localization {
+
+/**
+ * @brief Planar odometry pose at a point in time
+ */
+struct OdometryPose {
+  // Time stamp in nanoseconds
+  int64_t stamp = 0;
+  double x = 0;
+  double y = 0;
+  double theta = 0;
+};
+
+/**
+ * @class OdometryBuffer
+ * @brief Buffers the odometry poses between the odometry callback and the filter step.
+ *
+ * The odometry callback pushes into a lock-free single producer, single consumer ring buffer, so it never waits for
+ * the filter. The filter step moves the new poses into a short history, which is used to interpolate the odometry
+ * pose at arbitrary time stamps (e.g. the capture time of a measurement).
+ */
+class OdometryBuffer {
+ public:
+  /**
+   * @param capacity Number of poses the ring buffer can hold between two filter steps, rounded up to a power of two
+   * @param history_duration Duration (s) for which the poses are kept for the interpolation
+   */
+  OdometryBuffer(size_t capacity, double history_duration);
+
+  /**
+   * Adds a pose, called by the producer only. If the consumer falls behind and the ring buffer is full, the pose is
+   * dropped. As the poses are absolute, this only reduces the temporal resolution.
+   * @param pose The odometry pose
+   * @return False if the pose was dropped
+   */
+  bool push(const OdometryPose &pose);
+
+  /**
+   * Returns the interpolated pose at the given time stamp, called by the consumer only.
+   * Time stamps outside of the history are clamped to the oldest or newest pose.
+   * @param stamp Time stamp in nanoseconds
+   * @return The pose or nothing if no odometry was received yet
+   */
+  std::optional<OdometryPose> pose_at(int64_t stamp);
+
+  /**
+   * Returns the newest pose, called by the consumer only
+   * @return The pose or nothing if no odometry was received yet
+   */
+  std::optional<OdometryPose> latest();
+
+  /**
+   * Removes all poses, called by the consumer only
+   */
+  void clear();
+
+ private:
+  /**
+   * Moves the new poses from the ring buffer into the history and removes outdated poses
+   */
+  void drain();
+
+  std::vector<OdometryPose> ring_;
+  size_t mask_;
+  // Index of the next pose that is written by the producer
+  std::atomic<size_t> head_{0};
+  // Index of the next pose that is read by the consumer
+  std::atomic<size_t> tail_{0};
+
+  // Poses of the last history_duration_ nanoseconds, sorted by their time stamps, only used by the consumer
+  std::vector<OdometryPose> history_;
+  int64_t history_duration_;
+};
+}  // namespace bitbots_localization
+
+#endif  // BITBOTS_LOCALIZATION_ODOMETRYBUFFER_H
@@ -0,0 +1,67 @@
+#ifndef BITBOTS_LOCALIZATION_PARTICLEARRAYS_H
+#define BITBOTS_LOCALIZATION_PARTICLEARRAYS_H
+
+#include <particle_filter/ParticleFilter.h>
+
+#include <bitbots_localization/RobotState.hpp>
+#include <cstdint>
+#include <vector>
+
+namespace bitbots_localization {
+/**
+ * @class ParticleArrays
+ * @brief Contiguous struct of arrays copy of a particle list.
+ *
+ * The particle filter library stores its particles as a list of pointers. Gathering them once into separate arrays
+ * lets the resampling, estimate and covariance calculations run over contiguous memory. The orientation is kept as
+ * sine and cosine, so none of these calculations needs trigonometric functions per particle.
+ */
+class ParticleArrays {
+ public:
+  /**
+   * Copies the states, weights and explorer flags of all particles into the arrays. The buffers are reused.
+   */
+  void gather(const std::vector<particle_filter::Particle<RobotState> *> &particles);
+
+  /**
+   * Computes the inclusive prefix sum of the weights
+   */
+  void computeCumulativeWeights();
+
+  /**
+   * Draws particles with the systematic (low variance) resampling scheme. Needs the cumulative weights.
+   * @param start Random start in [0, 1) of the first sample, relative to the sample distance
+   * @param count Number of samples
+   * @param indices Output of the indices of the drawn particles, sorted ascending
+   */
+  void systematicResample(double start, size_t count, std::vector<uint32_t> &indices) const;
+
+  /**
+   * Calculates the weighted mean and covariance of the best particles
+   * @param percentage Percentage of the particles with the highest weight that are used
+   * @param ignore_explorers If true, explorer particles are not used
+   * @param mean Weighted mean state
+   * @param covariance Row major 6x6 pose covariance (x, y, z, roll, pitch, yaw), the orientation is linearized
+   * around the mean
+   */
+  void estimate(int percentage, bool ignore_explorers, RobotState &mean, std::vector<double> &covariance);
+
+  RobotState state(size_t index) const;
+
+  size_t size() const;
+
+  std::vector<double> x;
+  std::vector<double> y;
+  std::vector<double> sin_theta;
+  std::vector<double> cos_theta;
+  std::vector<double> weight;
+  std::vector<uint8_t> explorer;
+  std::vector<double> cumulative_weight;
+
+ private:
+  // Reused buffer for the selection of the best particles
+  std::vector<uint32_t> selection_;
+};
+}  // namespace bitbots_localization
+
+#endif  // BITBOTS_LOCALIZATION_PARTICLEARRAYS_H
@@ -0,0 +1,74 @@
+#ifndef BITBOTS_LOCALIZATION_PARTICLEWORKERS_H
+#define BITBOTS_LOCALIZATION_PARTICLEWORKERS_H
+
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <mutex>
+#include <random>
+#include <thread>
+#include <vector>
+
+namespace bitbots_localization {
+/**
+ * @class ParticleWorkers
+ * @brief Splits per particle work into one contiguous chunk per thread.
+ *
+ * The worker threads are started once and wait for the next task, so a filter step does not create any threads.
+ * Every chunk owns its own random number stream, which is seeded from the given seed and the chunk index.
+ * As the chunk boundaries only depend on the number of particles and threads, the results are deterministic
+ * for a fixed seed and thread count.
+ */
+class ParticleWorkers {
+ public:
+  using ChunkFunction = std::function<void(std::mt19937 &generator, size_t begin, size_t end)>;
+
+  /**
+   * @param thread_count Number of threads (including the calling thread) that are used
+   * @param seed Seed of the per thread random number streams
+   */
+  ParticleWorkers(size_t thread_count, unsigned int seed);
+
+  ~ParticleWorkers();
+
+  ParticleWorkers(const ParticleWorkers &) = delete;
+  ParticleWorkers &operator=(const ParticleWorkers &) = delete;
+
+  /**
+   * Runs the given function for all chunks of the range [0, count) and waits until all chunks are done.
+   * The first chunk is processed by the calling thread.
+   * @param count Number of elements
+   * @param function Function that is called with the random number stream of the chunk and its range [begin, end)
+   */
+  void for_each_chunk(size_t count, const ChunkFunction &function);
+
+  size_t thread_count() const;
+
+ private:
+  /**
+   * Waits for the tasks and processes the given chunk of each of them
+   * @param chunk Index of the chunk of this worker
+   */
+  void loop(size_t chunk);
+
+  std::vector<std::mt19937> generators_;
+
+  std::mutex mutex_;
+  std::condition_variable task_condition_;
+  std::condition_variable done_condition_;
+  // Incremented for every task, so each worker processes every task exactly once
+  uint64_t generation_{0};
+  // Number of workers which did not finish the current task yet
+  size_t pending_{0};
+  bool stop_{false};
+  // The current task, only valid until all workers are done
+  const ChunkFunction *function_{nullptr};
+  size_t count_{0};
+  size_t chunks_{0};
+
+  std::vector<std::thread> threads_;
+};
+}  // namespace bitbots_localization
+
+#endif  // BITBOTS_LOCALIZATION_PARTICLEWORKERS_H
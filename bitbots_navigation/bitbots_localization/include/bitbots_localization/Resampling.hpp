@@ -5,6 +5,7 @@
 #ifndef IMPORTANCERESAMPLINGWE_H
 #define IMPORTANCERESAMPLINGWE_H
 
+#include <bitbots_localization/ParticleArrays.hpp>
 #include <cassert>
 
 #include "particle_filter/CRandomNumberGenerator.h"
@@ -23,9 +24,14 @@ class ImportanceResamplingWE : public particle_filter::ImportanceResampling<Stat
  public:
   /**
    * The constructor of this base class inits some members.
+   * @param explorer_count Number of particles which are drawn from the distribution instead of being resampled
+   * @param distribution Distribution of the explorer particles
+   * @param reset_weights If true, the weights of all particles are set to reset_weight after resampling
+   * @param reset_weight Weight of the particles after resampling
    */
   ImportanceResamplingWE<StateType>(int explorer_count,
-                                    std::shared_ptr<particle_filter::StateDistribution<StateType>> distribution);
+                                    std::shared_ptr<particle_filter::StateDistribution<StateType>> distribution,
+                                    bool reset_weights, double reset_weight);
 
   /**
    * This is the main method of ImportanceResampling. It takes two references
@@ -37,8 +43,7 @@ class ImportanceResamplingWE : public particle_filter::ImportanceResampling<Stat
   void resample(const ParticleList &source, const ParticleList &destination) const;
 
   /**
-   * Sets the Random Number Generator to use in resample() to generate
-   * uniformly distributed random numbers.
+   * Sets the number of explorer particles, which are drawn from the distribution in resample().
    */
   void setExplorerCount(int explorer_count);
 
@@ -46,50 +51,65 @@ class ImportanceResamplingWE : public particle_filter::ImportanceResampling<Stat
 
  private:
   int explorer_count_;
+  bool reset_weights_;
+  double reset_weight_;
   std::shared_ptr<particle_filter::StateDistribution<StateType>> distribution_;
 
   particle_filter::CRandomNumberGenerator m_RNG;
+
+  // Reused buffers for the source particles and the drawn indices
+  mutable ParticleArrays source_arrays_;
+  mutable std::vector<uint32_t> indices_;
 };
 
 template <class StateType>
 ImportanceResamplingWE<StateType>::ImportanceResamplingWE(
-    int explorer_count, std::shared_ptr<particle_filter::StateDistribution<StateType>> distribution)
-    : explorer_count_(explorer_count), distribution_(distribution) {
-  particle_filter::ImportanceResampling<StateType>();
+    int explorer_count, std::shared_ptr<particle_filter::StateDistribution<StateType>> distribution,
+    bool reset_weights, double reset_weight)
+    : particle_filter::ImportanceResampling<StateType>(reset_weights, reset_weight),
+      explorer_count_(explorer_count),
+      reset_weights_(reset_weights),
+      reset_weight_(reset_weight),
+      distribution_(distribution) {}
+
+template <class StateType>
+void ImportanceResamplingWE<StateType>::setExplorerCount(int explorer_count) {
+  explorer_count_ = explorer_count;
+}
+
+template <class StateType>
+int ImportanceResamplingWE<StateType>::getExplorerCount() {
+  return explorer_count_;
 }
 
 // resampling based on the cumulative distribution function (CDF)
-// this is an implementation of the algorithm presented in Propabilistic
-// Robotics by Sebastian Thrun et al.
+// this is an implementation of the low variance sampler presented in Propabilistic
+// Robotics by Sebastian Thrun et al., running over a contiguous copy of the source particles
 template <class StateType>
 void ImportanceResamplingWE<StateType>::resample(const ParticleList &sourceList,
                                                  const ParticleList &destinationList) const {
   assert(sourceList.size() == destinationList.size());
   // some particles (most of them usually) get resampled and explorer_count
   // particles get assigned a random state
-  int resample_max = sourceList.size() - explorer_count_;
-  double inverseNum = 1.0f / float(resample_max);
-  double start = m_RNG.getUniform() * inverseNum;  // random start in CDF
-  double cumulativeWeight = 0.0f;
-  unsigned int sourceIndex = 0;  // index to draw from
-  cumulativeWeight += sourceList[sourceIndex]->getWeight();
-  for (unsigned int destIndex = 0; destIndex < resample_max; destIndex++) {
-    double probSum = start + inverseNum * destIndex;  // amount of cumulative weight to reach
-    while (probSum > cumulativeWeight) {              // sum weights until
-      sourceIndex++;
-      if (sourceIndex >= sourceList.size()) {
-        sourceIndex = sourceList.size() - 1;
-        break;
-      }
-      cumulativeWeight += sourceList[sourceIndex]->getWeight();  // target sum reached
-    }
-    *(destinationList[destIndex]) = *(sourceList[sourceIndex]);  // copy particle (via assignment
-    // operator)
+  int resample_max = std::max<int>(0, sourceList.size() - explorer_count_);
+
+  // gather the source particles and build the CDF as a prefix sum of the weights
+  source_arrays_.gather(sourceList);
+  source_arrays_.computeCumulativeWeights();
+  source_arrays_.systematicResample(m_RNG.getUniform(), resample_max, indices_);
+
+  for (int destIndex = 0; destIndex < resample_max; destIndex++) {
+    uint32_t sourceIndex = indices_[destIndex];
+    destinationList[destIndex]->setState(source_arrays_.state(sourceIndex));
+    destinationList[destIndex]->setWeight(reset_weights_ ? reset_weight_ : source_arrays_.weight[sourceIndex]);
     destinationList[destIndex]->is_explorer_ = false;
   }
   for (unsigned int destIndex = resample_max; destIndex < destinationList.size(); destIndex++) {
     // drawing the remaining particles randomly
     destinationList[destIndex]->setState(distribution_->draw());
+    if (reset_weights_) {
+      destinationList[destIndex]->setWeight(reset_weight_);
+    }
     destinationList[destIndex]->is_explorer_ = true;
   }
 }
@@ -84,6 +84,24 @@ class RobotStateDistributionOwnHalf : public particle_filter::StateDistribution<
   double max_y_;
 };
 
+/**
+ * Draws uniformly distributed states on the whole field, e.g. for the explorer particles
+ */
+class RobotStateDistributionField : public particle_filter::StateDistribution<RobotState> {
+ public:
+  RobotStateDistributionField(particle_filter::CRandomNumberGenerator &random_number_generator,
+                              std::pair<double, double> field_size);
+
+  const RobotState draw() const override;
+
+ private:
+  particle_filter::CRandomNumberGenerator random_number_generator_;
+  double min_x_;
+  double max_x_;
+  double min_y_;
+  double max_y_;
+};
+
 class RobotStateDistributionPosition : public particle_filter::StateDistribution<RobotState> {
  public:
   RobotStateDistributionPosition(particle_filter::CRandomNumberGenerator &random_number_generator, double x, double y);
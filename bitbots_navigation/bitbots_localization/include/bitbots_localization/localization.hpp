@@ -20,8 +20,13 @@
 #include <tf2_ros/transform_listener.h>
 
 #include <Eigen/Core>
+#include <bitbots_localization/HypothesisClustering.hpp>
+#include <bitbots_localization/KLDSampling.hpp>
 #include <bitbots_localization/MotionModel.hpp>
 #include <bitbots_localization/ObservationModel.hpp>
+#include <bitbots_localization/OdometryBuffer.hpp>
+#include <bitbots_localization/ParticleArrays.hpp>
+#include <bitbots_localization/ParticleWorkers.hpp>
 #include <bitbots_localization/Resampling.hpp>
 #include <bitbots_localization/RobotState.hpp>
 #include <bitbots_localization/StateDistribution.hpp>
@@ -29,6 +34,7 @@
 #include <bitbots_localization/srv/reset_filter.hpp>
 #include <bitbots_localization/srv/set_paused.hpp>
 #include <bitbots_localization/tools.hpp>
+#include <bitbots_msgs/msg/pose_with_certainty_array.hpp>
 #include <bitbots_utils/utils.hpp>
 #include <chrono>
 #include <cv_bridge/cv_bridge.hpp>
@@ -44,6 +50,8 @@
 #include <image_transport/image_transport.hpp>
 #include <iterator>
 #include <memory>
+#include <nav_msgs/msg/odometry.hpp>
+#include <optional>
 #include <rclcpp/rclcpp.hpp>
 #include <sensor_msgs/msg/camera_info.hpp>
 #include <sensor_msgs/msg/point_cloud2.hpp>
@@ -74,8 +82,29 @@ using namespace std::placeholders;
  */
 class Localization {
  public:
+  /**
+   * Durations (s) of the stages of the last filter step
+   */
+  struct StepTimings {
+    double measurements = 0;
+    double motion = 0;
+    double weighting = 0;
+    double resampling = 0;
+    double estimate = 0;
+    double publishing = 0;
+  };
+
   explicit Localization(rclcpp::Node::SharedPtr node);
 
+  /**
+   * Creates the localization for replaying recorded data.
+   * It has no subscribers, services or timers. The inputs are passed to the callbacks and step() runs the filter.
+   * @param node Node that holds the parameters
+   * @param field_name Name of the field, which selects the maps
+   * @param field_dimensions Dimensions of the field
+   */
+  Localization(rclcpp::Node::SharedPtr node, const std::string &field_name, const FieldDimensions &field_dimensions);
+
   /**
    * Callback for the pause service
    * @param req Request.
@@ -98,23 +127,29 @@ class Localization {
    */
   void updateParams(bool force_reload = false);
 
+  /**
+   * Callback for the odometry, the poses are buffered until the next filter step
+   * @param msg Message containing the odometry pose.
+   */
+  void OdometryCallback(nav_msgs::msg::Odometry::ConstSharedPtr msg);
+
   /**
    * Callback for the line point cloud measurements
    * @param msg Message containing the line point cloud.
    */
-  void LinePointcloudCallback(const sm::msg::PointCloud2 &msg);
+  void LinePointcloudCallback(sm::msg::PointCloud2::ConstSharedPtr msg);
 
   /**
    * Callback for goal posts measurements
    * @param msg Message containing the goal posts.
    */
-  void GoalPostsCallback(const sv3dm::msg::GoalpostArray &msg);  // TODO
+  void GoalPostsCallback(sv3dm::msg::GoalpostArray::ConstSharedPtr msg);  // TODO
 
   /**
    * Callback for the relative field boundary measurements
    * @param msg Message containing the field boundary points.
    */
-  void FieldboundaryCallback(const sv3dm::msg::FieldBoundary &msg);
+  void FieldboundaryCallback(sv3dm::msg::FieldBoundary::ConstSharedPtr msg);
 
   /**
    * Resets the state distribution of the state space
@@ -142,6 +177,17 @@ class Localization {
    */
   void reset_filter(int distribution, double x, double y, double angle);
 
+  /**
+   * Runs the filter for one step, independent of the timer
+   */
+  void step();
+
+  const RobotState &get_estimate() const;
+
+  const StepTimings &get_step_timings() const;
+
+  size_t get_particle_count() const;
+
  private:
   // Reference to the node
   rclcpp::Node::SharedPtr node_;
@@ -156,6 +202,7 @@ class Localization {
   std::string field_name_;
 
   // Declare subscribers
+  rclcpp::Subscription<nav_msgs::msg::Odometry>::SharedPtr odometry_subscriber_;
   rclcpp::Subscription<sm::msg::PointCloud2>::SharedPtr line_point_cloud_subscriber_;
   rclcpp::Subscription<sv3dm::msg::GoalpostArray>::SharedPtr goal_subscriber_;
   rclcpp::Subscription<sv3dm::msg::FieldBoundary>::SharedPtr fieldboundary_subscriber_;
@@ -164,6 +211,7 @@ class Localization {
 
   // Declare publishers
   rclcpp::Publisher<gm::msg::PoseWithCovarianceStamped>::SharedPtr pose_with_covariance_publisher_;
+  rclcpp::Publisher<bitbots_msgs::msg::PoseWithCertaintyArray>::SharedPtr pose_hypotheses_publisher_;
   rclcpp::Publisher<visualization_msgs::msg::MarkerArray>::SharedPtr pose_particles_publisher_;
   rclcpp::Publisher<visualization_msgs::msg::Marker>::SharedPtr lines_publisher_;
   rclcpp::Publisher<visualization_msgs::msg::Marker>::SharedPtr line_ratings_publisher_;
@@ -184,24 +232,38 @@ class Localization {
   std::shared_ptr<tf2_ros::TransformBroadcaster> br;
 
   // Declare particle filter components
-  std::shared_ptr<pf::ImportanceResampling<RobotState>> resampling_;
+  std::shared_ptr<ImportanceResamplingWE<RobotState>> resampling_;
   std::shared_ptr<RobotPoseObservationModel> robot_pose_observation_model_;
   std::shared_ptr<RobotMotionModel> robot_motion_model_;
   std::shared_ptr<particle_filter::ParticleFilter<RobotState>> robot_pf_;
 
+  // Splits the propagation and weighting of the particles between multiple threads
+  std::unique_ptr<ParticleWorkers> particle_workers_;
+
+  // Calculates the adaptive particle count
+  std::unique_ptr<KLDSampling> kld_sampling_;
+
   // Declare initial state distributions
   std::shared_ptr<RobotStateDistributionOwnSideline> robot_state_distribution_own_sidelines;
   std::shared_ptr<RobotStateDistributionOwnHalf> robot_state_distribution_own_half_;
   std::shared_ptr<RobotStateDistributionOpponentHalf> robot_state_distribution_opponent_half;
+  // Distribution of the explorer particles
+  std::shared_ptr<RobotStateDistributionField> robot_state_distribution_field_;
 
   // Declare filter estimate
   RobotState estimate_;
   std::vector<double> estimate_cov_;
 
-  // Declare input message buffers
-  sm::msg::PointCloud2 line_pointcloud_relative_;
-  sv3dm::msg::GoalpostArray goal_posts_relative_;
-  sv3dm::msg::FieldBoundary fieldboundary_relative_;
+  // Contiguous copy of the particles that is used to calculate the estimate
+  ParticleArrays particle_arrays_;
+
+  // Groups the particles into multiple pose hypotheses
+  std::unique_ptr<HypothesisClustering> hypothesis_clustering_;
+
+  // Declare input message buffers, they share the received messages instead of copying them
+  sm::msg::PointCloud2::ConstSharedPtr line_pointcloud_relative_;
+  sv3dm::msg::GoalpostArray::ConstSharedPtr goal_posts_relative_;
+  sv3dm::msg::FieldBoundary::ConstSharedPtr fieldboundary_relative_;
 
   // Declare time stamps
   rclcpp::Time last_stamp_lines = rclcpp::Time(0);
@@ -216,8 +278,14 @@ class Localization {
   geometry_msgs::msg::Vector3 linear_movement_;
   geometry_msgs::msg::Vector3 rotational_movement_;
 
-  // Keep track of the odometry transform in the last step
-  geometry_msgs::msg::TransformStamped previousOdomTransform_;
+  // Odometry poses that were received since the last step, written by the odometry callback
+  OdometryBuffer odometry_buffer_{1024, 1.0};
+
+  // Keep track of the odometry pose in the last step
+  std::optional<OdometryPose> previous_odom_pose_;
+
+  // Newest capture time (ns) of the measurements of this step, if there are new measurements
+  std::optional<int64_t> measurement_stamp_;
 
   // Flag that checks if the robot is moving
   bool robot_moved = false;
@@ -225,6 +293,9 @@ class Localization {
   // Keep track of the number of filter steps
   int timer_callback_count_ = 0;
 
+  // Durations of the stages of the last filter step
+  StepTimings step_timings_;
+
   // Maps for the different measurement classes
   std::shared_ptr<Map> lines_;
   std::shared_ptr<Map> goals_;
@@ -233,11 +304,33 @@ class Localization {
   // RNG that is used for the different sampling steps
   particle_filter::CRandomNumberGenerator random_number_generator_;
 
+  /**
+   * Creates the publishers and the filter components and initializes the particles
+   */
+  void init_filter();
+
   /**
    * Runs the filter for one step
    */
   void run_filter_one_step();
 
+  /**
+   * Applies the odometry drift and optionally the diffusion to all particles using the particle workers.
+   * The noise is drawn from the seeded random number streams of the workers, also if only one thread is used.
+   * @param diffuse If true, the diffusion is applied after the drift
+   */
+  void propagate_particles(bool diffuse);
+
+  /**
+   * Resizes the particle filter to the particle count required by KLD-sampling, keeping the resampled belief
+   */
+  void adapt_particle_count();
+
+  /**
+   * Calculates the estimate, its covariance and the pose hypotheses once per step
+   */
+  void update_estimate();
+
   /**
    * Publishes the position as a transform
    */
@@ -248,6 +341,11 @@ class Localization {
    */
   void publish_pose_with_covariance();
 
+  /**
+   * Publishes the pose hypotheses, i.e. the particle clusters, as a message
+   */
+  void publish_hypotheses();
+
   /**
    * Debug publisher
    */
@@ -281,9 +379,11 @@ class Localization {
   void updateMeasurements();
 
   /**
-   * Gets the and convert motion / odometry information
+   * Gets the motion between two odometry poses in the local frame of the first one
+   * @param from Odometry pose at the start of the motion
+   * @param to Odometry pose at the end of the motion
    */
-  void getMotion();
+  void getMotion(const OdometryPose &from, const OdometryPose &to);
 };
 };  // namespace bitbots_localization
 
@@ -25,9 +25,43 @@ struct FieldDimensions {
   double padding = 0;  // in m, padding is the distance from the field lines to the field boundary
 };
 
+/**
+ * @brief Measurement points of one class in cartesian coordinates relative to the robot.
+ * The coordinates are stored in separate arrays, so they can be processed in a vectorized way.
+ */
+struct MeasurementPoints {
+  std::vector<double> x;
+  std::vector<double> y;
+
+  void add(double point_x, double point_y) {
+    x.push_back(point_x);
+    y.push_back(point_y);
+  }
+
+  // Keeps the capacity, so the buffers are reused for the next measurement
+  void clear() {
+    x.clear();
+    y.clear();
+  }
+
+  void reserve(size_t count) {
+    x.reserve(count);
+    y.reserve(count);
+  }
+
+  size_t size() const { return x.size(); }
+
+  bool empty() const { return x.empty(); }
+};
+
 /**
  * @class Map
  * @brief Stores a map for a messurement class (e.g. a map of the lines)
+ *
+ * The map image is compiled into a normalized float likelihood field with a border of one cell, which holds the out of
+ * map value. Lookups are clamped onto this border, so no out of map checks are needed. Coarser levels of the field can
+ * be generated as an image pyramid. The compiled field is cached in a binary file under $ROS_HOME, which is memory
+ * mapped on the next start.
  */
 class Map {
  public:
@@ -35,23 +69,59 @@ class Map {
    * @param name of the environment. (E.g. webots)
    * @param type of the map. (E.g. lines)
    * @param out_of_map_value value used for padding the out of field area.
+   * @param pyramid_levels number of resolution levels, each level halves the resolution of the previous one
+   * @param use_cache if true, the compiled map is loaded from and stored in a cache file under $ROS_HOME
    */
-  explicit Map(const std::string& name, const std::string& type, const double out_of_map_value);
+  explicit Map(const std::string& name, const std::string& type, const double out_of_map_value,
+               int pyramid_levels = 1, bool use_cache = true);
 
-  cv::Mat map;
+  ~Map();
 
-  std::vector<double> provideRating(const RobotState& state,
-                                    const std::vector<std::pair<double, double>>& observations);
+  Map(const Map&) = delete;
+  Map& operator=(const Map&) = delete;
 
-  double get_occupancy(double x, double y);
+  /**
+   * Sums up the occupancy of all measurements for a given particle state without allocating memory
+   * @param state State of the particle
+   * @param measurements Measurements relative to the robot
+   * @param level Resolution level of the map that is used, it is clamped to the available levels
+   * @return Sum of the occupancy values
+   */
+  double rateMeasurements(const RobotState& state, const MeasurementPoints& measurements, int level = 0) const;
+
+  double get_occupancy(double x, double y) const;
+
+  double get_out_of_map_value() const;
 
   std::pair<double, double> observationRelative(std::pair<double, double> observation, double stateX, double stateY,
                                                 double stateT);
 
-  nav_msgs::msg::OccupancyGrid get_map_msg(std::string frame_id, int threshold = -1);
+  /**
+   * Returns the map as an occupancy grid. The message is only built once and reused afterwards.
+   */
+  const nav_msgs::msg::OccupancyGrid& get_map_msg(const std::string& frame_id, int threshold = -1);
 
  private:
+  // Padded likelihood field of one resolution level
+  struct Level {
+    cv::Mat likelihood;
+    double cells_per_meter;
+  };
+
+  void compile(const cv::Mat& image, int pyramid_levels);
+
+  bool load_cache(const std::string& path, int64_t source_time, int pyramid_levels);
+
+  void save_cache(const std::string& path, int64_t source_time) const;
+
   double out_of_map_value_;
+  std::vector<Level> levels_;
+
+  // Memory mapping of the cache file that backs the levels if they were loaded from the cache
+  void* cache_mapping_ = nullptr;
+  size_t cache_size_ = 0;
+
+  nav_msgs::msg::OccupancyGrid map_msg_;
 };
 };      // namespace bitbots_localization
 #endif  // BITBOTS_LOCALIZATION_MAP_H
@@ -0,0 +1,155 @@
+#include <algorithm>
+#include <bitbots_localization/HypothesisClustering.hpp>
+#include <cmath>
+
+namespace bitbots_localization {
+
+void HypothesisClustering::Moments::add(const Moments &other) {
+  w += other.w;
+  x += other.x;
+  y += other.y;
+  s += other.s;
+  c += other.c;
+  xx += other.xx;
+  xy += other.xy;
+  yy += other.yy;
+  ss += other.ss;
+  sc += other.sc;
+  cc += other.cc;
+  xs += other.xs;
+  xc += other.xc;
+  ys += other.ys;
+  yc += other.yc;
+}
+
+HypothesisClustering::HypothesisClustering(double bin_size_x, double bin_size_y, double bin_size_theta,
+                                           size_t max_hypotheses)
+    : bin_size_x_(bin_size_x),
+      bin_size_y_(bin_size_y),
+      theta_bins_(std::max<uint32_t>(1, static_cast<uint32_t>(std::round(2 * M_PI / bin_size_theta)))),
+      max_hypotheses_(max_hypotheses) {
+  // Round the bin size, so the bins wrap around exactly
+  bin_size_theta_ = 2 * M_PI / theta_bins_;
+}
+
+uint64_t HypothesisClustering::key(uint32_t x, uint32_t y, uint32_t theta) const {
+  return static_cast<uint64_t>(x & 0x1fffff) << 42 | static_cast<uint64_t>(y & 0x1fffff) << 21 | (theta & 0x1fffff);
+}
+
+const std::vector<PoseHypothesis> &HypothesisClustering::update(const ParticleArrays &particles,
+                                                                bool ignore_explorers) {
+  cells_.clear();
+  cell_lookup_.clear();
+  clusters_.clear();
+  hypotheses_.clear();
+
+  // Accumulate the weighted moments of all particles in their grid cell
+  double total_weight = 0;
+  for (size_t i = 0; i < particles.size(); i++) {
+    if (ignore_explorers && particles.explorer[i]) {
+      continue;
+    }
+    double theta = std::atan2(particles.sin_theta[i], particles.cos_theta[i]);
+    auto cell_x = static_cast<uint32_t>(static_cast<int32_t>(std::floor(particles.x[i] / bin_size_x_)) + (1 << 20));
+    auto cell_y = static_cast<uint32_t>(static_cast<int32_t>(std::floor(particles.y[i] / bin_size_y_)) + (1 << 20));
+    auto cell_theta = static_cast<uint32_t>(std::floor((theta + M_PI) / bin_size_theta_)) % theta_bins_;
+
+    auto [lookup, inserted] = cell_lookup_.try_emplace(key(cell_x, cell_y, cell_theta), cells_.size());
+    if (inserted) {
+      cells_.push_back({cell_x, cell_y, cell_theta, {}, false});
+    }
+    Moments &m = cells_[lookup->second].moments;
+    double w = particles.weight[i], x = particles.x[i], y = particles.y[i];
+    double s = particles.sin_theta[i], c = particles.cos_theta[i];
+    m.w += w;
+    m.x += w * x;
+    m.y += w * y;
+    m.s += w * s;
+    m.c += w * c;
+    m.xx += w * x * x;
+    m.xy += w * x * y;
+    m.yy += w * y * y;
+    m.ss += w * s * s;
+    m.sc += w * s * c;
+    m.cc += w * c * c;
+    m.xs += w * x * s;
+    m.xc += w * x * c;
+    m.ys += w * y * s;
+    m.yc += w * y * c;
+    total_weight += w;
+  }
+
+  // Merge neighboring cells into clusters with a flood fill, theta wraps around
+  for (uint32_t start = 0; start < cells_.size(); start++) {
+    if (cells_[start].visited) {
+      continue;
+    }
+    Moments cluster;
+    cells_[start].visited = true;
+    stack_.assign(1, start);
+    while (!stack_.empty()) {
+      const Cell cell = cells_[stack_.back()];
+      stack_.pop_back();
+      cluster.add(cell.moments);
+      for (int dx = -1; dx <= 1; dx++) {
+        for (int dy = -1; dy <= 1; dy++) {
+          for (int dt = -1; dt <= 1; dt++) {
+            uint32_t theta = (cell.theta + theta_bins_ + dt) % theta_bins_;
+            auto neighbor = cell_lookup_.find(key(cell.x + dx, cell.y + dy, theta));
+            if (neighbor != cell_lookup_.end() && !cells_[neighbor->second].visited) {
+              cells_[neighbor->second].visited = true;
+              stack_.push_back(neighbor->second);
+            }
+          }
+        }
+      }
+    }
+    clusters_.push_back(cluster);
+  }
+
+  // Keep the clusters with the highest weight
+  size_t count = std::min(max_hypotheses_, clusters_.size());
+  std::partial_sort(clusters_.begin(), clusters_.begin() + count, clusters_.end(),
+                    [](const Moments &a, const Moments &b) { return a.w > b.w; });
+  for (size_t i = 0; i < count; i++) {
+    hypotheses_.push_back(toHypothesis(clusters_[i], total_weight));
+  }
+  return hypotheses_;
+}
+
+const std::vector<PoseHypothesis> &HypothesisClustering::hypotheses() const { return hypotheses_; }
+
+PoseHypothesis HypothesisClustering::toHypothesis(const Moments &m, double total_weight) const {
+  PoseHypothesis hypothesis;
+  double w = m.w > 0 ? m.w : 1;
+  hypothesis.weight = total_weight > 0 ? m.w / total_weight : 0;
+
+  double mean_x = m.x / w;
+  double mean_y = m.y / w;
+  double norm = std::hypot(m.s, m.c);
+  double mean_sin = norm > 0 ? m.s / norm : 0;
+  double mean_cos = norm > 0 ? m.c / norm : 1;
+  hypothesis.mean = RobotState(mean_x, mean_y, 0);
+  hypothesis.mean.setSinTheta(mean_sin);
+  hypothesis.mean.setCosTheta(mean_cos);
+
+  // The angular deviation of a particle is linearized as sin(theta - mean) = s * mean_cos - c * mean_sin
+  double mean_dt = (m.s * mean_cos - m.c * mean_sin) / w;
+  double xx = m.xx / w - mean_x * mean_x;
+  double xy = m.xy / w - mean_x * mean_y;
+  double yy = m.yy / w - mean_y * mean_y;
+  double xt = (m.xs * mean_cos - m.xc * mean_sin) / w - mean_x * mean_dt;
+  double yt = (m.ys * mean_cos - m.yc * mean_sin) / w - mean_y * mean_dt;
+  double tt = (m.ss * mean_cos * mean_cos - 2 * m.sc * mean_cos * mean_sin + m.cc * mean_sin * mean_sin) / w -
+              mean_dt * mean_dt;
+
+  hypothesis.covariance[0] = std::max(xx, 0.0);
+  hypothesis.covariance[1] = hypothesis.covariance[6] = xy;
+  hypothesis.covariance[5] = hypothesis.covariance[30] = xt;
+  hypothesis.covariance[7] = std::max(yy, 0.0);
+  hypothesis.covariance[11] = hypothesis.covariance[31] = yt;
+  hypothesis.covariance[35] = std::max(tt, 0.0);
+  return hypothesis;
+}
+
+}  // namespace bitbots_localization
@@ -0,0 +1,48 @@
+#include <algorithm>
+#include <bitbots_localization/KLDSampling.hpp>
+#include <cmath>
+
+namespace bitbots_localization {
+
+KLDSampling::KLDSampling(double bin_size_x, double bin_size_y, double bin_size_theta, double epsilon,
+                         double z_quantile, size_t min_particles, size_t max_particles) {
+  set_parameters(bin_size_x, bin_size_y, bin_size_theta, epsilon, z_quantile, min_particles, max_particles);
+}
+
+void KLDSampling::set_parameters(double bin_size_x, double bin_size_y, double bin_size_theta, double epsilon,
+                                 double z_quantile, size_t min_particles, size_t max_particles) {
+  bin_size_x_ = bin_size_x;
+  bin_size_y_ = bin_size_y;
+  bin_size_theta_ = bin_size_theta;
+  epsilon_ = epsilon;
+  z_quantile_ = z_quantile;
+  min_particles_ = min_particles;
+  max_particles_ = std::max(min_particles, max_particles);
+}
+
+size_t KLDSampling::required_particles(const std::vector<particle_filter::Particle<RobotState> *> &particles) {
+  // Pack the bin indices of each particle into one key with 21 bits per dimension
+  auto bin_index = [](double value, double bin_size) {
+    return static_cast<uint64_t>(static_cast<int64_t>(std::floor(value / bin_size)) + (1 << 20)) & 0x1fffff;
+  };
+  bins_.clear();
+  for (const particle_filter::Particle<RobotState> *particle : particles) {
+    const RobotState &state = particle->getState();
+    bins_.push_back(bin_index(state.getXPos(), bin_size_x_) << 42 | bin_index(state.getYPos(), bin_size_y_) << 21 |
+                    bin_index(state.getTheta(), bin_size_theta_));
+  }
+  std::sort(bins_.begin(), bins_.end());
+  size_t occupied_bins = std::unique(bins_.begin(), bins_.end()) - bins_.begin();
+
+  if (occupied_bins <= 1) {
+    return min_particles_;
+  }
+
+  // Wilson-Hilferty approximation of the chi-square quantile with k - 1 degrees of freedom
+  double k = occupied_bins - 1;
+  double a = 2.0 / (9.0 * k);
+  double required = k / (2.0 * epsilon_) * std::pow(1.0 - a + std::sqrt(a) * z_quantile_, 3);
+  return std::clamp(static_cast<size_t>(std::ceil(required)), min_particles_, max_particles_);
+}
+
+}  // namespace bitbots_localization
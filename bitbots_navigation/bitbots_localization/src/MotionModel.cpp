@@ -6,6 +6,14 @@
 
 namespace bitbots_localization {
 
+// Draws from a zero mean gaussian with the standard deviation b
+static double sample_gaussian(double b, std::mt19937 &generator) {
+  if (b <= 0) {
+    return 0;
+  }
+  return std::normal_distribution<double>(0, b)(generator);
+}
+
 RobotMotionModel::RobotMotionModel(const particle_filter::CRandomNumberGenerator &random_number_generator,
                                    double diffuse_xStdDev, double diffuse_yStdDev, double diffuse_tStdDev,
                                    double diffuse_multiplier, Eigen::Matrix<double, 3, 2> drift_cov)
@@ -19,6 +27,27 @@ RobotMotionModel::RobotMotionModel(const particle_filter::CRandomNumberGenerator
 
 void RobotMotionModel::drift(RobotState &state, geometry_msgs::msg::Vector3 linear_movement,
                              geometry_msgs::msg::Vector3 rotational_movement) const {
+  drift_with_sampler(state, linear_movement, rotational_movement, [this](double b) { return sample(b); });
+}
+
+void RobotMotionModel::drift(RobotState &state, geometry_msgs::msg::Vector3 linear_movement,
+                             geometry_msgs::msg::Vector3 rotational_movement, std::mt19937 &generator) const {
+  drift_with_sampler(state, linear_movement, rotational_movement,
+                     [&generator](double b) { return sample_gaussian(b, generator); });
+}
+
+void RobotMotionModel::diffuse(RobotState &state) const {
+  diffuse_with_sampler(state, [this](double b) { return sample(b); });
+}
+
+void RobotMotionModel::diffuse(RobotState &state, std::mt19937 &generator) const {
+  diffuse_with_sampler(state, [&generator](double b) { return sample_gaussian(b, generator); });
+}
+
+template <class Sampler>
+void RobotMotionModel::drift_with_sampler(RobotState &state, geometry_msgs::msg::Vector3 linear_movement,
+                                          geometry_msgs::msg::Vector3 rotational_movement,
+                                          const Sampler &sample) const {
   // Convert cartesian coordinates to polarcoordinates with an orientation
   auto [polar_rot, polar_dist] = cartesianToPolar(linear_movement.x, linear_movement.y);
   // get the minimal absolute
@@ -44,7 +73,8 @@ void RobotMotionModel::drift(RobotState &state, geometry_msgs::msg::Vector3 line
   state.setTheta(theta);
 }
 
-void RobotMotionModel::diffuse(RobotState &state) const {
+template <class Sampler>
+void RobotMotionModel::diffuse_with_sampler(RobotState &state, const Sampler &sample) const {
   state.setXPos(state.getXPos() + sample(diffuse_xStdDev_) * diffuse_multiplier_);
   state.setYPos(state.getYPos() + sample(diffuse_yStdDev_) * diffuse_multiplier_);
   double theta = state.getTheta() + sample(diffuse_tStdDev_) * diffuse_multiplier_;
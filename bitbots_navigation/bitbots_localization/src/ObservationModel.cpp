@@ -2,6 +2,7 @@
 // Created by judith on 09.03.19.
 //
 
+#include <algorithm>
 #include <bitbots_localization/ObservationModel.hpp>
 
 namespace bitbots_localization {
@@ -19,21 +20,48 @@ RobotPoseObservationModel::RobotPoseObservationModel(std::shared_ptr<Map> map_li
   particle_filter::ObservationModel<RobotState>::accumulate_weights_ = true;
 }
 
-double RobotPoseObservationModel::calculate_weight_for_class(
-    const RobotState &state, const std::vector<std::pair<double, double>> &last_measurement, std::shared_ptr<Map> map,
-    double element_weight) const {
+double RobotPoseObservationModel::calculate_weight_for_class(const RobotState &state,
+                                                             const MeasurementPoints &last_measurement,
+                                                             const std::shared_ptr<Map> &map,
+                                                             double element_weight) const {
   double particle_weight_for_class;
   if (!last_measurement.empty()) {
-    std::vector<double> ratings = map->Map::provideRating(state, last_measurement);
-    // Take the average of the ratings (functional)
-    particle_weight_for_class = std::pow(std::accumulate(ratings.begin(), ratings.end(), 0.0) / ratings.size(), 2);
+    // Take the average of the ratings
+    double rating_sum = map->rateMeasurements(state, last_measurement, config_.particle_filter.map.rating_level);
+    particle_weight_for_class = std::pow(rating_sum / last_measurement.size(), 2);
   } else {
     particle_weight_for_class = 0;
   }
   return particle_weight_for_class;
 }
 
-double RobotPoseObservationModel::measure(const RobotState &state) const {
+double RobotPoseObservationModel::measure(const RobotState &state) const { return calculate_weight(state); }
+
+void RobotPoseObservationModel::weigh_particles(const std::vector<particle_filter::Particle<RobotState> *> &particles,
+                                                ParticleWorkers &workers) {
+  workers.for_each_chunk(particles.size(), [this, &particles](std::mt19937 &, size_t begin, size_t end) {
+    for (size_t i = begin; i < end; i++) {
+      double weight = calculate_weight(particles[i]->getState());
+      if (accumulate_weights_) {
+        weight += particles[i]->getWeight();
+      }
+      particles[i]->setWeight(weight);
+    }
+  });
+
+  // Normalize the weights after all particles are rated
+  double weight_sum = 0;
+  for (const particle_filter::Particle<RobotState> *particle : particles) {
+    weight_sum += particle->getWeight();
+  }
+  if (weight_sum > 0) {
+    for (particle_filter::Particle<RobotState> *particle : particles) {
+      particle->setWeight(particle->getWeight() / weight_sum);
+    }
+  }
+}
+
+double RobotPoseObservationModel::calculate_weight(const RobotState &state) const {
   double particle_weight_lines = calculate_weight_for_class(state, last_measurement_lines_, map_lines_,
                                                             config_.particle_filter.confidences.line_element);
   double particle_weight_goal = calculate_weight_for_class(state, last_measurement_goal_, map_goals_,
@@ -67,39 +95,82 @@ double RobotPoseObservationModel::measure(const RobotState &state) const {
   return weight;  // exponential?
 }
 
-void RobotPoseObservationModel::set_measurement_lines_pc(sm::msg::PointCloud2 measurement) {
+void RobotPoseObservationModel::set_measurement_lines_pc(const sm::msg::PointCloud2 &measurement) {
+  last_measurement_lines_.reserve(measurement.width * measurement.height);
   for (sm::PointCloud2ConstIterator<float> iter_xyz(measurement, "x"); iter_xyz != iter_xyz.end(); ++iter_xyz) {
-    std::pair<double, double> linePolar = cartesianToPolar(iter_xyz[0], iter_xyz[1]);
-    last_measurement_lines_.push_back(linePolar);
+    last_measurement_lines_.add(iter_xyz[0], iter_xyz[1]);
+  }
+  downsample(last_measurement_lines_, config_.particle_filter.scoring.lines.voxel_size);
+}
+
+void RobotPoseObservationModel::set_measurement_goalposts(const sv3dm::msg::GoalpostArray &measurement) {
+  last_measurement_goal_.reserve(measurement.posts.size());
+  for (const sv3dm::msg::Goalpost &post : measurement.posts) {
+    last_measurement_goal_.add(post.bb.center.position.x, post.bb.center.position.y);
   }
+  downsample(last_measurement_goal_, config_.particle_filter.scoring.goal.voxel_size);
 }
 
-void RobotPoseObservationModel::set_measurement_goalposts(sv3dm::msg::GoalpostArray measurement) {
-  // convert to polar
-  for (sv3dm::msg::Goalpost &post : measurement.posts) {
-    std::pair<double, double> postPolar = cartesianToPolar(post.bb.center.position.x, post.bb.center.position.y);
-    last_measurement_goal_.push_back(postPolar);
+void RobotPoseObservationModel::set_measurement_field_boundary(const sv3dm::msg::FieldBoundary &measurement) {
+  last_measurement_field_boundary_.reserve(measurement.points.size());
+  for (const gm::msg::Point &point : measurement.points) {
+    last_measurement_field_boundary_.add(point.x, point.y);
+  }
+  downsample(last_measurement_field_boundary_, config_.particle_filter.scoring.field_boundary.voxel_size);
+}
+
+void RobotPoseObservationModel::downsample(MeasurementPoints &measurement, double voxel_size) {
+  if (voxel_size <= 0 || measurement.empty()) {
+    return;
+  }
+
+  // Sort the points by their voxel, the voxel indices are packed into one key with 32 bits per dimension
+  voxel_keys_.clear();
+  for (size_t i = 0; i < measurement.size(); i++) {
+    auto index_x = static_cast<uint32_t>(static_cast<int32_t>(std::floor(measurement.x[i] / voxel_size)));
+    auto index_y = static_cast<uint32_t>(static_cast<int32_t>(std::floor(measurement.y[i] / voxel_size)));
+    voxel_keys_.emplace_back(static_cast<uint64_t>(index_x) << 32 | index_y, i);
+  }
+  std::sort(voxel_keys_.begin(), voxel_keys_.end());
+
+  // Replace the points of each voxel by their centroid
+  downsampled_.clear();
+  size_t begin = 0;
+  while (begin < voxel_keys_.size()) {
+    size_t end = begin;
+    double sum_x = 0;
+    double sum_y = 0;
+    while (end < voxel_keys_.size() && voxel_keys_[end].first == voxel_keys_[begin].first) {
+      sum_x += measurement.x[voxel_keys_[end].second];
+      sum_y += measurement.y[voxel_keys_[end].second];
+      end++;
+    }
+    downsampled_.add(sum_x / (end - begin), sum_y / (end - begin));
+    begin = end;
   }
+  std::swap(measurement, downsampled_);
 }
 
-void RobotPoseObservationModel::set_measurement_field_boundary(sv3dm::msg::FieldBoundary measurement) {
-  // convert to polar
-  for (gm::msg::Point &point : measurement.points) {
-    std::pair<double, double> fieldBoundaryPointPolar = cartesianToPolar(point.x, point.y);
-    last_measurement_field_boundary_.push_back(fieldBoundaryPointPolar);
+// Converts measurements to polar coordinates, which are used for the debug visualization
+static std::vector<std::pair<double, double>> to_polar(const MeasurementPoints &measurement) {
+  std::vector<std::pair<double, double>> polar;
+  polar.reserve(measurement.size());
+  for (size_t i = 0; i < measurement.size(); i++) {
+    polar.push_back(cartesianToPolar(measurement.x[i], measurement.y[i]));
   }
+  return polar;
 }
 
 std::vector<std::pair<double, double>> RobotPoseObservationModel::get_measurement_lines() const {
-  return last_measurement_lines_;
+  return to_polar(last_measurement_lines_);
 }
 
 std::vector<std::pair<double, double>> RobotPoseObservationModel::get_measurement_goals() const {
-  return last_measurement_goal_;
+  return to_polar(last_measurement_goal_);
 }
 
 std::vector<std::pair<double, double>> RobotPoseObservationModel::get_measurement_field_boundary() const {
-  return last_measurement_field_boundary_;
+  return to_polar(last_measurement_field_boundary_);
 }
 
 double RobotPoseObservationModel::get_min_weight() const { return config_.particle_filter.weighting.min_weight; }
@@ -0,0 +1,87 @@
+#include <algorithm>
+#include <bitbots_localization/OdometryBuffer.hpp>
+#include <cmath>
+
+namespace bitbots_localization {
+
+OdometryBuffer::OdometryBuffer(size_t capacity, double history_duration)
+    : history_duration_(static_cast<int64_t>(history_duration * 1e9)) {
+  size_t size = 1;
+  while (size < capacity) {
+    size <<= 1;
+  }
+  ring_.resize(size);
+  mask_ = size - 1;
+  history_.reserve(size);
+}
+
+bool OdometryBuffer::push(const OdometryPose &pose) {
+  size_t head = head_.load(std::memory_order_relaxed);
+  if (head - tail_.load(std::memory_order_acquire) == ring_.size()) {
+    return false;
+  }
+  ring_[head & mask_] = pose;
+  head_.store(head + 1, std::memory_order_release);
+  return true;
+}
+
+void OdometryBuffer::drain() {
+  size_t tail = tail_.load(std::memory_order_relaxed);
+  size_t head = head_.load(std::memory_order_acquire);
+  for (; tail != head; tail++) {
+    const OdometryPose &pose = ring_[tail & mask_];
+    // Ignore poses that are out of order
+    if (history_.empty() || pose.stamp > history_.back().stamp) {
+      history_.push_back(pose);
+    }
+  }
+  tail_.store(tail, std::memory_order_release);
+
+  // Remove the poses that are older than the history duration, but keep the newest one
+  if (!history_.empty()) {
+    int64_t oldest = history_.back().stamp - history_duration_;
+    auto first_kept = std::lower_bound(history_.begin(), history_.end() - 1, oldest,
+                                       [](const OdometryPose &pose, int64_t stamp) { return pose.stamp < stamp; });
+    history_.erase(history_.begin(), first_kept);
+  }
+}
+
+std::optional<OdometryPose> OdometryBuffer::pose_at(int64_t stamp) {
+  drain();
+  if (history_.empty()) {
+    return std::nullopt;
+  }
+  if (stamp >= history_.back().stamp) {
+    return history_.back();
+  }
+  if (stamp <= history_.front().stamp) {
+    return history_.front();
+  }
+
+  // Interpolate between the poses before and after the time stamp
+  auto after = std::lower_bound(history_.begin(), history_.end(), stamp,
+                                [](const OdometryPose &pose, int64_t stamp) { return pose.stamp < stamp; });
+  const OdometryPose &before = *(after - 1);
+  double ratio = static_cast<double>(stamp - before.stamp) / static_cast<double>(after->stamp - before.stamp);
+  OdometryPose pose;
+  pose.stamp = stamp;
+  pose.x = before.x + ratio * (after->x - before.x);
+  pose.y = before.y + ratio * (after->y - before.y);
+  pose.theta = before.theta + ratio * std::remainder(after->theta - before.theta, 2 * M_PI);
+  return pose;
+}
+
+std::optional<OdometryPose> OdometryBuffer::latest() {
+  drain();
+  if (history_.empty()) {
+    return std::nullopt;
+  }
+  return history_.back();
+}
+
+void OdometryBuffer::clear() {
+  drain();
+  history_.clear();
+}
+
+}  // namespace bitbots_localization
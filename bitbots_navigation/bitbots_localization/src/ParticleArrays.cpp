@@ -0,0 +1,126 @@
+#include <algorithm>
+#include <bitbots_localization/ParticleArrays.hpp>
+#include <cmath>
+#include <numeric>
+
+namespace bitbots_localization {
+
+void ParticleArrays::gather(const std::vector<particle_filter::Particle<RobotState> *> &particles) {
+  size_t count = particles.size();
+  x.resize(count);
+  y.resize(count);
+  sin_theta.resize(count);
+  cos_theta.resize(count);
+  weight.resize(count);
+  explorer.resize(count);
+  for (size_t i = 0; i < count; i++) {
+    const RobotState &particle_state = particles[i]->getState();
+    x[i] = particle_state.getXPos();
+    y[i] = particle_state.getYPos();
+    sin_theta[i] = particle_state.getSinTheta();
+    cos_theta[i] = particle_state.getCosTheta();
+    weight[i] = particles[i]->getWeight();
+    explorer[i] = particles[i]->is_explorer_;
+  }
+}
+
+void ParticleArrays::computeCumulativeWeights() {
+  cumulative_weight.resize(weight.size());
+  std::partial_sum(weight.begin(), weight.end(), cumulative_weight.begin());
+}
+
+void ParticleArrays::systematicResample(double start, size_t count, std::vector<uint32_t> &indices) const {
+  indices.resize(count);
+  if (cumulative_weight.empty() || count == 0) {
+    return;
+  }
+  // The sample positions are equally spaced over the total weight, so a single merge pass over the prefix sum
+  // finds the particle of each sample
+  double step = cumulative_weight.back() / count;
+  uint32_t source = 0;
+  uint32_t last_source = cumulative_weight.size() - 1;
+  for (size_t sample = 0; sample < count; sample++) {
+    double position = (start + sample) * step;
+    while (source < last_source && cumulative_weight[source] < position) {
+      source++;
+    }
+    indices[sample] = source;
+  }
+}
+
+void ParticleArrays::estimate(int percentage, bool ignore_explorers, RobotState &mean,
+                              std::vector<double> &covariance) {
+  // Select the particles with the highest weights
+  selection_.clear();
+  for (uint32_t i = 0; i < size(); i++) {
+    if (!ignore_explorers || !explorer[i]) {
+      selection_.push_back(i);
+    }
+  }
+  size_t selected = std::max<size_t>(1, selection_.size() * std::clamp(percentage, 0, 100) / 100);
+  if (selected < selection_.size()) {
+    std::nth_element(selection_.begin(), selection_.begin() + selected, selection_.end(),
+                     [this](uint32_t a, uint32_t b) { return weight[a] > weight[b]; });
+    selection_.resize(selected);
+  }
+
+  covariance.assign(36, 0.0);
+  if (selection_.empty()) {
+    mean = RobotState();
+    return;
+  }
+
+  // Weighted mean, the orientation is averaged on the unit circle
+  double weight_sum = 0, mean_x = 0, mean_y = 0, mean_sin = 0, mean_cos = 0;
+  for (uint32_t i : selection_) {
+    weight_sum += weight[i];
+    mean_x += weight[i] * x[i];
+    mean_y += weight[i] * y[i];
+    mean_sin += weight[i] * sin_theta[i];
+    mean_cos += weight[i] * cos_theta[i];
+  }
+  if (weight_sum <= 0) {
+    weight_sum = 1;
+  }
+  mean_x /= weight_sum;
+  mean_y /= weight_sum;
+  double norm = std::hypot(mean_sin, mean_cos);
+  mean_sin = norm > 0 ? mean_sin / norm : 0;
+  mean_cos = norm > 0 ? mean_cos / norm : 1;
+
+  // Weighted covariance, the angular deviation is the sine of the difference to the mean orientation
+  double xx = 0, xy = 0, yy = 0, xt = 0, yt = 0, tt = 0;
+  for (uint32_t i : selection_) {
+    double dx = x[i] - mean_x;
+    double dy = y[i] - mean_y;
+    double dt = sin_theta[i] * mean_cos - cos_theta[i] * mean_sin;
+    xx += weight[i] * dx * dx;
+    xy += weight[i] * dx * dy;
+    yy += weight[i] * dy * dy;
+    xt += weight[i] * dx * dt;
+    yt += weight[i] * dy * dt;
+    tt += weight[i] * dt * dt;
+  }
+  covariance[0] = xx / weight_sum;
+  covariance[1] = covariance[6] = xy / weight_sum;
+  covariance[5] = covariance[30] = xt / weight_sum;
+  covariance[7] = yy / weight_sum;
+  covariance[11] = covariance[31] = yt / weight_sum;
+  covariance[35] = tt / weight_sum;
+
+  mean = RobotState(mean_x, mean_y, 0);
+  mean.setSinTheta(mean_sin);
+  mean.setCosTheta(mean_cos);
+}
+
+RobotState ParticleArrays::state(size_t index) const {
+  RobotState particle_state(x[index], y[index], 0);
+  particle_state.setSinTheta(sin_theta[index]);
+  particle_state.setCosTheta(cos_theta[index]);
+  particle_state.is_explorer_ = explorer[index];
+  return particle_state;
+}
+
+size_t ParticleArrays::size() const { return x.size(); }
+
+}  // namespace bitbots_localization
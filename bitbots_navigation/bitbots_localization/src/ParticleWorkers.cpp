@@ -0,0 +1,87 @@
+#include <algorithm>
+#include <bitbots_localization/ParticleWorkers.hpp>
+
+namespace bitbots_localization {
+
+ParticleWorkers::ParticleWorkers(size_t thread_count, unsigned int seed) {
+  for (size_t i = 0; i < std::max<size_t>(thread_count, 1); i++) {
+    std::seed_seq seed_sequence{seed, static_cast<unsigned int>(i)};
+    generators_.emplace_back(seed_sequence);
+  }
+  // The first chunk is always processed by the calling thread
+  for (size_t chunk = 1; chunk < generators_.size(); chunk++) {
+    threads_.emplace_back(&ParticleWorkers::loop, this, chunk);
+  }
+}
+
+ParticleWorkers::~ParticleWorkers() {
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    stop_ = true;
+  }
+  task_condition_.notify_all();
+  for (std::thread &thread : threads_) {
+    thread.join();
+  }
+}
+
+void ParticleWorkers::for_each_chunk(size_t count, const ChunkFunction &function) {
+  size_t chunks = std::min(generators_.size(), count);
+  if (chunks <= 1) {
+    function(generators_[0], 0, count);
+    return;
+  }
+
+  // Wake the workers for all chunks except the first one, which is done by the calling thread
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    function_ = &function;
+    count_ = count;
+    chunks_ = chunks;
+    pending_ = threads_.size();
+    generation_++;
+  }
+  task_condition_.notify_all();
+  function(generators_[0], 0, count / chunks);
+
+  std::unique_lock<std::mutex> lock(mutex_);
+  done_condition_.wait(lock, [this] { return pending_ == 0; });
+  function_ = nullptr;
+}
+
+void ParticleWorkers::loop(size_t chunk) {
+  uint64_t generation = 0;
+  while (true) {
+    const ChunkFunction *function;
+    size_t count, chunks;
+    {
+      std::unique_lock<std::mutex> lock(mutex_);
+      task_condition_.wait(lock, [this, generation] { return generation_ != generation || stop_; });
+      if (stop_) {
+        return;
+      }
+      generation = generation_;
+      function = function_;
+      count = count_;
+      chunks = chunks_;
+    }
+
+    // There are less chunks than workers if there are only a few elements
+    if (chunk < chunks) {
+      (*function)(generators_[chunk], chunk * count / chunks, (chunk + 1) * count / chunks);
+    }
+
+    bool done;
+    {
+      std::lock_guard<std::mutex> lock(mutex_);
+      done = --pending_ == 0;
+    }
+    if (done) {
+      done_condition_.notify_one();
+    }
+  }
+}
+
+size_t ParticleWorkers::thread_count() const { return generators_.size(); }
+
+}  // namespace bitbots_localization
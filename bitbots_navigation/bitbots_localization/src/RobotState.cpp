@@ -50,7 +50,7 @@ void RobotState::setTheta(double t) {
 
 void RobotState::setSinTheta(double st) { m_SinTheta = st; }
 
-void RobotState::setCosTheta(double ct) { m_SinTheta = ct; }
+void RobotState::setCosTheta(double ct) { m_CosTheta = ct; }
 
 double RobotState::calcDistance(const RobotState &state) const {
   double diff = std::sqrt(std::pow(getXPos() - state.getXPos(), 2) + std::pow(getYPos() - state.getYPos(), 2));
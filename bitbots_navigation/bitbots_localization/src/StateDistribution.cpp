@@ -73,6 +73,21 @@ const RobotState RobotStateDistributionOwnHalf::draw() const {
                      random_number_generator_.getUniform(-M_PI, M_PI)));
 }
 
+RobotStateDistributionField::RobotStateDistributionField(
+    particle_filter::CRandomNumberGenerator &random_number_generator, std::pair<double, double> field_size)
+    : random_number_generator_(random_number_generator) {
+  min_x_ = -field_size.first / 2.0;
+  min_y_ = -field_size.second / 2.0;
+  max_x_ = field_size.first / 2.0;
+  max_y_ = field_size.second / 2.0;
+}
+
+const RobotState RobotStateDistributionField::draw() const {
+  return (RobotState(random_number_generator_.getUniform(min_x_, max_x_),
+                     random_number_generator_.getUniform(min_y_, max_y_),
+                     random_number_generator_.getUniform(-M_PI, M_PI)));
+}
+
 RobotStateDistributionPosition::RobotStateDistributionPosition(
     particle_filter::CRandomNumberGenerator &random_number_generator, double x, double y) {
   x_ = x;
@@ -12,45 +12,29 @@ Localization::Localization(std::shared_ptr<rclcpp::Node> node)
       tfBuffer(std::make_unique<tf2_ros::Buffer>(node->get_clock())),
       tfListener(std::make_shared<tf2_ros::TransformListener>(*tfBuffer, node)),
       br(std::make_shared<tf2_ros::TransformBroadcaster>(node)) {
-  // Wait for transforms to become available and init them
-  bitbots_utils::wait_for_tf(node->get_logger(), node->get_clock(), tfBuffer.get(), {config_.ros.base_footprint_frame},
-                             config_.ros.odom_frame);
+  // Init subscribers
+  odometry_subscriber_ = node->create_subscription<nav_msgs::msg::Odometry>(
+      config_.ros.odometry_topic, 10, std::bind(&Localization::OdometryCallback, this, _1));
 
-  // Get the initial transform from odom to base_footprint
-  previousOdomTransform_ = tfBuffer->lookupTransform(config_.ros.odom_frame, config_.ros.base_footprint_frame,
-                                                     rclcpp::Time(0), rclcpp::Duration::from_nanoseconds(1e9 * 20.0));
+  // Intra process communication allows zero-copy delivery of the measurements if vision runs in the same process.
+  // It is only enabled for the measurements, as it does not support the transient local map publisher.
+  rclcpp::SubscriptionOptions measurement_options;
+  measurement_options.use_intra_process_comm = rclcpp::IntraProcessSetting::Enable;
 
-  // Init subscribers
   line_point_cloud_subscriber_ = node->create_subscription<sm::msg::PointCloud2>(
-      config_.ros.line_pointcloud_topic, 1, std::bind(&Localization::LinePointcloudCallback, this, _1));
+      config_.ros.line_pointcloud_topic, 1, std::bind(&Localization::LinePointcloudCallback, this, _1),
+      measurement_options);
 
   goal_subscriber_ = node->create_subscription<sv3dm::msg::GoalpostArray>(
-      config_.ros.goal_topic, 1, std::bind(&Localization::GoalPostsCallback, this, _1));
+      config_.ros.goal_topic, 1, std::bind(&Localization::GoalPostsCallback, this, _1), measurement_options);
 
   fieldboundary_subscriber_ = node->create_subscription<sv3dm::msg::FieldBoundary>(
-      config_.ros.fieldboundary_topic, 1, std::bind(&Localization::FieldboundaryCallback, this, _1));
+      config_.ros.fieldboundary_topic, 1, std::bind(&Localization::FieldboundaryCallback, this, _1),
+      measurement_options);
 
   rviz_initial_pose_subscriber_ = node->create_subscription<gm::msg::PoseWithCovarianceStamped>(
       "initialpose", 1, std::bind(&Localization::SetInitialPositionCallback, this, _1));
 
-  // Init publishers
-  pose_particles_publisher_ =
-      node->create_publisher<visualization_msgs::msg::MarkerArray>(config_.ros.particle_publishing_topic, 1);
-  pose_with_covariance_publisher_ =
-      node->create_publisher<gm::msg::PoseWithCovarianceStamped>("pose_with_covariance", 1);
-  lines_publisher_ = node->create_publisher<visualization_msgs::msg::Marker>("lines", 1);
-  line_ratings_publisher_ = node->create_publisher<visualization_msgs::msg::Marker>("line_ratings", 1);
-  goal_ratings_publisher_ = node->create_publisher<visualization_msgs::msg::Marker>("goal_ratings", 1);
-  fieldboundary_ratings_publisher_ =
-      node->create_publisher<visualization_msgs::msg::Marker>("field_boundary_ratings", 1);
-  field_publisher_ = node->create_publisher<nav_msgs::msg::OccupancyGrid>(
-      "field/map", rclcpp::QoS(rclcpp::KeepLast(1)).transient_local());
-
-  // Set the measurement timestamps to 0
-  line_pointcloud_relative_.header.stamp = rclcpp::Time(0);
-  goal_posts_relative_.header.stamp = rclcpp::Time(0);
-  fieldboundary_relative_.header.stamp = rclcpp::Time(0);
-
   // Get the static global configuration from the blackboard
   auto global_params = bitbots_utils::get_parameters_from_other_node(
       node_, "/parameter_blackboard", {"field.size.x", "field.size.y", "field.size.padding", "field.name"}, 1s);
@@ -59,13 +43,8 @@ Localization::Localization(std::shared_ptr<rclcpp::Node> node)
   field_dimensions_.y = global_params["field.size.y"].as_double();
   field_dimensions_.padding = global_params["field.size.padding"].as_double();
 
-  // Update all things that are dependent on the parameters and
-  // might need to be updated during runtime later if a parameter is changed
-  updateParams(true);
-
-  // Init the particles with the given distribution
-  RCLCPP_INFO(node->get_logger(), "Trying to initialize particle filter...");
-  reset_filter(config_.misc.init_mode);
+  // Create the publishers and the filter
+  init_filter();
 
   // Init services that can be called from outside
   reset_service_ = node->create_service<bl::srv::ResetFilter>(
@@ -79,6 +58,44 @@ Localization::Localization(std::shared_ptr<rclcpp::Node> node)
                                            std::bind(&Localization::run_filter_one_step, this));
 }
 
+Localization::Localization(std::shared_ptr<rclcpp::Node> node, const std::string &field_name,
+                           const FieldDimensions &field_dimensions)
+    : node_(node),
+      param_listener_(node->get_node_parameters_interface()),
+      config_(param_listener_.get_params()),
+      field_dimensions_(field_dimensions),
+      field_name_(field_name),
+      tfBuffer(std::make_unique<tf2_ros::Buffer>(node->get_clock())),
+      br(std::make_shared<tf2_ros::TransformBroadcaster>(node)) {
+  // The inputs are fed by the caller, so there are no subscribers, services or timers
+  init_filter();
+}
+
+void Localization::init_filter() {
+  // Init publishers
+  pose_particles_publisher_ =
+      node_->create_publisher<visualization_msgs::msg::MarkerArray>(config_.ros.particle_publishing_topic, 1);
+  pose_with_covariance_publisher_ =
+      node_->create_publisher<gm::msg::PoseWithCovarianceStamped>("pose_with_covariance", 1);
+  pose_hypotheses_publisher_ =
+      node_->create_publisher<bitbots_msgs::msg::PoseWithCertaintyArray>("pose_hypotheses", 1);
+  lines_publisher_ = node_->create_publisher<visualization_msgs::msg::Marker>("lines", 1);
+  line_ratings_publisher_ = node_->create_publisher<visualization_msgs::msg::Marker>("line_ratings", 1);
+  goal_ratings_publisher_ = node_->create_publisher<visualization_msgs::msg::Marker>("goal_ratings", 1);
+  fieldboundary_ratings_publisher_ =
+      node_->create_publisher<visualization_msgs::msg::Marker>("field_boundary_ratings", 1);
+  field_publisher_ = node_->create_publisher<nav_msgs::msg::OccupancyGrid>(
+      "field/map", rclcpp::QoS(rclcpp::KeepLast(1)).transient_local());
+
+  // Update all things that are dependent on the parameters and
+  // might need to be updated during runtime later if a parameter is changed
+  updateParams(true);
+
+  // Init the particles with the given distribution
+  RCLCPP_INFO(node_->get_logger(), "Trying to initialize particle filter...");
+  reset_filter(config_.misc.init_mode);
+}
+
 void Localization::updateParams(bool force_reload) {
   // Check if we don't need to update the parameters
   if (!force_reload and !param_listener_.is_old(config_)) {
@@ -91,18 +108,29 @@ void Localization::updateParams(bool force_reload) {
   param_listener_.refresh_dynamic_parameters();
   config_ = param_listener_.get_params();
 
-  // Check if measurement type is used and load the correct map for that
-  if (config_.particle_filter.scoring.lines.factor) {
-    lines_.reset(new Map(field_name_, "lines.png", config_.particle_filter.scoring.lines.out_of_field_score));
+  // Check if measurement type is used and load the correct map for that.
+  // Maps are only recreated if they are missing or their out of field score changed.
+  auto map_config = config_.particle_filter.map;
+  auto needs_map = [](const std::shared_ptr<Map> &map, double out_of_field_score) {
+    return !map || map->get_out_of_map_value() != out_of_field_score;
+  };
+  if (config_.particle_filter.scoring.lines.factor &&
+      needs_map(lines_, config_.particle_filter.scoring.lines.out_of_field_score)) {
+    lines_.reset(new Map(field_name_, "lines.png", config_.particle_filter.scoring.lines.out_of_field_score,
+                         map_config.pyramid_levels, map_config.use_cache));
     // Publish the line map once
     field_publisher_->publish(lines_->get_map_msg(config_.ros.map_frame));
   }
-  if (config_.particle_filter.scoring.goal.factor) {
-    goals_.reset(new Map(field_name_, "goals.png", config_.particle_filter.scoring.goal.out_of_field_score));
+  if (config_.particle_filter.scoring.goal.factor &&
+      needs_map(goals_, config_.particle_filter.scoring.goal.out_of_field_score)) {
+    goals_.reset(new Map(field_name_, "goals.png", config_.particle_filter.scoring.goal.out_of_field_score,
+                         map_config.pyramid_levels, map_config.use_cache));
   }
-  if (config_.particle_filter.scoring.field_boundary.factor) {
-    field_boundary_.reset(
-        new Map(field_name_, "field_boundary.png", config_.particle_filter.scoring.field_boundary.out_of_field_score));
+  if (config_.particle_filter.scoring.field_boundary.factor &&
+      needs_map(field_boundary_, config_.particle_filter.scoring.field_boundary.out_of_field_score)) {
+    field_boundary_.reset(new Map(field_name_, "field_boundary.png",
+                                  config_.particle_filter.scoring.field_boundary.out_of_field_score,
+                                  map_config.pyramid_levels, map_config.use_cache));
   }
 
   // Init observation model
@@ -139,16 +167,44 @@ void Localization::updateParams(bool force_reload) {
       random_number_generator_, std::make_pair(field_dimensions_.x, field_dimensions_.y)));
   robot_state_distribution_own_half_.reset(new RobotStateDistributionOwnHalf(
       random_number_generator_, std::make_pair(field_dimensions_.x, field_dimensions_.y)));
+  robot_state_distribution_field_.reset(new RobotStateDistributionField(
+      random_number_generator_, std::make_pair(field_dimensions_.x, field_dimensions_.y)));
+
+  // Create the resampling strategy, which draws the explorer particles on the whole field
+  resampling_.reset(new ImportanceResamplingWE<RobotState>(config_.particle_filter.explorer_count,
+                                                           robot_state_distribution_field_, true,
+                                                           config_.particle_filter.weighting.particle_reset_weight));
+
+  // Create the workers for the parallel filter steps, the thread count can not change at runtime
+  if (!particle_workers_) {
+    particle_workers_ = std::make_unique<ParticleWorkers>(config_.particle_filter.threads,
+                                                          static_cast<unsigned int>(config_.particle_filter.seed));
+  }
+
+  // Create the adaptive particle count calculation or update its parameters, which keeps its buffer
+  auto kld_config = config_.particle_filter.kld;
+  if (!kld_sampling_) {
+    kld_sampling_ = std::make_unique<KLDSampling>(kld_config.bin_size.x, kld_config.bin_size.y,
+                                                  kld_config.bin_size.theta, kld_config.epsilon, kld_config.z_quantile,
+                                                  kld_config.min_particles, kld_config.max_particles);
+  } else {
+    kld_sampling_->set_parameters(kld_config.bin_size.x, kld_config.bin_size.y, kld_config.bin_size.theta,
+                                  kld_config.epsilon, kld_config.z_quantile, kld_config.min_particles,
+                                  kld_config.max_particles);
+  }
 
-  // Create the resampling strategy
-  resampling_.reset(
-      new pf::ImportanceResampling<RobotState>(true, config_.particle_filter.weighting.particle_reset_weight));
+  // Create the clustering of the particles into pose hypotheses
+  auto hypotheses_config = config_.misc.hypotheses;
+  hypothesis_clustering_ = std::make_unique<HypothesisClustering>(
+      hypotheses_config.bin_size.x, hypotheses_config.bin_size.y, hypotheses_config.bin_size.theta,
+      hypotheses_config.max_count);
 
   // Check if we need to create a new particle filter or if we can update the existing one (keeping the particle states)
   if (!robot_pf_) {
     // Create new particle filter
     robot_pf_.reset(new particle_filter::ParticleFilter<RobotState>(
         config_.particle_filter.particle_number, robot_pose_observation_model_, robot_motion_model_));
+    robot_pf_->setResamplingStrategy(resampling_);
   } else {
     // Update particle filter's components
     robot_pf_->setResamplingStrategy(resampling_);
@@ -163,11 +219,45 @@ void Localization::run_filter_one_step() {
   // Check for new parameters and recreate necessary components if needed
   updateParams();
 
+  // Measure the duration of each stage of the step
+  auto stage_start = std::chrono::steady_clock::now();
+  auto stage_duration = [&stage_start]() {
+    auto now = std::chrono::steady_clock::now();
+    double duration = std::chrono::duration<double>(now - stage_start).count();
+    stage_start = now;
+    return duration;
+  };
+
   // Set the measurements in the observation model
   updateMeasurements();
+  step_timings_.measurements = stage_duration();
 
-  // Get the odometry offset since the last cycle
-  getMotion();
+  // Get the odometry pose now and at the capture time of the measurements
+  std::optional<OdometryPose> odom_now = odometry_buffer_.latest();
+  OdometryPose odom_measurement;
+  if (odom_now) {
+    if (previous_odom_pose_ && previous_odom_pose_->stamp == odom_now->stamp) {
+      RCLCPP_WARN_THROTTLE(node_->get_logger(), *node_->get_clock(), 1000,
+                           "No new odometry since the last step! Odometry is unavailable.");
+    }
+    // The motion starts at the first odometry pose
+    if (!previous_odom_pose_) {
+      previous_odom_pose_ = odom_now;
+    }
+    // Measurements which were captured before the last step are matched to the odometry pose of the last step
+    odom_measurement = *odom_now;
+    if (measurement_stamp_) {
+      odom_measurement = *odometry_buffer_.pose_at(std::max(*measurement_stamp_, previous_odom_pose_->stamp));
+    }
+    // Get the odometry offset since the last step until the capture time of the measurements
+    getMotion(*previous_odom_pose_, odom_measurement);
+  } else {
+    RCLCPP_WARN_THROTTLE(node_->get_logger(), *node_->get_clock(), 1000,
+                         "No odometry received yet! Odometry is unavailable.");
+    linear_movement_ = geometry_msgs::msg::Vector3();
+    rotational_movement_ = geometry_msgs::msg::Vector3();
+    robot_moved = false;
+  }
 
   // Drops the diffusion noise back to normal if it was bumped by a reset/init.
   // Increasing the noise helps with the initial localization.
@@ -175,35 +265,133 @@ void Localization::run_filter_one_step() {
     robot_motion_model_->diffuse_multiplier_ = config_.particle_filter.diffusion.multiplier;
   }
 
-  if ((config_.misc.filter_only_with_motion and robot_moved) or (!config_.misc.filter_only_with_motion)) {
-    robot_pf_->drift(linear_movement_, rotational_movement_);
-    robot_pf_->diffuse();
+  bool apply_motion = (config_.misc.filter_only_with_motion and robot_moved) or (!config_.misc.filter_only_with_motion);
+  if (apply_motion) {
+    propagate_particles(true);
   }
+  step_timings_.motion = stage_duration();
 
   // Apply ratings corresponding to the observations compared with each particle position
-  robot_pf_->measure();
+  if (robot_pose_observation_model_->measurements_available()) {
+    std::vector<pf::Particle<RobotState> *> particles(robot_pf_->particleListBegin(), robot_pf_->particleListEnd());
+    robot_pose_observation_model_->weigh_particles(particles, *particle_workers_);
+  }
+  step_timings_.weighting = stage_duration();
 
   // Check if its resampling time!
   if (timer_callback_count_ % config_.particle_filter.resampling_interval == 0) {
     robot_pf_->resample();
+    if (config_.particle_filter.kld.enabled) {
+      adapt_particle_count();
+    }
+  }
+  step_timings_.resampling = stage_duration();
+
+  // Move the particles from the capture time of the measurements to the newest odometry pose
+  if (odom_now && odom_measurement.stamp < odom_now->stamp) {
+    getMotion(odom_measurement, *odom_now);
+    if (apply_motion) {
+      propagate_particles(false);
+    }
   }
+  if (odom_now) {
+    previous_odom_pose_ = odom_now;
+  }
+  step_timings_.motion += stage_duration();
+
+  // Calculate the estimate and the hypotheses, which are shared by all publishers
+  update_estimate();
+  step_timings_.estimate = stage_duration();
   // Publish transforms
   publish_transforms();
   // Publish covariance message
   publish_pose_with_covariance();
+  // Publish the particle clusters
+  publish_hypotheses();
   // Publish debug stuff
   if (config_.ros.debug_visualization) {
     publish_debug();
   }
+  step_timings_.publishing = stage_duration();
 
   robot_pose_observation_model_->clear_measurement();
 }
 
-void Localization::LinePointcloudCallback(const sm::msg::PointCloud2 &msg) { line_pointcloud_relative_ = msg; }
+void Localization::step() { run_filter_one_step(); }
+
+const RobotState &Localization::get_estimate() const { return estimate_; }
+
+const Localization::StepTimings &Localization::get_step_timings() const { return step_timings_; }
+
+size_t Localization::get_particle_count() const {
+  return std::distance(robot_pf_->particleListBegin(), robot_pf_->particleListEnd());
+}
+
+void Localization::propagate_particles(bool diffuse) {
+  std::vector<pf::Particle<RobotState> *> particles(robot_pf_->particleListBegin(), robot_pf_->particleListEnd());
+  particle_workers_->for_each_chunk(particles.size(), [&](std::mt19937 &generator, size_t begin, size_t end) {
+    for (size_t i = begin; i < end; i++) {
+      RobotState state = particles[i]->getState();
+      robot_motion_model_->drift(state, linear_movement_, rotational_movement_, generator);
+      if (diffuse) {
+        robot_motion_model_->diffuse(state, generator);
+      }
+      particles[i]->setState(state);
+    }
+  });
+}
+
+void Localization::adapt_particle_count() {
+  std::vector<pf::Particle<RobotState> *> particles(robot_pf_->particleListBegin(), robot_pf_->particleListEnd());
+  size_t current_count = particles.size();
+  size_t required_count = kld_sampling_->required_particles(particles);
+
+  // Only resize on significant changes, as the particle filter needs to be recreated for that
+  if (std::abs(static_cast<double>(required_count) - static_cast<double>(current_count)) <=
+      config_.particle_filter.kld.hysteresis * current_count) {
+    return;
+  }
+
+  // The particle filter library can not resize its particle lists, so the resampled particles are copied into a
+  // particle filter of the new size. Each particle is copied about the same number of times, keeping its weight and
+  // explorer flag. The particle arrays are gathered again for the estimate after this.
+  particle_arrays_.gather(particles);
+  robot_pf_.reset(new particle_filter::ParticleFilter<RobotState>(required_count, robot_pose_observation_model_,
+                                                                  robot_motion_model_));
+  robot_pf_->setResamplingStrategy(resampling_);
+  size_t index = 0;
+  for (auto particle = robot_pf_->particleListBegin(); particle != robot_pf_->particleListEnd(); ++particle) {
+    size_t source = index++ * current_count / required_count;
+    (*particle)->setState(particle_arrays_.state(source));
+    (*particle)->setWeight(particle_arrays_.weight[source]);
+    (*particle)->is_explorer_ = particle_arrays_.explorer[source];
+  }
+
+  RCLCPP_DEBUG(node_->get_logger(), "Resized particle filter from %zu to %zu particles", current_count,
+               required_count);
+}
+
+void Localization::OdometryCallback(nav_msgs::msg::Odometry::ConstSharedPtr msg) {
+  OdometryPose pose;
+  pose.stamp = rclcpp::Time(msg->header.stamp).nanoseconds();
+  pose.x = msg->pose.pose.position.x;
+  pose.y = msg->pose.pose.position.y;
+  pose.theta = tf2::getYaw(msg->pose.pose.orientation);
+  if (!odometry_buffer_.push(pose)) {
+    RCLCPP_WARN_THROTTLE(node_->get_logger(), *node_->get_clock(), 1000,
+                         "Odometry buffer is full, the filter does not keep up. Dropping odometry.");
+  }
+}
 
-void Localization::GoalPostsCallback(const sv3dm::msg::GoalpostArray &msg) { goal_posts_relative_ = msg; }
+void Localization::LinePointcloudCallback(sm::msg::PointCloud2::ConstSharedPtr msg) {
+  line_pointcloud_relative_ = msg;
+}
 
-void Localization::FieldboundaryCallback(const sv3dm::msg::FieldBoundary &msg) { fieldboundary_relative_ = msg; }
+void Localization::GoalPostsCallback(sv3dm::msg::GoalpostArray::ConstSharedPtr msg) { goal_posts_relative_ = msg; }
+
+void Localization::FieldboundaryCallback(sv3dm::msg::FieldBoundary::ConstSharedPtr msg) {
+  fieldboundary_relative_ = msg;
+}
 
 void Localization::SetInitialPositionCallback(const gm::msg::PoseWithCovarianceStamped &msg) {
   // Transform the given pose to map frame
@@ -290,168 +478,158 @@ void Localization::reset_filter(int distribution, double x, double y, double ang
 }
 
 void Localization::updateMeasurements() {
+  // Keep track of the newest capture time of the measurements, the particles are weighted at this time
+  measurement_stamp_.reset();
+  auto update_measurement_stamp = [this](const builtin_interfaces::msg::Time &stamp) {
+    int64_t stamp_ns = rclcpp::Time(stamp).nanoseconds();
+    measurement_stamp_ = std::max(measurement_stamp_.value_or(stamp_ns), stamp_ns);
+  };
+
   // Sets the measurements in the observation model
-  if (line_pointcloud_relative_.header.stamp != last_stamp_lines && config_.particle_filter.scoring.lines.factor) {
-    robot_pose_observation_model_->set_measurement_lines_pc(line_pointcloud_relative_);
+  if (line_pointcloud_relative_ && line_pointcloud_relative_->header.stamp != last_stamp_lines &&
+      config_.particle_filter.scoring.lines.factor) {
+    robot_pose_observation_model_->set_measurement_lines_pc(*line_pointcloud_relative_);
+    update_measurement_stamp(line_pointcloud_relative_->header.stamp);
   }
-  if (config_.particle_filter.scoring.goal.factor && goal_posts_relative_.header.stamp != last_stamp_goals) {
-    robot_pose_observation_model_->set_measurement_goalposts(goal_posts_relative_);
+  if (config_.particle_filter.scoring.goal.factor && goal_posts_relative_ &&
+      goal_posts_relative_->header.stamp != last_stamp_goals) {
+    robot_pose_observation_model_->set_measurement_goalposts(*goal_posts_relative_);
+    update_measurement_stamp(goal_posts_relative_->header.stamp);
   }
-  if (config_.particle_filter.scoring.field_boundary.factor &&
-      fieldboundary_relative_.header.stamp != last_stamp_fb_points) {
-    robot_pose_observation_model_->set_measurement_field_boundary(fieldboundary_relative_);
+  if (config_.particle_filter.scoring.field_boundary.factor && fieldboundary_relative_ &&
+      fieldboundary_relative_->header.stamp != last_stamp_fb_points) {
+    robot_pose_observation_model_->set_measurement_field_boundary(*fieldboundary_relative_);
+    update_measurement_stamp(fieldboundary_relative_->header.stamp);
   }
 
   // Set timestamps to mark past messages
-  last_stamp_lines = line_pointcloud_relative_.header.stamp;
-  last_stamp_goals = goal_posts_relative_.header.stamp;
-  last_stamp_fb_points = fieldboundary_relative_.header.stamp;
+  if (line_pointcloud_relative_) {
+    last_stamp_lines = line_pointcloud_relative_->header.stamp;
+  }
+  if (goal_posts_relative_) {
+    last_stamp_goals = goal_posts_relative_->header.stamp;
+  }
+  if (fieldboundary_relative_) {
+    last_stamp_fb_points = fieldboundary_relative_->header.stamp;
+  }
 }
 
-void Localization::getMotion() {
-  geometry_msgs::msg::TransformStamped transformStampedNow;
-
-  try {
-    // Get current odometry transform
-    transformStampedNow =
-        tfBuffer->lookupTransform(config_.ros.odom_frame, config_.ros.base_footprint_frame, rclcpp::Time(0));
-
-    // Get linear movement from odometry transform and the transform of the previous filter step
-    double global_diff_x, global_diff_y;
-    global_diff_x = (transformStampedNow.transform.translation.x - previousOdomTransform_.transform.translation.x);
-    global_diff_y = (transformStampedNow.transform.translation.y - previousOdomTransform_.transform.translation.y);
-
-    // Convert to local frame
-    auto [polar_rot, polar_dist] = cartesianToPolar(global_diff_x, global_diff_y);
-    auto [local_movement_x, local_movement_y] =
-        polarToCartesian(polar_rot - tf2::getYaw(previousOdomTransform_.transform.rotation), polar_dist);
-    linear_movement_.x = local_movement_x;
-    linear_movement_.y = local_movement_y;
-    linear_movement_.z = 0;
-
-    // Get angular movement from odometry transform and the transform of the previous filter step
-    rotational_movement_.x = 0;
-    rotational_movement_.y = 0;
-    rotational_movement_.z =
-        tf2::getYaw(transformStampedNow.transform.rotation) - tf2::getYaw(previousOdomTransform_.transform.rotation);
-
-    // Get the time delta between the two transforms
-    double time_delta = rclcpp::Time(transformStampedNow.header.stamp).seconds() -
-                        rclcpp::Time(previousOdomTransform_.header.stamp).seconds();
-
-    // Check if we already applied the motion for this time step
-    if (time_delta > 0) {
-      // Calculate normalized motion (motion per second)
-      auto linear_movement_normalized_x = linear_movement_.x / time_delta;
-      auto linear_movement_normalized_y = linear_movement_.y / time_delta;
-      auto rotational_movement_normalized_z = rotational_movement_.z / time_delta;
-
-      // Check if the robot moved an unreasonable amount and drop the motion if it did
-      if (std::abs(linear_movement_normalized_x) > config_.misc.max_motion_linear or
-          std::abs(linear_movement_normalized_y) > config_.misc.max_motion_linear or
-          std::abs(std::remainder(rotational_movement_normalized_z, 2 * M_PI)) > config_.misc.max_motion_angular) {
-        rotational_movement_.z = 0;
-        linear_movement_.x = 0;
-        linear_movement_.y = 0;
-        RCLCPP_WARN(node_->get_logger(), "Robot moved an unreasonable amount, dropping motion.");
-      }
-
-      // Check if robot moved
-      robot_moved = linear_movement_normalized_x >= config_.misc.min_motion_linear or
-                    linear_movement_normalized_y >= config_.misc.min_motion_linear or
-                    rotational_movement_normalized_z >= config_.misc.min_motion_angular;
-    } else {
-      RCLCPP_WARN_THROTTLE(node_->get_logger(), *node_->get_clock(), 1000,
-                           "Time step delta of zero encountered! Odometry is unavailable.");
-      robot_moved = false;
+void Localization::getMotion(const OdometryPose &from, const OdometryPose &to) {
+  // Get linear movement between the two odometry poses
+  double global_diff_x = to.x - from.x;
+  double global_diff_y = to.y - from.y;
+
+  // Convert to local frame
+  auto [polar_rot, polar_dist] = cartesianToPolar(global_diff_x, global_diff_y);
+  auto [local_movement_x, local_movement_y] = polarToCartesian(polar_rot - from.theta, polar_dist);
+  linear_movement_.x = local_movement_x;
+  linear_movement_.y = local_movement_y;
+  linear_movement_.z = 0;
+
+  // Get angular movement between the two odometry poses
+  rotational_movement_.x = 0;
+  rotational_movement_.y = 0;
+  rotational_movement_.z = std::remainder(to.theta - from.theta, 2 * M_PI);
+
+  // Get the time delta between the two poses
+  double time_delta = (to.stamp - from.stamp) / 1e9;
+
+  // Check if there is any motion between the poses
+  if (time_delta > 0) {
+    // Calculate normalized motion (motion per second)
+    auto linear_movement_normalized_x = linear_movement_.x / time_delta;
+    auto linear_movement_normalized_y = linear_movement_.y / time_delta;
+    auto rotational_movement_normalized_z = rotational_movement_.z / time_delta;
+
+    // Check if the robot moved an unreasonable amount and drop the motion if it did
+    if (std::abs(linear_movement_normalized_x) > config_.misc.max_motion_linear or
+        std::abs(linear_movement_normalized_y) > config_.misc.max_motion_linear or
+        std::abs(rotational_movement_normalized_z) > config_.misc.max_motion_angular) {
+      rotational_movement_.z = 0;
+      linear_movement_.x = 0;
+      linear_movement_.y = 0;
+      RCLCPP_WARN(node_->get_logger(), "Robot moved an unreasonable amount, dropping motion.");
     }
 
-    // Set the variable for the transform of the previous step to the transform of the current step, because we finished
-    // this step.
-    previousOdomTransform_ = transformStampedNow;
-  } catch (const tf2::TransformException &ex) {
-    RCLCPP_WARN(node_->get_logger(), "Could not acquire motion for odom transforms: %s", ex.what());
+    // Check if robot moved
+    robot_moved = linear_movement_normalized_x >= config_.misc.min_motion_linear or
+                  linear_movement_normalized_y >= config_.misc.min_motion_linear or
+                  rotational_movement_normalized_z >= config_.misc.min_motion_angular;
+  } else {
+    robot_moved = false;
   }
 }
 
-void Localization::publish_transforms() {
-  // get estimate and covariance
-  auto estimate = robot_pf_->getBestXPercentEstimate(config_.misc.percentage_best_particles);
-
-  // Convert to tf2
-  tf2::Transform filter_transform;
-  filter_transform.setOrigin(tf2::Vector3(estimate.getXPos(), estimate.getYPos(), 0.0));
-  tf2::Quaternion q;
-  q.setRPY(0, 0, estimate.getTheta());
-  filter_transform.setRotation(q);
+void Localization::update_estimate() {
+  // Copy the particles once, the estimate, its covariance and the clustering all read the same arrays
+  std::vector<pf::Particle<RobotState> *> particles(robot_pf_->particleListBegin(), robot_pf_->particleListEnd());
+  particle_arrays_.gather(particles);
+  particle_arrays_.estimate(config_.misc.percentage_best_particles, false, estimate_, estimate_cov_);
+  hypothesis_clustering_->update(particle_arrays_, true);
+}
 
-  // Get the transform from the last measurement timestamp until now
-  geometry_msgs::msg::TransformStamped odomDuringMeasurement, odomNow;
-  try {
-    odomNow = tfBuffer->lookupTransform(config_.ros.odom_frame, config_.ros.base_footprint_frame, rclcpp::Time(0));
-  } catch (const tf2::TransformException &ex) {
-    RCLCPP_WARN(node_->get_logger(), "Could not acquire odom transforms: %s", ex.what());
+void Localization::publish_transforms() {
+  // The estimate belongs to the odometry pose the particles were moved to in this step
+  const std::optional<OdometryPose> &odom_now = previous_odom_pose_;
+  if (!odom_now) {
+    RCLCPP_WARN_THROTTLE(node_->get_logger(), *node_->get_clock(), 1000,
+                         "Odom not available, therefore odom offset can not be published");
+    return;
   }
 
-  // Update estimate_ with the new estimate
-  estimate_.setXPos(filter_transform.getOrigin().x());
-  estimate_.setYPos(filter_transform.getOrigin().y());
-  estimate_.setTheta(tf2::getYaw(filter_transform.getRotation()));
-  estimate_cov_ = robot_pf_->getCovariance(config_.misc.percentage_best_particles);
-
   //////////////////////
   // publish transforms//
   //////////////////////
 
-  try {
-    // Publish localization tf, not the odom offset
-    geometry_msgs::msg::TransformStamped localization_transform;
-    localization_transform.header.stamp = odomNow.header.stamp;
-    localization_transform.header.frame_id = config_.ros.map_frame;
-    localization_transform.child_frame_id = config_.ros.publishing_frame;
-    localization_transform.transform.translation.x = estimate_.getXPos();
-    localization_transform.transform.translation.y = estimate_.getYPos();
-    localization_transform.transform.translation.z = 0.0;
-    q = tf2::Quaternion();
-    q.setRPY(0, 0, estimate_.getTheta());
-    q.normalize();
-    localization_transform.transform.rotation.x = q.x();
-    localization_transform.transform.rotation.y = q.y();
-    localization_transform.transform.rotation.z = q.z();
-    localization_transform.transform.rotation.w = q.w();
-
-    // Check if a transform for the current timestamp was already published
-    if (localization_tf_last_published_time_ != localization_transform.header.stamp) {
-      // Do not resend a transform for the same timestamp
-      localization_tf_last_published_time_ = localization_transform.header.stamp;
-      br->sendTransform(localization_transform);
-    }
+  // Publish localization tf, not the odom offset
+  geometry_msgs::msg::TransformStamped localization_transform;
+  localization_transform.header.stamp = rclcpp::Time(odom_now->stamp, node_->get_clock()->get_clock_type());
+  localization_transform.header.frame_id = config_.ros.map_frame;
+  localization_transform.child_frame_id = config_.ros.publishing_frame;
+  localization_transform.transform.translation.x = estimate_.getXPos();
+  localization_transform.transform.translation.y = estimate_.getYPos();
+  localization_transform.transform.translation.z = 0.0;
+  tf2::Quaternion q;
+  q.setRPY(0, 0, estimate_.getTheta());
+  q.normalize();
+  localization_transform.transform.rotation.x = q.x();
+  localization_transform.transform.rotation.y = q.y();
+  localization_transform.transform.rotation.z = q.z();
+  localization_transform.transform.rotation.w = q.w();
+
+  // Check if a transform for the current timestamp was already published
+  if (localization_tf_last_published_time_ != localization_transform.header.stamp) {
+    // Do not resend a transform for the same timestamp
+    localization_tf_last_published_time_ = localization_transform.header.stamp;
+    br->sendTransform(localization_transform);
+  }
 
-    // Publish odom localization offset
-    geometry_msgs::msg::TransformStamped map_odom_transform;
+  // Publish odom localization offset
+  geometry_msgs::msg::TransformStamped map_odom_transform;
 
-    map_odom_transform.header.stamp = node_->get_clock()->now();
-    map_odom_transform.header.frame_id = config_.ros.map_frame;
-    map_odom_transform.child_frame_id = config_.ros.odom_frame;
+  map_odom_transform.header.stamp = node_->get_clock()->now();
+  map_odom_transform.header.frame_id = config_.ros.map_frame;
+  map_odom_transform.child_frame_id = config_.ros.odom_frame;
 
-    // Calculate odom offset
-    tf2::Transform odom_transform_tf, localization_transform_tf, map_tf;
-    tf2::fromMsg(odomNow.transform, odom_transform_tf);
-    tf2::fromMsg(localization_transform.transform, localization_transform_tf);
-    map_tf = localization_transform_tf * odom_transform_tf.inverse();
+  // Calculate odom offset from the buffered odometry pose, which defines the odom frame. This is the same pose the
+  // particles were moved to, so the estimate and the offset belong to the same point in time without a tf lookup.
+  tf2::Transform odom_transform_tf, localization_transform_tf, map_tf;
+  tf2::Quaternion odom_rotation;
+  odom_rotation.setRPY(0, 0, odom_now->theta);
+  odom_transform_tf.setOrigin(tf2::Vector3(odom_now->x, odom_now->y, 0));
+  odom_transform_tf.setRotation(odom_rotation);
+  tf2::fromMsg(localization_transform.transform, localization_transform_tf);
+  map_tf = localization_transform_tf * odom_transform_tf.inverse();
 
-    map_odom_transform.transform = tf2::toMsg(map_tf);
+  map_odom_transform.transform = tf2::toMsg(map_tf);
 
-    RCLCPP_DEBUG(node_->get_logger(), "Transform %s", geometry_msgs::msg::to_yaml(map_odom_transform).c_str());
+  RCLCPP_DEBUG(node_->get_logger(), "Transform %s", geometry_msgs::msg::to_yaml(map_odom_transform).c_str());
 
-    // Check if a transform for the current timestamp was already published
-    if (map_odom_tf_last_published_time_ != map_odom_transform.header.stamp) {
-      // Do not resend a transform for the same timestamp
-      map_odom_tf_last_published_time_ = map_odom_transform.header.stamp;
-      br->sendTransform(map_odom_transform);
-    }
-  } catch (const tf2::TransformException &ex) {
-    RCLCPP_WARN(node_->get_logger(), "Odom not available, therefore odom offset can not be published: %s", ex.what());
+  // Check if a transform for the current timestamp was already published
+  if (map_odom_tf_last_published_time_ != map_odom_transform.header.stamp) {
+    // Do not resend a transform for the same timestamp
+    map_odom_tf_last_published_time_ = map_odom_transform.header.stamp;
+    br->sendTransform(map_odom_transform);
   }
 }
 
@@ -479,6 +657,28 @@ void Localization::publish_pose_with_covariance() {
   pose_with_covariance_publisher_->publish(estimateMsg);
 }
 
+void Localization::publish_hypotheses() {
+  bitbots_msgs::msg::PoseWithCertaintyArray hypotheses_msg;
+  hypotheses_msg.header.stamp = node_->get_clock()->now();
+  hypotheses_msg.header.frame_id = config_.ros.map_frame;
+
+  for (const PoseHypothesis &hypothesis : hypothesis_clustering_->hypotheses()) {
+    tf2::Quaternion q;
+    q.setRPY(0, 0, hypothesis.mean.getTheta());
+    q.normalize();
+
+    bitbots_msgs::msg::PoseWithCertainty pose;
+    pose.pose.pose.position.x = hypothesis.mean.getXPos();
+    pose.pose.pose.position.y = hypothesis.mean.getYPos();
+    pose.pose.pose.orientation = tf2::toMsg(q);
+    std::copy(hypothesis.covariance.begin(), hypothesis.covariance.end(), pose.pose.covariance.begin());
+    pose.confidence = hypothesis.weight;
+    hypotheses_msg.poses.push_back(pose);
+  }
+
+  pose_hypotheses_publisher_->publish(hypotheses_msg);
+}
+
 void Localization::publish_debug() {
   // Show a marker for each particle
   publish_particle_markers();
@@ -519,8 +719,6 @@ void Localization::publish_ratings() {
 void Localization::publish_debug_rating(std::vector<std::pair<double, double>> measurements, double scale,
                                         const char name[], std::shared_ptr<Map> map,
                                         rclcpp::Publisher<visualization_msgs::msg::Marker>::SharedPtr &publisher) {
-  RobotState best_estimate = robot_pf_->getBestXPercentEstimate(config_.misc.percentage_best_particles);
-
   visualization_msgs::msg::Marker marker;
   marker.header.frame_id = config_.ros.map_frame;
   marker.header.stamp = node_->get_clock()->now();
@@ -535,8 +733,8 @@ void Localization::publish_debug_rating(std::vector<std::pair<double, double>> m
     // lines are in polar form!
     std::pair<double, double> observationRelative;
 
-    observationRelative = map->observationRelative(measurement, best_estimate.getXPos(), best_estimate.getYPos(),
-                                                   best_estimate.getTheta());
+    observationRelative =
+        map->observationRelative(measurement, estimate_.getXPos(), estimate_.getYPos(), estimate_.getTheta());
     double occupancy = map->get_occupancy(observationRelative.first, observationRelative.second);
 
     geometry_msgs::msg::Point point;
@@ -558,12 +756,3 @@ void Localization::publish_debug_rating(std::vector<std::pair<double, double>> m
   publisher->publish(marker);
 }
 }  // namespace bitbots_localization
-
-int main(int argc, char *argv[]) {
-  rclcpp::init(argc, argv);
-  auto node = rclcpp::Node::make_shared("bitbots_localization");
-  [[maybe_unused]] auto localization = bitbots_localization::Localization(node);
-  rclcpp::spin(node);
-  rclcpp::shutdown();
-  return 0;
-}
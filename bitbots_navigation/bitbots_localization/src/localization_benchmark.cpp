@@ -0,0 +1,256 @@
+/**
+ * Offline replay benchmark of the localization.
+ *
+ * Replays the measurements and the odometry of a recorded bag through the localization pipeline as fast as possible.
+ * The filter is stepped at its configured rate in bag time, so the results do not depend on the speed of the machine.
+ * For each of the given particle counts, the latency percentiles of the filter stages, the step throughput and the
+ * pose error against a recorded ground truth are reported.
+ *
+ * Usage:
+ *   ros2 run bitbots_localization localization_benchmark --ros-args \
+ *     --params-file $(ros2 pkg prefix bitbots_localization)/share/bitbots_localization/config/config.yaml \
+ *     -p benchmark.bag:=<path> -p benchmark.particle_counts:=[100,250,500,1000]
+ */
+
+#include <cmath>
+#include <map>
+#include <numeric>
+#include <optional>
+#include <rclcpp/serialization.hpp>
+#include <rosbag2_cpp/reader.hpp>
+
+#include "bitbots_localization/localization.hpp"
+
+namespace bitbots_localization {
+
+/**
+ * A recorded message, only one of the pointers is set
+ */
+struct ReplayEvent {
+  rclcpp::Time stamp;
+  sm::msg::PointCloud2::ConstSharedPtr lines;
+  sv3dm::msg::GoalpostArray::ConstSharedPtr goals;
+  sv3dm::msg::FieldBoundary::ConstSharedPtr field_boundary;
+  nav_msgs::msg::Odometry::ConstSharedPtr odometry;
+  gm::msg::PoseWithCovarianceStamped::ConstSharedPtr ground_truth;
+};
+
+template <typename T>
+std::shared_ptr<const T> deserialize(const rosbag2_storage::SerializedBagMessage &bag_message) {
+  rclcpp::SerializedMessage serialized(*bag_message.serialized_data);
+  auto msg = std::make_shared<T>();
+  rclcpp::Serialization<T>().deserialize_message(&serialized, msg.get());
+  return msg;
+}
+
+/**
+ * Reads all relevant messages of the bag into memory, so reading the bag is not part of the measurement
+ */
+std::vector<ReplayEvent> read_bag(const std::string &path, const bitbots_localization::Params &config,
+                                  const std::string &ground_truth_topic) {
+  std::vector<ReplayEvent> events;
+  rosbag2_cpp::Reader reader;
+  reader.open(path);
+  while (reader.has_next()) {
+    auto bag_message = reader.read_next();
+    ReplayEvent event;
+    event.stamp = rclcpp::Time(bag_message->time_stamp);
+    // The recorded topic names are absolute, the configured ones can be relative
+    const std::string &topic = bag_message->topic_name;
+    auto is_topic = [&topic](const std::string &name) { return topic == name || topic == "/" + name; };
+    if (is_topic(config.ros.line_pointcloud_topic)) {
+      event.lines = deserialize<sm::msg::PointCloud2>(*bag_message);
+    } else if (is_topic(config.ros.goal_topic)) {
+      event.goals = deserialize<sv3dm::msg::GoalpostArray>(*bag_message);
+    } else if (is_topic(config.ros.fieldboundary_topic)) {
+      event.field_boundary = deserialize<sv3dm::msg::FieldBoundary>(*bag_message);
+    } else if (is_topic(config.ros.odometry_topic)) {
+      event.odometry = deserialize<nav_msgs::msg::Odometry>(*bag_message);
+    } else if (is_topic(ground_truth_topic)) {
+      event.ground_truth = deserialize<gm::msg::PoseWithCovarianceStamped>(*bag_message);
+    } else {
+      continue;
+    }
+    events.push_back(std::move(event));
+  }
+  std::stable_sort(events.begin(), events.end(),
+                   [](const ReplayEvent &a, const ReplayEvent &b) { return a.stamp < b.stamp; });
+  return events;
+}
+
+/**
+ * Returns the given percentile (0-100) of the values, the values are reordered
+ */
+double percentile(std::vector<double> &values, double percent) {
+  if (values.empty()) {
+    return 0;
+  }
+  size_t index = std::min(values.size() - 1, static_cast<size_t>(percent / 100.0 * values.size()));
+  std::nth_element(values.begin(), values.begin() + index, values.end());
+  return values[index];
+}
+
+/**
+ * Collected results of one replay
+ */
+struct BenchmarkResult {
+  std::map<std::string, std::vector<double>> stage_durations;
+  std::vector<double> step_durations;
+  std::vector<double> position_errors;
+  std::vector<double> orientation_errors;
+  double wall_time = 0;
+  double mean_particle_count = 0;
+};
+
+BenchmarkResult replay(rclcpp::Node::SharedPtr node, const std::vector<ReplayEvent> &events,
+                       const std::string &field_name, const FieldDimensions &field_dimensions, double rate) {
+  BenchmarkResult result;
+  Localization localization(node, field_name, field_dimensions);
+  rclcpp::Duration step_period = rclcpp::Duration::from_seconds(1.0 / rate);
+
+  gm::msg::PoseWithCovarianceStamped::ConstSharedPtr ground_truth;
+  std::optional<rclcpp::Time> next_step;
+  auto wall_start = std::chrono::steady_clock::now();
+
+  for (const ReplayEvent &event : events) {
+    // Run all filter steps that are due before this message
+    while (next_step && event.stamp >= *next_step) {
+      auto step_start = std::chrono::steady_clock::now();
+      localization.step();
+      result.step_durations.push_back(
+          std::chrono::duration<double>(std::chrono::steady_clock::now() - step_start).count());
+
+      const Localization::StepTimings &timings = localization.get_step_timings();
+      result.stage_durations["measurements"].push_back(timings.measurements);
+      result.stage_durations["motion"].push_back(timings.motion);
+      result.stage_durations["weighting"].push_back(timings.weighting);
+      result.stage_durations["resampling"].push_back(timings.resampling);
+      result.stage_durations["estimate"].push_back(timings.estimate);
+      result.stage_durations["publishing"].push_back(timings.publishing);
+      result.mean_particle_count += localization.get_particle_count();
+
+      // Compare the estimate with the latest ground truth
+      if (ground_truth) {
+        const RobotState &estimate = localization.get_estimate();
+        result.position_errors.push_back(std::hypot(estimate.getXPos() - ground_truth->pose.pose.position.x,
+                                                    estimate.getYPos() - ground_truth->pose.pose.position.y));
+        double true_theta = tf2::getYaw(ground_truth->pose.pose.orientation);
+        result.orientation_errors.push_back(std::abs(std::remainder(estimate.getTheta() - true_theta, 2 * M_PI)));
+      }
+      *next_step += step_period;
+    }
+
+    if (event.lines) {
+      localization.LinePointcloudCallback(event.lines);
+    } else if (event.goals) {
+      localization.GoalPostsCallback(event.goals);
+    } else if (event.field_boundary) {
+      localization.FieldboundaryCallback(event.field_boundary);
+    } else if (event.odometry) {
+      localization.OdometryCallback(event.odometry);
+      // Start stepping once the odometry is available
+      if (!next_step) {
+        next_step = event.stamp + step_period;
+      }
+    } else if (event.ground_truth) {
+      ground_truth = event.ground_truth;
+    }
+  }
+
+  result.wall_time = std::chrono::duration<double>(std::chrono::steady_clock::now() - wall_start).count();
+  if (!result.step_durations.empty()) {
+    result.mean_particle_count /= result.step_durations.size();
+  }
+  return result;
+}
+
+void report(const rclcpp::Logger &logger, int64_t particle_count, BenchmarkResult &result) {
+  size_t steps = result.step_durations.size();
+  RCLCPP_INFO(logger, "Particles: %d (mean %.1f), steps: %zu, wall time: %.3f s, throughput: %.1f steps/s",
+              static_cast<int>(particle_count), result.mean_particle_count, steps, result.wall_time,
+              result.wall_time > 0 ? steps / result.wall_time : 0.0);
+
+  auto report_latency = [&logger](const std::string &name, std::vector<double> &durations) {
+    RCLCPP_INFO(logger, "  %-12s p50: %8.3f ms  p90: %8.3f ms  p99: %8.3f ms  max: %8.3f ms", name.c_str(),
+                percentile(durations, 50) * 1e3, percentile(durations, 90) * 1e3, percentile(durations, 99) * 1e3,
+                percentile(durations, 100) * 1e3);
+  };
+  for (auto &[name, durations] : result.stage_durations) {
+    report_latency(name, durations);
+  }
+  report_latency("step", result.step_durations);
+
+  if (result.position_errors.empty()) {
+    RCLCPP_INFO(logger, "  No ground truth available");
+  } else {
+    double mean_position_error = std::accumulate(result.position_errors.begin(), result.position_errors.end(), 0.0) /
+                                 result.position_errors.size();
+    double mean_orientation_error =
+        std::accumulate(result.orientation_errors.begin(), result.orientation_errors.end(), 0.0) /
+        result.orientation_errors.size();
+    RCLCPP_INFO(logger, "  Position error     mean: %.3f m  p90: %.3f m  max: %.3f m", mean_position_error,
+                percentile(result.position_errors, 90), percentile(result.position_errors, 100));
+    RCLCPP_INFO(logger, "  Orientation error  mean: %.3f rad  p90: %.3f rad  max: %.3f rad", mean_orientation_error,
+                percentile(result.orientation_errors, 90), percentile(result.orientation_errors, 100));
+  }
+}
+}  // namespace bitbots_localization
+
+int main(int argc, char *argv[]) {
+  rclcpp::init(argc, argv);
+  // Use the name of the localization node, so its parameter file can be used directly
+  auto node = rclcpp::Node::make_shared("bitbots_localization");
+
+  // Read the localization parameters for the topics and the rate of the filter
+  auto config = bitbots_localization::ParamListener(node->get_node_parameters_interface()).get_params();
+
+  auto bag = node->declare_parameter<std::string>("benchmark.bag", "");
+  auto ground_truth_topic = node->declare_parameter<std::string>("benchmark.ground_truth_topic", "ground_truth");
+  auto particle_counts = node->declare_parameter<std::vector<int64_t>>("benchmark.particle_counts",
+                                                                      {config.particle_filter.particle_number});
+
+  // The field is normally read from the parameter blackboard, which is not available offline
+  auto field_name = node->declare_parameter<std::string>("field.name", "webots");
+  bitbots_localization::FieldDimensions field_dimensions;
+  field_dimensions.x = node->declare_parameter<double>("field.size.x", 9.0);
+  field_dimensions.y = node->declare_parameter<double>("field.size.y", 6.0);
+  field_dimensions.padding = node->declare_parameter<double>("field.size.padding", 1.0);
+
+  if (bag.empty()) {
+    RCLCPP_ERROR(node->get_logger(), "No bag given, set the parameter 'benchmark.bag'");
+    rclcpp::shutdown();
+    return 1;
+  }
+
+  RCLCPP_INFO(node->get_logger(), "Reading bag %s...", bag.c_str());
+  auto events = bitbots_localization::read_bag(bag, config, ground_truth_topic);
+  RCLCPP_INFO(node->get_logger(), "Read %zu messages", events.size());
+
+  for (int64_t particle_count : particle_counts) {
+    // The particle count is read only, so each replay gets its own node with the particle count as override.
+    // A fixed particle count is benchmarked, so the adaptive particle count is disabled.
+    rclcpp::NodeOptions options;
+    options.parameter_overrides({rclcpp::Parameter("particle_filter.particle_number", particle_count),
+                                 rclcpp::Parameter("particle_filter.kld.enabled", false)});
+    auto replay_node = rclcpp::Node::make_shared("bitbots_localization", options);
+    auto result =
+        bitbots_localization::replay(replay_node, events, field_name, field_dimensions, config.particle_filter.rate);
+    bitbots_localization::report(node->get_logger(), particle_count, result);
+
+    if (result.step_durations.empty()) {
+      RCLCPP_ERROR(node->get_logger(), "The filter did not run, is the odometry topic '%s' recorded?",
+                   config.ros.odometry_topic.c_str());
+      rclcpp::shutdown();
+      return 1;
+    }
+    if (std::abs(result.mean_particle_count - particle_count) > 0.5) {
+      RCLCPP_ERROR(node->get_logger(), "The filter ran with %.1f instead of %d particles", result.mean_particle_count,
+                   static_cast<int>(particle_count));
+      rclcpp::shutdown();
+      return 1;
+    }
+  }
+
+  rclcpp::shutdown();
+  return 0;
+}
@@ -0,0 +1,10 @@
+#include "bitbots_localization/localization.hpp"
+
+int main(int argc, char *argv[]) {
+  rclcpp::init(argc, argv);
+  auto node = rclcpp::Node::make_shared("bitbots_localization");
+  [[maybe_unused]] auto localization = bitbots_localization::Localization(node);
+  rclcpp::spin(node);
+  rclcpp::shutdown();
+  return 0;
+}
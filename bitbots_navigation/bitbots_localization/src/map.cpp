@@ -4,65 +4,269 @@
 
 #include "bitbots_localization/map.hpp"
 
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <algorithm>
 #include <ament_index_cpp/get_package_share_directory.hpp>
 #include <boost/filesystem.hpp>
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
 
 namespace fs = boost::filesystem;
 
 namespace bitbots_localization {
 
-Map::Map(const std::string &name, const std::string &type, const double out_of_map_value) {
+namespace {
+// Header of the binary map cache. It is followed by the padded likelihood field of each level, which starts with the
+// number of rows and columns and contains the values as row major floats.
+struct CacheHeader {
+  uint32_t magic;
+  uint32_t version;
+  int64_t source_time;
+  double out_of_map_value;
+  uint32_t levels;
+  uint32_t border;
+};
+
+constexpr uint32_t CACHE_MAGIC = 0x424c4d31;  // "BLM1"
+constexpr uint32_t CACHE_VERSION = 1;
+constexpr int BORDER = 1;
+
+// Returns the directory of the map caches, which is $ROS_HOME (defaulting to ~/.ros) or $XDG_CACHE_HOME if ROS_HOME is
+// not set, or an empty path if none of them can be determined
+fs::path cache_directory() {
+  fs::path base;
+  if (const char *ros_home = std::getenv("ROS_HOME")) {
+    base = ros_home;
+  } else if (const char *xdg_cache_home = std::getenv("XDG_CACHE_HOME")) {
+    base = xdg_cache_home;
+  } else if (const char *home = std::getenv("HOME")) {
+    base = fs::path(home) / ".ros";
+  } else {
+    return fs::path();
+  }
+  return base / "bitbots_localization" / "map_cache";
+}
+}  // namespace
+
+Map::Map(const std::string &name, const std::string &type, const double out_of_map_value, int pyramid_levels,
+         bool use_cache) {
   // Set config
   out_of_map_value_ = out_of_map_value;
+  pyramid_levels = std::max(pyramid_levels, 1);
   // get package path
   std::string map_package_path = ament_index_cpp::get_package_share_directory("bitbots_parameter_blackboard");
   // make boost path
   fs::path map_path = fs::path("config/fields") / fs::path(name) / fs::path(type);
   // convert to absolute path
   fs::path absolute_map_path = fs::absolute(map_path, map_package_path);
+
+  boost::system::error_code error;
+  int64_t source_time = fs::last_write_time(absolute_map_path, error);
+  if (error) {
+    RCLCPP_ERROR(rclcpp::get_logger("bitbots_localization"), "No image data '%s'", map_path.c_str());
+    compile(cv::Mat(0, 0, CV_8UC1), pyramid_levels);
+    return;
+  }
+
+  // The cache is stored in a writable directory of the user, as the share directory is usually read only
+  std::string cache_path;
+  if (use_cache && !cache_directory().empty()) {
+    fs::path directory = cache_directory() / fs::path(name);
+    fs::create_directories(directory, error);
+    if (error) {
+      RCLCPP_WARN(rclcpp::get_logger("bitbots_localization"), "Could not create map cache directory '%s'",
+                  directory.c_str());
+    } else {
+      cache_path = (directory / fs::path(type)).string() + ".cache";
+    }
+  }
+
+  // Try to reuse the compiled map of a previous start
+  if (!cache_path.empty() && load_cache(cache_path, source_time, pyramid_levels)) {
+    return;
+  }
+
   // load map
-  map = cv::imread(absolute_map_path.string(), cv::IMREAD_GRAYSCALE);
-  if (!map.data) {
+  cv::Mat image = cv::imread(absolute_map_path.string(), cv::IMREAD_GRAYSCALE);
+  if (!image.data) {
     RCLCPP_ERROR(rclcpp::get_logger("bitbots_localization"), "No image data '%s'", map_path.c_str());
+    compile(cv::Mat(0, 0, CV_8UC1), pyramid_levels);
     return;
   }
+  compile(image, pyramid_levels);
+
+  // Without a cache the map is simply compiled again on the next start
+  if (!cache_path.empty()) {
+    save_cache(cache_path, source_time);
+  }
 }
 
-double Map::get_occupancy(double x, double y) {
-  // get dimensions of field
-  int mapWidth = map.cols;
-  int mapHeight = map.rows;
+Map::~Map() {
+  if (cache_mapping_) {
+    munmap(cache_mapping_, cache_size_);
+  }
+}
 
-  // m to pixel (=cm)
-  x = x * 100;
-  y = y * 100;
+void Map::compile(const cv::Mat &image, int pyramid_levels) {
+  levels_.clear();
+  if (image.empty()) {
+    // Without an image every lookup ends up on the border
+    levels_.push_back({cv::Mat(2 * BORDER, 2 * BORDER, CV_32F, cv::Scalar(out_of_map_value_ / 100.0)), 100.0});
+    return;
+  }
 
-  // ursprung in feldmitte
-  x = std::round(x + mapWidth / 2.0);  // assuming lines are centered on map
-  y = std::round(y + mapHeight / 2.0);
+  // Normalize the occupancy to [0, 1]
+  cv::Mat likelihood;
+  image.convertTo(likelihood, CV_32F, -1 / 100.0, 1.0);
 
-  double occupancy = out_of_map_value_;  // punish points outside the map
+  for (int level = 0; level < pyramid_levels; level++) {
+    if (level > 0) {
+      // Each level averages 2x2 cells of the previous one
+      cv::Mat coarse;
+      cv::resize(likelihood, coarse, cv::Size((likelihood.cols + 1) / 2, (likelihood.rows + 1) / 2), 0, 0,
+                 cv::INTER_AREA);
+      likelihood = coarse;
+    }
+    Level padded;
+    cv::copyMakeBorder(likelihood, padded.likelihood, BORDER, BORDER, BORDER, BORDER, cv::BORDER_CONSTANT,
+                       cv::Scalar(out_of_map_value_ / 100.0));
+    padded.cells_per_meter = 100.0 / (1 << level);
+    levels_.push_back(padded);
+  }
+}
+
+bool Map::load_cache(const std::string &path, int64_t source_time, int pyramid_levels) {
+  int file = open(path.c_str(), O_RDONLY);
+  if (file < 0) {
+    return false;
+  }
+  struct stat file_stat;
+  if (fstat(file, &file_stat) != 0 || file_stat.st_size < static_cast<off_t>(sizeof(CacheHeader))) {
+    close(file);
+    return false;
+  }
+  size_t size = file_stat.st_size;
+  void *mapping = mmap(nullptr, size, PROT_READ, MAP_PRIVATE, file, 0);
+  close(file);
+  if (mapping == MAP_FAILED) {
+    return false;
+  }
+
+  // Check if the cache belongs to the current map image and configuration
+  const auto *header = static_cast<const CacheHeader *>(mapping);
+  if (header->magic != CACHE_MAGIC || header->version != CACHE_VERSION || header->source_time != source_time ||
+      header->out_of_map_value != out_of_map_value_ || header->levels != static_cast<uint32_t>(pyramid_levels) ||
+      header->border != BORDER) {
+    munmap(mapping, size);
+    return false;
+  }
+
+  // Wrap the levels around the mapped memory without copying them
+  std::vector<Level> levels;
+  size_t offset = sizeof(CacheHeader);
+  for (int level = 0; level < pyramid_levels; level++) {
+    if (offset + 2 * sizeof(uint32_t) > size) {
+      munmap(mapping, size);
+      return false;
+    }
+    const auto *dimensions = reinterpret_cast<const uint32_t *>(static_cast<const char *>(mapping) + offset);
+    offset += 2 * sizeof(uint32_t);
+    size_t data_size = static_cast<size_t>(dimensions[0]) * dimensions[1] * sizeof(float);
+    if (offset + data_size > size) {
+      munmap(mapping, size);
+      return false;
+    }
+    Level cached;
+    cached.likelihood = cv::Mat(dimensions[0], dimensions[1], CV_32F, static_cast<char *>(mapping) + offset);
+    cached.cells_per_meter = 100.0 / (1 << level);
+    levels.push_back(cached);
+    offset += data_size;
+  }
+
+  levels_ = levels;
+  cache_mapping_ = mapping;
+  cache_size_ = size;
+  return true;
+}
 
-  if (x < mapWidth && x >= 0 && y < mapHeight && y >= 0) {
-    occupancy = 100 - map.at<uchar>(y, x);
+void Map::save_cache(const std::string &path, int64_t source_time) const {
+  // Write to a temporary file first, so other processes never map a partially written cache
+  std::string temporary_path = path + ".tmp";
+  std::ofstream file(temporary_path, std::ios::binary);
+  if (!file) {
+    RCLCPP_WARN(rclcpp::get_logger("bitbots_localization"), "Could not write map cache '%s'", path.c_str());
+    return;
+  }
+  CacheHeader header{
+      CACHE_MAGIC, CACHE_VERSION, source_time, out_of_map_value_, static_cast<uint32_t>(levels_.size()), BORDER};
+  file.write(reinterpret_cast<const char *>(&header), sizeof(header));
+  for (const Level &level : levels_) {
+    uint32_t dimensions[2] = {static_cast<uint32_t>(level.likelihood.rows),
+                              static_cast<uint32_t>(level.likelihood.cols)};
+    file.write(reinterpret_cast<const char *>(dimensions), sizeof(dimensions));
+    for (int row = 0; row < level.likelihood.rows; row++) {
+      file.write(level.likelihood.ptr<char>(row), level.likelihood.cols * sizeof(float));
+    }
+  }
+  file.close();
+  if (!file || std::rename(temporary_path.c_str(), path.c_str()) != 0) {
+    RCLCPP_WARN(rclcpp::get_logger("bitbots_localization"), "Could not write map cache '%s'", path.c_str());
+    std::remove(temporary_path.c_str());
   }
-  return occupancy / 100.0;
 }
 
-std::vector<double> Map::provideRating(const RobotState &state,
-                                       const std::vector<std::pair<double, double>> &observations) {
-  std::vector<double> rating;
-  for (const std::pair<double, double> &observation : observations) {
-    // lines are in polar form!
-    std::pair<double, double> lineRelative;
+double Map::get_occupancy(double x, double y) const {
+  const cv::Mat &likelihood = levels_[0].likelihood;
+
+  // m to cells with the origin in the center of the field, assuming the lines are centered on the map
+  long cell_x = std::lround(x * levels_[0].cells_per_meter + (likelihood.cols - 2 * BORDER) / 2.0) + BORDER;
+  long cell_y = std::lround(y * levels_[0].cells_per_meter + (likelihood.rows - 2 * BORDER) / 2.0) + BORDER;
+
+  // Points outside the map are clamped onto the border, which contains the out of map value
+  cell_x = std::clamp<long>(cell_x, 0, likelihood.cols - 1);
+  cell_y = std::clamp<long>(cell_y, 0, likelihood.rows - 1);
+  return likelihood.at<float>(cell_y, cell_x);
+}
+
+double Map::get_out_of_map_value() const { return out_of_map_value_; }
 
-    // get rating per line
-    lineRelative = observationRelative(observation, state.getXPos(), state.getYPos(), state.getTheta());
-    double occupancy = get_occupancy(lineRelative.first, lineRelative.second);
+double Map::rateMeasurements(const RobotState &state, const MeasurementPoints &measurements, int level) const {
+  const Level &map_level = levels_[std::clamp<int>(level, 0, static_cast<int>(levels_.size()) - 1)];
+  const cv::Mat &likelihood = map_level.likelihood;
 
-    rating.push_back(occupancy);
+  // Rotate and translate the measurements into the map using the cached orientation of the particle
+  // and fold the conversion from m to cells as well as the map center and border into the transform
+  const double sin_theta = state.getSinTheta() * map_level.cells_per_meter;
+  const double cos_theta = state.getCosTheta() * map_level.cells_per_meter;
+  const double offset_x =
+      state.getXPos() * map_level.cells_per_meter + (likelihood.cols - 2 * BORDER) / 2.0 + BORDER + 0.5;
+  const double offset_y =
+      state.getYPos() * map_level.cells_per_meter + (likelihood.rows - 2 * BORDER) / 2.0 + BORDER + 0.5;
+
+  const float *data = likelihood.ptr<float>();
+  const size_t step = likelihood.step1();
+  const long max_x = likelihood.cols - 1;
+  const long max_y = likelihood.rows - 1;
+  const double *measurement_x = measurements.x.data();
+  const double *measurement_y = measurements.y.data();
+  const size_t count = measurements.size();
+
+  // Plain loop over the separate coordinate arrays, so the compiler is able to vectorize the transform.
+  // Points outside the map are clamped onto the border, which contains the out of map value.
+  double occupancy_sum = 0;
+  for (size_t i = 0; i < count; i++) {
+    const double map_x = offset_x + cos_theta * measurement_x[i] - sin_theta * measurement_y[i];
+    const double map_y = offset_y + sin_theta * measurement_x[i] + cos_theta * measurement_y[i];
+    long x = std::clamp<long>(static_cast<long>(std::floor(map_x)), 0, max_x);
+    long y = std::clamp<long>(static_cast<long>(std::floor(map_y)), 0, max_y);
+    occupancy_sum += data[y * step + x];
   }
-  return rating;
+  return occupancy_sum;
 }
 
 std::pair<double, double> Map::observationRelative(
@@ -90,25 +294,32 @@ std::pair<double, double> Map::observationRelative(
   return observationRelative;  // in cartesian
 }
 
-nav_msgs::msg::OccupancyGrid Map::get_map_msg(std::string frame_id, int threshold) {
-  nav_msgs::msg::OccupancyGrid map_msg;
-  map_msg.header.frame_id = frame_id;
-  map_msg.info.resolution = 0.01;
-  map_msg.info.width = map.cols;
-  map_msg.info.height = map.rows;
-  map_msg.info.origin.position.x = -map.cols / 2.0 * map_msg.info.resolution;
-  map_msg.info.origin.position.y = -map.rows / 2.0 * map_msg.info.resolution;
-  map_msg.info.origin.position.z = 0;
-  map_msg.info.origin.orientation.x = 0;
-  map_msg.info.origin.orientation.y = 0;
-  map_msg.info.origin.orientation.z = 0;
-  map_msg.info.origin.orientation.w = 1;
-  map_msg.data.resize(map.rows * map.cols);
-  for (int i = 0; i < map.rows; i++) {
-    for (int j = 0; j < map.cols; j++) {
-      map_msg.data[i * map.cols + j] = 100 - map.at<uchar>(i, j);
+const nav_msgs::msg::OccupancyGrid &Map::get_map_msg(const std::string &frame_id, int threshold) {
+  if (!map_msg_.data.empty() && map_msg_.header.frame_id == frame_id) {
+    return map_msg_;
+  }
+  // The message shows the full resolution level without its border
+  const cv::Mat &likelihood = levels_[0].likelihood;
+  int width = likelihood.cols - 2 * BORDER;
+  int height = likelihood.rows - 2 * BORDER;
+  map_msg_.header.frame_id = frame_id;
+  map_msg_.info.resolution = 0.01;
+  map_msg_.info.width = width;
+  map_msg_.info.height = height;
+  map_msg_.info.origin.position.x = -width / 2.0 * map_msg_.info.resolution;
+  map_msg_.info.origin.position.y = -height / 2.0 * map_msg_.info.resolution;
+  map_msg_.info.origin.position.z = 0;
+  map_msg_.info.origin.orientation.x = 0;
+  map_msg_.info.origin.orientation.y = 0;
+  map_msg_.info.origin.orientation.z = 0;
+  map_msg_.info.origin.orientation.w = 1;
+  map_msg_.data.resize(width * height);
+  for (int i = 0; i < height; i++) {
+    const float *row = likelihood.ptr<float>(i + BORDER) + BORDER;
+    for (int j = 0; j < width; j++) {
+      map_msg_.data[i * width + j] = static_cast<int8_t>(std::lround(row[j] * 100));
     }
   }
-  return map_msg;
+  return map_msg_;
 }
 }  // namespace bitbots_localization
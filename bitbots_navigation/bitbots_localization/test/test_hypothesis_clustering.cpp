@@ -0,0 +1,134 @@
+#include <gtest/gtest.h>
+
+#include <bitbots_localization/HypothesisClustering.hpp>
+#include <cmath>
+
+using namespace bitbots_localization;
+
+namespace {
+
+class HypothesisClusteringTest : public ::testing::Test {
+ protected:
+  HypothesisClusteringTest() : clustering_(0.5, 0.5, 0.5, 10) {}
+
+  void addParticle(double x, double y, double theta, double weight, bool explorer = false) {
+    particles_.x.push_back(x);
+    particles_.y.push_back(y);
+    particles_.sin_theta.push_back(std::sin(theta));
+    particles_.cos_theta.push_back(std::cos(theta));
+    particles_.weight.push_back(weight);
+    particles_.explorer.push_back(explorer);
+  }
+
+  // Adds the given number of particles on a small circle around the given pose
+  void addCluster(double x, double y, double theta, double weight, size_t count) {
+    for (size_t i = 0; i < count; i++) {
+      double angle = 2 * M_PI * i / count;
+      addParticle(x + 0.05 * std::cos(angle), y + 0.05 * std::sin(angle), theta, weight);
+    }
+  }
+
+  HypothesisClustering clustering_;
+  ParticleArrays particles_;
+};
+
+TEST_F(HypothesisClusteringTest, NoParticles) {
+  EXPECT_TRUE(clustering_.update(particles_, true).empty());
+  EXPECT_TRUE(clustering_.hypotheses().empty());
+}
+
+TEST_F(HypothesisClusteringTest, SeparatedClustersSortedByWeight) {
+  addCluster(1.0, 1.0, 0.0, 1.0, 10);
+  addCluster(-2.0, -2.0, M_PI / 2, 3.0, 10);
+
+  const auto &hypotheses = clustering_.update(particles_, true);
+  ASSERT_EQ(hypotheses.size(), 2u);
+  EXPECT_NEAR(hypotheses[0].weight, 0.75, 1e-9);
+  EXPECT_NEAR(hypotheses[1].weight, 0.25, 1e-9);
+
+  EXPECT_NEAR(hypotheses[0].mean.getXPos(), -2.0, 1e-9);
+  EXPECT_NEAR(hypotheses[0].mean.getYPos(), -2.0, 1e-9);
+  EXPECT_NEAR(hypotheses[0].mean.getTheta(), M_PI / 2, 1e-9);
+  EXPECT_NEAR(hypotheses[1].mean.getXPos(), 1.0, 1e-9);
+  EXPECT_NEAR(hypotheses[1].mean.getYPos(), 1.0, 1e-9);
+  EXPECT_NEAR(hypotheses[1].mean.getTheta(), 0.0, 1e-9);
+  EXPECT_EQ(&hypotheses, &clustering_.hypotheses());
+}
+
+TEST_F(HypothesisClusteringTest, NeighboringCellsAreMerged) {
+  // The particles are spread over several adjacent cells
+  for (int i = 0; i < 10; i++) {
+    addParticle(0.2 * i, 0.0, 0.0, 1.0);
+  }
+
+  const auto &hypotheses = clustering_.update(particles_, true);
+  ASSERT_EQ(hypotheses.size(), 1u);
+  EXPECT_NEAR(hypotheses[0].weight, 1.0, 1e-9);
+  EXPECT_NEAR(hypotheses[0].mean.getXPos(), 0.9, 1e-9);
+}
+
+TEST_F(HypothesisClusteringTest, LimitedToMaximumHypotheses) {
+  HypothesisClustering clustering(0.5, 0.5, 0.5, 2);
+  addCluster(0.0, 0.0, 0.0, 1.0, 5);
+  addCluster(3.0, 0.0, 0.0, 2.0, 5);
+  addCluster(0.0, 3.0, 0.0, 3.0, 5);
+
+  const auto &hypotheses = clustering.update(particles_, true);
+  ASSERT_EQ(hypotheses.size(), 2u);
+  // The weights stay relative to all particles
+  EXPECT_NEAR(hypotheses[0].weight, 0.5, 1e-9);
+  EXPECT_NEAR(hypotheses[1].weight, 1.0 / 3.0, 1e-9);
+  EXPECT_NEAR(hypotheses[0].mean.getYPos(), 3.0, 1e-9);
+  EXPECT_NEAR(hypotheses[1].mean.getXPos(), 3.0, 1e-9);
+}
+
+TEST_F(HypothesisClusteringTest, IgnoresExplorers) {
+  addCluster(1.0, 1.0, 0.0, 1.0, 10);
+  addParticle(-3.0, -3.0, 0.0, 10.0, true);
+
+  const auto &with_explorers = clustering_.update(particles_, false);
+  ASSERT_EQ(with_explorers.size(), 2u);
+  EXPECT_NEAR(with_explorers[0].weight, 0.5, 1e-9);
+
+  const auto &without_explorers = clustering_.update(particles_, true);
+  ASSERT_EQ(without_explorers.size(), 1u);
+  EXPECT_NEAR(without_explorers[0].weight, 1.0, 1e-9);
+  EXPECT_NEAR(without_explorers[0].mean.getXPos(), 1.0, 1e-9);
+}
+
+TEST_F(HypothesisClusteringTest, ThetaWrapsAround) {
+  addParticle(0.0, 0.0, M_PI - 0.05, 1.0);
+  addParticle(0.0, 0.0, -M_PI + 0.05, 1.0);
+
+  const auto &hypotheses = clustering_.update(particles_, true);
+  ASSERT_EQ(hypotheses.size(), 1u);
+  EXPECT_NEAR(std::abs(hypotheses[0].mean.getTheta()), M_PI, 1e-9);
+}
+
+TEST_F(HypothesisClusteringTest, Covariance) {
+  addParticle(0.9, 0.0, 0.1, 1.0);
+  addParticle(1.1, 0.0, -0.1, 1.0);
+  addParticle(1.0, 0.2, 0.0, 2.0);
+  addParticle(1.0, -0.2, 0.0, 2.0);
+
+  const auto &hypotheses = clustering_.update(particles_, true);
+  ASSERT_EQ(hypotheses.size(), 1u);
+  const auto &covariance = hypotheses[0].covariance;
+  EXPECT_NEAR(hypotheses[0].mean.getXPos(), 1.0, 1e-9);
+  EXPECT_NEAR(hypotheses[0].mean.getYPos(), 0.0, 1e-9);
+  EXPECT_NEAR(hypotheses[0].mean.getTheta(), 0.0, 1e-9);
+  EXPECT_NEAR(covariance[0], 2 * 0.01 / 6, 1e-9);
+  EXPECT_NEAR(covariance[7], 4 * 0.04 / 6, 1e-9);
+  EXPECT_NEAR(covariance[1], 0.0, 1e-9);
+  EXPECT_EQ(covariance[1], covariance[6]);
+  // x and theta are anticorrelated, the orientation is linearized with sin(theta - mean)
+  EXPECT_NEAR(covariance[5], -2 * 0.1 * std::sin(0.1) / 6, 1e-9);
+  EXPECT_EQ(covariance[5], covariance[30]);
+  EXPECT_NEAR(covariance[35], 2 * std::sin(0.1) * std::sin(0.1) / 6, 1e-9);
+  // z, roll and pitch are not estimated
+  EXPECT_EQ(covariance[14], 0.0);
+  EXPECT_EQ(covariance[21], 0.0);
+  EXPECT_EQ(covariance[28], 0.0);
+}
+
+}  // namespace
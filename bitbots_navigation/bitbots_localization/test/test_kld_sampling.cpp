@@ -0,0 +1,121 @@
+#include <gtest/gtest.h>
+
+#include <algorithm>
+#include <bitbots_localization/KLDSampling.hpp>
+#include <cmath>
+#include <vector>
+
+using namespace bitbots_localization;
+
+namespace {
+using Particle = particle_filter::Particle<RobotState>;
+
+constexpr double EPSILON = 0.05;
+constexpr double Z_QUANTILE = 2.326;
+constexpr size_t MIN_PARTICLES = 10;
+constexpr size_t MAX_PARTICLES = 5000;
+
+// Expected particle count for the given number of occupied bins (Fox, 2003)
+double expectedCount(size_t bins) {
+  double k = bins - 1;
+  double a = 2.0 / (9.0 * k);
+  return std::ceil(k / (2.0 * EPSILON) * std::pow(1.0 - a + std::sqrt(a) * Z_QUANTILE, 3));
+}
+
+class KLDSamplingTest : public ::testing::Test {
+ protected:
+  KLDSamplingTest() : kld_(0.1, 0.1, 0.2, EPSILON, Z_QUANTILE, MIN_PARTICLES, MAX_PARTICLES) {}
+
+  // Adds the given number of particles in each of the given number of bins along the x axis
+  void addParticles(size_t bins, size_t per_bin) {
+    for (size_t bin = 0; bin < bins; bin++) {
+      for (size_t i = 0; i < per_bin; i++) {
+        particles_.emplace_back(RobotState(bin * 0.1 + 0.05, 0.05 + 0.01 * i / per_bin, 0.1), 1.0);
+      }
+    }
+  }
+
+  size_t requiredParticles() {
+    std::vector<Particle *> pointers;
+    for (Particle &particle : particles_) {
+      pointers.push_back(&particle);
+    }
+    return kld_.required_particles(pointers);
+  }
+
+  KLDSampling kld_;
+  std::vector<Particle> particles_;
+};
+}  // namespace
+
+TEST_F(KLDSamplingTest, NoParticles) { EXPECT_EQ(requiredParticles(), MIN_PARTICLES); }
+
+TEST_F(KLDSamplingTest, SingleBin) {
+  addParticles(1, 100);
+  EXPECT_EQ(requiredParticles(), MIN_PARTICLES);
+}
+
+TEST_F(KLDSamplingTest, FollowsTheBound) {
+  for (size_t bins : {2, 10, 50, 200}) {
+    particles_.clear();
+    addParticles(bins, 3);
+    EXPECT_EQ(requiredParticles(), static_cast<size_t>(std::clamp<double>(expectedCount(bins), MIN_PARTICLES,
+                                                                          MAX_PARTICLES)))
+        << bins << " bins";
+  }
+}
+
+TEST_F(KLDSamplingTest, GrowsWithTheOccupiedBins) {
+  size_t previous = 0;
+  for (size_t bins = 2; bins < 100; bins += 7) {
+    particles_.clear();
+    addParticles(bins, 1);
+    size_t required = requiredParticles();
+    EXPECT_GE(required, previous) << bins << " bins";
+    previous = required;
+  }
+}
+
+TEST_F(KLDSamplingTest, IndependentOfParticlesPerBin) {
+  addParticles(20, 1);
+  size_t required = requiredParticles();
+  particles_.clear();
+  addParticles(20, 10);
+  EXPECT_EQ(requiredParticles(), required);
+}
+
+TEST_F(KLDSamplingTest, ClampedToMaximum) {
+  addParticles(2000, 1);
+  EXPECT_EQ(requiredParticles(), MAX_PARTICLES);
+}
+
+TEST_F(KLDSamplingTest, ParametersCanBeChanged) {
+  addParticles(50, 1);
+  kld_.set_parameters(0.1, 0.1, 0.2, EPSILON, Z_QUANTILE, MIN_PARTICLES, 100);
+  EXPECT_EQ(requiredParticles(), 100u);
+  // Larger bins hold all particles
+  kld_.set_parameters(10.0, 10.0, 0.2, EPSILON, Z_QUANTILE, MIN_PARTICLES, MAX_PARTICLES);
+  EXPECT_EQ(requiredParticles(), MIN_PARTICLES);
+}
+
+TEST_F(KLDSamplingTest, BinsInAllDimensions) {
+  // Negative coordinates and the theta axis separate the bins as well
+  particles_.emplace_back(RobotState(-0.05, 0.05, 0.1), 1.0);
+  particles_.emplace_back(RobotState(0.05, 0.05, 0.1), 1.0);
+  particles_.emplace_back(RobotState(0.05, -0.05, 0.1), 1.0);
+  particles_.emplace_back(RobotState(0.05, 0.05, -0.1), 1.0);
+  EXPECT_EQ(requiredParticles(), static_cast<size_t>(std::max<double>(expectedCount(4), MIN_PARTICLES)));
+}
+
+TEST(KLDSampling, MaximumBelowMinimum) {
+  KLDSampling kld(0.1, 0.1, 0.2, EPSILON, Z_QUANTILE, 100, 50);
+  std::vector<Particle> particles;
+  for (int i = 0; i < 1000; i++) {
+    particles.emplace_back(RobotState(i * 0.1, 0, 0), 1.0);
+  }
+  std::vector<Particle *> pointers;
+  for (Particle &particle : particles) {
+    pointers.push_back(&particle);
+  }
+  EXPECT_EQ(kld.required_particles(pointers), 100u);
+}
@@ -0,0 +1,164 @@
+#include <gtest/gtest.h>
+
+#include <bitbots_localization/OdometryBuffer.hpp>
+#include <cmath>
+#include <thread>
+
+using namespace bitbots_localization;
+
+namespace {
+OdometryPose pose(int64_t stamp, double x, double y, double theta) {
+  OdometryPose pose;
+  pose.stamp = stamp;
+  pose.x = x;
+  pose.y = y;
+  pose.theta = theta;
+  return pose;
+}
+
+constexpr int64_t SECOND = 1000000000;
+}  // namespace
+
+TEST(OdometryBuffer, Empty) {
+  OdometryBuffer buffer(8, 1.0);
+  EXPECT_FALSE(buffer.latest().has_value());
+  EXPECT_FALSE(buffer.pose_at(0).has_value());
+}
+
+TEST(OdometryBuffer, Latest) {
+  OdometryBuffer buffer(8, 1.0);
+  ASSERT_TRUE(buffer.push(pose(100, 1.0, 2.0, 0.5)));
+  ASSERT_TRUE(buffer.push(pose(200, 2.0, 3.0, 0.6)));
+  auto latest = buffer.latest();
+  ASSERT_TRUE(latest.has_value());
+  EXPECT_EQ(latest->stamp, 200);
+  EXPECT_DOUBLE_EQ(latest->x, 2.0);
+  EXPECT_DOUBLE_EQ(latest->y, 3.0);
+  EXPECT_DOUBLE_EQ(latest->theta, 0.6);
+}
+
+TEST(OdometryBuffer, Interpolation) {
+  OdometryBuffer buffer(8, 1.0);
+  buffer.push(pose(0, 0.0, 0.0, 0.0));
+  buffer.push(pose(100, 1.0, -2.0, 0.4));
+  buffer.push(pose(300, 3.0, -2.0, 0.0));
+
+  auto interpolated = buffer.pose_at(50);
+  ASSERT_TRUE(interpolated.has_value());
+  EXPECT_EQ(interpolated->stamp, 50);
+  EXPECT_DOUBLE_EQ(interpolated->x, 0.5);
+  EXPECT_DOUBLE_EQ(interpolated->y, -1.0);
+  EXPECT_DOUBLE_EQ(interpolated->theta, 0.2);
+
+  interpolated = buffer.pose_at(250);
+  EXPECT_DOUBLE_EQ(interpolated->x, 2.5);
+  EXPECT_DOUBLE_EQ(interpolated->y, -2.0);
+  EXPECT_NEAR(interpolated->theta, 0.1, 1e-12);
+
+  // Exact stamps return the buffered pose
+  interpolated = buffer.pose_at(100);
+  EXPECT_DOUBLE_EQ(interpolated->x, 1.0);
+  EXPECT_DOUBLE_EQ(interpolated->theta, 0.4);
+}
+
+TEST(OdometryBuffer, InterpolationWrapsTheta) {
+  OdometryBuffer buffer(8, 1.0);
+  buffer.push(pose(0, 0.0, 0.0, M_PI - 0.1));
+  buffer.push(pose(100, 0.0, 0.0, -M_PI + 0.1));
+  // The shortest rotation passes pi instead of zero
+  auto interpolated = buffer.pose_at(50);
+  ASSERT_TRUE(interpolated.has_value());
+  EXPECT_NEAR(std::remainder(interpolated->theta - M_PI, 2 * M_PI), 0.0, 1e-12);
+}
+
+TEST(OdometryBuffer, ClampsOutsideOfHistory) {
+  OdometryBuffer buffer(8, 1.0);
+  buffer.push(pose(100, 1.0, 0.0, 0.0));
+  buffer.push(pose(200, 2.0, 0.0, 0.0));
+  EXPECT_DOUBLE_EQ(buffer.pose_at(0)->x, 1.0);
+  EXPECT_EQ(buffer.pose_at(0)->stamp, 100);
+  EXPECT_DOUBLE_EQ(buffer.pose_at(1000)->x, 2.0);
+  EXPECT_EQ(buffer.pose_at(1000)->stamp, 200);
+}
+
+TEST(OdometryBuffer, IgnoresOutOfOrderPoses) {
+  OdometryBuffer buffer(8, 1.0);
+  buffer.push(pose(200, 2.0, 0.0, 0.0));
+  buffer.push(pose(100, 1.0, 0.0, 0.0));
+  buffer.push(pose(200, 3.0, 0.0, 0.0));
+  auto latest = buffer.latest();
+  EXPECT_EQ(latest->stamp, 200);
+  EXPECT_DOUBLE_EQ(latest->x, 2.0);
+  EXPECT_DOUBLE_EQ(buffer.pose_at(0)->x, 2.0);
+}
+
+TEST(OdometryBuffer, Overflow) {
+  // The capacity is rounded up to a power of two
+  OdometryBuffer buffer(3, 1.0);
+  for (int i = 0; i < 4; i++) {
+    EXPECT_TRUE(buffer.push(pose(i + 1, i, 0.0, 0.0))) << i;
+  }
+  EXPECT_FALSE(buffer.push(pose(5, 4.0, 0.0, 0.0)));
+
+  // The dropped pose is lost, the ring buffer accepts new poses after the consumer drained it
+  auto latest = buffer.latest();
+  EXPECT_EQ(latest->stamp, 4);
+  EXPECT_TRUE(buffer.push(pose(6, 5.0, 0.0, 0.0)));
+  EXPECT_EQ(buffer.latest()->stamp, 6);
+  EXPECT_DOUBLE_EQ(buffer.pose_at(5)->x, 4.0);
+}
+
+TEST(OdometryBuffer, RemovesOldPoses) {
+  OdometryBuffer buffer(8, 1.0);
+  buffer.push(pose(0, 0.0, 0.0, 0.0));
+  buffer.push(pose(SECOND, 1.0, 0.0, 0.0));
+  buffer.push(pose(2 * SECOND, 2.0, 0.0, 0.0));
+  ASSERT_TRUE(buffer.latest().has_value());
+  // Only the last second is kept, so older stamps are clamped to the oldest kept pose
+  EXPECT_EQ(buffer.pose_at(SECOND / 2)->stamp, SECOND);
+  EXPECT_DOUBLE_EQ(buffer.pose_at(SECOND / 2)->x, 1.0);
+}
+
+TEST(OdometryBuffer, KeepsNewestPose) {
+  OdometryBuffer buffer(8, 1.0);
+  buffer.push(pose(0, 1.0, 0.0, 0.0));
+  buffer.push(pose(10 * SECOND, 2.0, 0.0, 0.0));
+  EXPECT_EQ(buffer.latest()->stamp, 10 * SECOND);
+  EXPECT_DOUBLE_EQ(buffer.pose_at(0)->x, 2.0);
+}
+
+TEST(OdometryBuffer, Clear) {
+  OdometryBuffer buffer(8, 1.0);
+  buffer.push(pose(100, 1.0, 0.0, 0.0));
+  buffer.clear();
+  EXPECT_FALSE(buffer.latest().has_value());
+  buffer.push(pose(200, 2.0, 0.0, 0.0));
+  EXPECT_EQ(buffer.latest()->stamp, 200);
+}
+
+TEST(OdometryBuffer, ConcurrentProducer) {
+  const int count = 10000;
+  OdometryBuffer buffer(64, 1000.0);
+  std::thread producer([&buffer]() {
+    for (int i = 1; i <= count; i++) {
+      while (!buffer.push(pose(i, i, 0.0, 0.0))) {
+        std::this_thread::yield();
+      }
+    }
+  });
+  int64_t last_stamp = 0;
+  while (last_stamp < count) {
+    auto latest = buffer.latest();
+    if (latest) {
+      ASSERT_GE(latest->stamp, last_stamp);
+      ASSERT_DOUBLE_EQ(latest->x, static_cast<double>(latest->stamp));
+      last_stamp = latest->stamp;
+    }
+    std::this_thread::yield();
+  }
+  producer.join();
+  // No pose was lost
+  for (int64_t stamp : {int64_t(1), int64_t(count / 2), int64_t(count)}) {
+    EXPECT_DOUBLE_EQ(buffer.pose_at(stamp)->x, static_cast<double>(stamp));
+  }
+}
@@ -0,0 +1,136 @@
+#include <gtest/gtest.h>
+
+#include <bitbots_localization/Resampling.hpp>
+#include <memory>
+#include <vector>
+
+using namespace bitbots_localization;
+
+namespace {
+using Particle = particle_filter::Particle<RobotState>;
+
+// Always draws the same state, so the explorers can be recognized
+class FixedDistribution : public particle_filter::StateDistribution<RobotState> {
+ public:
+  const RobotState draw() const override { return RobotState(-10.0, -10.0, 0.0); }
+};
+
+class ResamplingTest : public ::testing::Test {
+ protected:
+  // Adds a source particle at the given x position and a destination particle
+  void addParticle(double x, double weight, bool explorer = false) {
+    source_.emplace_back(RobotState(x, 0.0, 0.0), weight);
+    source_.back().is_explorer_ = explorer;
+    destination_.emplace_back();
+  }
+
+  void resample(int explorer_count, bool reset_weights, double reset_weight = 0.0) {
+    ImportanceResamplingWE<RobotState> resampling(explorer_count, std::make_shared<FixedDistribution>(),
+                                                  reset_weights, reset_weight);
+    std::vector<Particle *> source, destination;
+    for (size_t i = 0; i < source_.size(); i++) {
+      source.push_back(&source_[i]);
+      destination.push_back(&destination_[i]);
+    }
+    resampling.resample(source, destination);
+  }
+
+  size_t countExplorers() const {
+    size_t count = 0;
+    for (const Particle &particle : destination_) {
+      if (particle.is_explorer_) {
+        EXPECT_DOUBLE_EQ(particle.getState().getXPos(), -10.0);
+        count++;
+      }
+    }
+    return count;
+  }
+
+  std::vector<Particle> source_;
+  std::vector<Particle> destination_;
+};
+}  // namespace
+
+TEST_F(ResamplingTest, KeepsParticleCount) {
+  for (int i = 0; i < 100; i++) {
+    addParticle(i, 1.0);
+  }
+  resample(10, true, 0.01);
+
+  ASSERT_EQ(destination_.size(), 100u);
+  EXPECT_EQ(countExplorers(), 10u);
+  for (size_t i = 0; i < 90; i++) {
+    EXPECT_FALSE(destination_[i].is_explorer_);
+  }
+}
+
+TEST_F(ResamplingTest, ResetsWeights) {
+  for (int i = 0; i < 20; i++) {
+    addParticle(i, i + 1.0);
+  }
+  resample(5, true, 0.01);
+
+  for (const Particle &particle : destination_) {
+    EXPECT_DOUBLE_EQ(particle.getWeight(), 0.01);
+  }
+}
+
+TEST_F(ResamplingTest, KeepsWeightsWithoutReset) {
+  addParticle(1.0, 0.25);
+  addParticle(2.0, 0.75);
+  resample(0, false);
+
+  for (const Particle &particle : destination_) {
+    EXPECT_DOUBLE_EQ(particle.getWeight(), particle.getState().getXPos() == 1.0 ? 0.25 : 0.75);
+  }
+}
+
+TEST_F(ResamplingTest, DrawsProportionalToWeight) {
+  addParticle(1.0, 0.0);
+  addParticle(2.0, 1.0);
+  addParticle(3.0, 3.0);
+  for (int i = 0; i < 5; i++) {
+    addParticle(4.0, 0.0);
+  }
+  resample(0, true, 1.0);
+
+  // The systematic sampler draws exactly 2 of the 8 particles from the second one and 6 from the third one
+  size_t second = 0, third = 0;
+  for (const Particle &particle : destination_) {
+    second += particle.getState().getXPos() == 2.0;
+    third += particle.getState().getXPos() == 3.0;
+  }
+  EXPECT_EQ(second, 2u);
+  EXPECT_EQ(third, 6u);
+  EXPECT_EQ(countExplorers(), 0u);
+}
+
+TEST_F(ResamplingTest, ClearsExplorerFlagOfResampledParticles) {
+  // The only particle with weight is an explorer of the previous step
+  addParticle(1.0, 0.0);
+  addParticle(2.0, 1.0, true);
+  addParticle(3.0, 0.0);
+  resample(1, true, 1.0);
+
+  EXPECT_FALSE(destination_[0].is_explorer_);
+  EXPECT_FALSE(destination_[1].is_explorer_);
+  EXPECT_DOUBLE_EQ(destination_[0].getState().getXPos(), 2.0);
+  EXPECT_DOUBLE_EQ(destination_[1].getState().getXPos(), 2.0);
+  EXPECT_EQ(countExplorers(), 1u);
+}
+
+TEST_F(ResamplingTest, MoreExplorersThanParticles) {
+  for (int i = 0; i < 5; i++) {
+    addParticle(i, 1.0);
+  }
+  resample(10, true, 0.5);
+
+  EXPECT_EQ(countExplorers(), 5u);
+}
+
+TEST_F(ResamplingTest, ExplorerCountCanBeChanged) {
+  ImportanceResamplingWE<RobotState> resampling(3, std::make_shared<FixedDistribution>(), true, 0.0);
+  EXPECT_EQ(resampling.getExplorerCount(), 3);
+  resampling.setExplorerCount(7);
+  EXPECT_EQ(resampling.getExplorerCount(), 7);
+}